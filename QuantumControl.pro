@@ -1,4 +1,4 @@
-QT       += core gui serialport
+QT       += core gui serialport network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -14,26 +14,78 @@ DEFINES += _CRT_SECURE_NO_WARNINGS
 
 linux-g++:			QMAKE_LFLAGS += -no-pie
 
+# Memory use, for QUANTUM_STARTUP_STATS (quantumprocess.cpp)
+win32:              LIBS += -lpsapi
+
+# shm_open, for QUANTUM_SHM_NAME (quantumshm.h). Part of libc on newer glibc.
+unix:!macx:         LIBS += -lrt
+
 
 SOURCES += \
     dlgabout.cpp \
+    dlgdiagnostics.cpp \
+    dlghistory.cpp \
+    historychart.cpp \
     main.cpp \
     mainwindow.cpp \
+    quantumalpaca.cpp \
+    quantumcommand.cpp \
+    quantumcommandqueue.cpp \
     quantumdevice.cpp \
+    quantumdevicemanager.cpp \
+    quantumdrift.cpp \
+    quantumframer.cpp \
+    quantuminfocache.cpp \
+    quantumlod.cpp \
+    quantummetrics.cpp \
+    quantumparser.cpp \
+    quantumpollscheduler.cpp \
+    quantumprocess.cpp \
+    quantumpushserver.cpp \
+    quantumprobe.cpp \
+    quantumrecorder.cpp \
+    quantumshmwriter.cpp \
+    quantumtrace.cpp \
     quantumgui.cpp \
     serialchooser.cpp \
     wavelengthgraph.cpp
 
 HEADERS += \
     dlgabout.h \
+    dlgdiagnostics.h \
+    dlghistory.h \
+    historychart.h \
     mainwindow.h \
+    quantumalpaca.h \
+    quantumcommand.h \
+    quantumcommandqueue.h \
     quantumdevice.h \
+    quantumdevicemanager.h \
+    quantumdrift.h \
+    quantumframer.h \
+    quantuminfocache.h \
+    quantumlod.h \
+    quantummetrics.h \
+    quantumparser.h \
+    quantumpollscheduler.h \
+    quantumprocess.h \
+    quantumpush.h \
+    quantumpushserver.h \
+    quantumprobe.h \
+    quantumrecorder.h \
+    quantumseqlock.h \
+    quantumshm.h \
+    quantumshmwriter.h \
+    quantumstatus.h \
+    quantumtrace.h \
     quantumgui.h \
     serialchooser.h \
     wavelengthgraph.h
 
 FORMS += \
     dlgabout.ui \
+    dlgdiagnostics.ui \
+    dlghistory.ui \
     mainwindow.ui \
     quantumgui.ui \
     serialchooser.ui
@@ -0,0 +1,216 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* Archive tool, for the history Quantum Control keeps (see quantumarchive.h).
+ *
+ * usage:
+ *   quantumarc export <history.qsr> <archive.qsa>
+ *          Everything in the history ring goes into a new archive. The ring can be
+ *          live, Quantum Control doesn't have to be closed.
+ *   quantumarc info <archive.qsa>
+ *          Samples, time span, and each column's mean, min and max
+ *   quantumarc query <archive.qsa> <field> [--from <time>] [--to <time>] [--bucket <seconds>]
+ *          One field over a span of time, as CSV: time, samples, mean, min, max. Times
+ *          are local, 2026-10-17T10:00 or just 10:00 for that time on the last day in
+ *          the archive. No bucket gives every sample.
+ *
+ *   quantumarc query day.qsa heater1Temperature --from 10:00 --to 14:00 --bucket 60
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <QDateTime>
+#include <QString>
+
+#include "quantumarchive.h"
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: quantumarc export <history.qsr> <archive.qsa>\n"
+                    "       quantumarc info <archive.qsa>\n"
+                    "       quantumarc query <archive.qsa> <field> [--from <time>] [--to <time>] [--bucket <seconds>]\n"
+                    "fields:");
+    for(int i = 1; i < QARC_COLUMN_COUNT; i++)
+        fprintf(stderr, " %s", quantumArchiveColumns[i].szName);
+    fprintf(stderr, "\n");
+}
+
+///////////////////////////////////////////////////////////////////////
+// A full date and time, or a time of day on the same day as nDay. -1 if it's neither.
+static int64_t parseTime(const char* szTime, int64_t nDay)
+{
+    QString qsTime(szTime);
+    QDateTime when = QDateTime::fromString(qsTime, Qt::ISODate);
+    if(when.isValid())
+        return when.toMSecsSinceEpoch();
+
+    QTime timeOfDay = QTime::fromString(qsTime, "H:mm");
+    if(!timeOfDay.isValid())
+        timeOfDay = QTime::fromString(qsTime, "H:mm:ss");
+    if(!timeOfDay.isValid())
+        return -1;
+
+    QDate day = QDateTime::fromMSecsSinceEpoch(nDay).date();
+    return QDateTime(day, timeOfDay).toMSecsSinceEpoch();
+}
+
+///////////////////////////////////////////////////////////////////////
+static int exportHistory(const char* szHistory, const char* szArchive)
+{
+    QuantumRecorder recorder;
+    if(!recorder.openReadOnly(QString(szHistory))) {
+        fprintf(stderr, "Not a history file: %s\n", szHistory);
+        return 1;
+        }
+
+    QuantumArchiveWriter writer;
+    if(!writer.open(QString(szArchive))) {
+        fprintf(stderr, "Can't write %s\n", szArchive);
+        return 1;
+        }
+
+    quantumArchiveFromRecorder(recorder, &writer);
+    uint64_t nSamples = writer.getSampleCount();
+    if(!writer.close()) {
+        fprintf(stderr, "Error writing %s\n", szArchive);
+        return 1;
+        }
+
+    fprintf(stderr, "%llu samples\n", (unsigned long long)nSamples);
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////
+static int showInfo(const char* szArchive)
+{
+    QuantumArchiveReader reader;
+    if(!reader.open(QString(szArchive))) {
+        fprintf(stderr, "Not an archive: %s\n", szArchive);
+        return 1;
+        }
+
+    uint64_t nSamples = reader.getSampleCount();
+    printf("%llu samples in %d chunks\n", (unsigned long long)nSamples, reader.getChunkCount());
+    if(nSamples == 0)
+        return 0;
+
+    printf("%s to %s\n",
+           qPrintable(QDateTime::fromMSecsSinceEpoch(reader.getFirstTime()).toString(Qt::ISODate)),
+           qPrintable(QDateTime::fromMSecsSinceEpoch(reader.getLastTime()).toString(Qt::ISODate)));
+
+    // Whole span as one bucket, which the index answers on its own
+    QVector<QuantumArchiveBucket> buckets;
+    for(int c = 1; c < QARC_COLUMN_COUNT; c++)
+        if(reader.query(c, reader.getFirstTime(), reader.getLastTime() + 1,
+                        reader.getLastTime() - reader.getFirstTime() + 1, &buckets) && !buckets.isEmpty())
+            printf("%-20s mean %10.2f  min %10.2f  max %10.2f\n", quantumArchiveColumns[c].szName,
+                   buckets[0].mean, buckets[0].min, buckets[0].max);
+
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////
+static int runQuery(int argc, char *argv[])
+{
+    if(argc < 4) {
+        usage();
+        return 1;
+        }
+
+    int nColumn = quantumArchiveFindColumn(argv[3]);
+    if(nColumn <= 0) {
+        fprintf(stderr, "No field called %s\n", argv[3]);
+        usage();
+        return 1;
+        }
+
+    QuantumArchiveReader reader;
+    if(!reader.open(QString(argv[2]))) {
+        fprintf(stderr, "Not an archive: %s\n", argv[2]);
+        return 1;
+        }
+
+    int64_t nFrom = reader.getFirstTime();
+    int64_t nTo = reader.getLastTime() + 1;
+    int64_t nBucket = 0;
+
+    for(int i = 4; i < argc; i++) {
+        const char* szArg = argv[i];
+        const char* szValue = (i + 1 < argc) ? argv[i+1] : nullptr;
+        if(szValue == nullptr) {
+            fprintf(stderr, "Unknown option, or missing value: %s\n", szArg);
+            return 1;
+            }
+
+        if(strcmp(szArg, "--from") == 0)
+            nFrom = parseTime(szValue, reader.getLastTime());
+        else if(strcmp(szArg, "--to") == 0)
+            nTo = parseTime(szValue, reader.getLastTime());
+        else if(strcmp(szArg, "--bucket") == 0)
+            nBucket = int64_t(atof(szValue) * 1000.0);
+        else {
+            fprintf(stderr, "Unknown option: %s\n", szArg);
+            return 1;
+            }
+
+        if(nFrom < 0 || nTo < 0) {
+            fprintf(stderr, "Can't make sense of the time %s\n", szValue);
+            return 1;
+            }
+        i++;
+        }
+
+    QVector<QuantumArchiveBucket> buckets;
+    if(!reader.query(nColumn, nFrom, nTo, nBucket, &buckets)) {
+        fprintf(stderr, "Error reading %s\n", argv[2]);
+        return 1;
+        }
+
+    printf("time,samples,mean,min,max\n");
+    for(int i = 0; i < buckets.size(); i++)
+        printf("%s,%u,%.3f,%.3f,%.3f\n",
+               qPrintable(QDateTime::fromMSecsSinceEpoch(buckets[i].nStart).toString("yyyy-MM-ddTHH:mm:ss.zzz")),
+               buckets[i].nCount, buckets[i].mean, buckets[i].min, buckets[i].max);
+
+    fprintf(stderr, "%u chunks read, %u from the index, %llu bytes\n", reader.getChunksDecoded(),
+            reader.getChunksFromIndex(), (unsigned long long)reader.getBytesRead());
+    return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+    if(argc >= 4 && strcmp(argv[1], "export") == 0)
+        return exportHistory(argv[2], argv[3]);
+
+    if(argc >= 3 && strcmp(argv[1], "info") == 0)
+        return showInfo(argv[2]);
+
+    if(argc >= 3 && strcmp(argv[1], "query") == 0)
+        return runQuery(argc, argv);
+
+    usage();
+    return 1;
+}
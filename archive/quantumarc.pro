@@ -0,0 +1,20 @@
+# Archive tool. Turns the history ring into a compact archive, and answers questions
+# about it. See quantumarc.cpp for the commands.
+# ./quantumarc query history.qsa heater1Temperature --from 10:00 --to 14:00 --bucket 60
+
+TEMPLATE = app
+QT = core
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    quantumarc.cpp \
+    ../quantumarchive.cpp \
+    ../quantumrecorder.cpp
+
+HEADERS += \
+    ../quantumarchive.h \
+    ../quantumrecorder.h \
+    ../quantumstatus.h
@@ -0,0 +1,271 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* Archive benchmark. Makes up some days of history, writes it as CSV and as an archive,
+ * and times the same question against both: heater 1 temperature from 10:00 to 14:00 on
+ * the last day, in one minute means. Then the whole span in one hour means, which the
+ * archive index mostly answers by itself.
+ *
+ * usage: archivebench [options]
+ *   --days <n>         Days of history (default 30)
+ *   --rate <hz>        Samples a second, while observing (default 1)
+ *   --dir <path>       Where to put the files (default /tmp)
+ *   --keep             Leave the files there afterwards
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <QElapsedTimer>
+#include <QFile>
+
+#include "quantumarchive.h"
+
+#define HOUR_MS     (3600LL * 1000LL)
+#define DAY_MS      (24LL * HOUR_MS)
+
+// Observing runs 08:00 to 18:00 every day
+#define SESSION_START   (8 * HOUR_MS)
+#define SESSION_END     (18 * HOUR_MS)
+
+///////////////////////////////////////////////////////////////////////
+// Something like a real day: the heater warms up, then holds and wanders
+// a little, the supply sags, and the reported values have the device's resolution.
+static void makeSample(int64_t nTime, int64_t nSessionStart, uint32_t* pSeed, QuantumRecord* pRecord)
+{
+    *pSeed = *pSeed * 1664525u + 1013904223u;
+    double noise = double(*pSeed >> 8) / double(1 << 24) - 0.5;
+
+    double minutes = double(nTime - nSessionStart) / 60000.0;
+    double warm = 1.0 - exp(-minutes / 12.0);
+    double temperature = 20.0 + 22.0 * warm + 0.3 * sin(minutes / 37.0) + 0.05 * noise;
+
+    memset(pRecord, 0, sizeof(QuantumRecord));
+    pRecord->nWallTime = nTime;
+    pRecord->nCaptureTime = (nTime - nSessionStart) * 1000000LL;
+    pRecord->centerWavelength = float(floor((6562.8 - 0.6 * (1.0 - warm)) * 10.0 + 0.5) / 10.0);
+    pRecord->wingShift = 0.0f;
+    pRecord->heater1Temperature = float(floor(temperature * 100.0 + 0.5) / 100.0);
+    pRecord->heater1PWM = float(floor((85.0 * (1.0 - warm) + 30.0 + 5.0 * noise) * 100.0 + 0.5) / 100.0);
+    pRecord->inputVoltage = float(floor((12.1 - 0.002 * minutes / 60.0 + 0.02 * noise) * 100.0 + 0.5) / 100.0);
+    pRecord->nHeater1PWMLimit = 1023;
+    pRecord->nFlags = (warm > 0.98) ? QUANTUM_RECORD_ON_BAND : 0;
+}
+
+///////////////////////////////////////////////////////////////////////
+// The CSV way: read every line, keep the ones in range. Same buckets as the
+// archive query, so the answers can be checked against each other.
+static bool scanCsv(const char* szFile, int64_t nFrom, int64_t nTo, int64_t nBucket, QVector<QuantumArchiveBucket>* pBuckets)
+{
+    pBuckets->clear();
+
+    FILE* pFile = fopen(szFile, "r");
+    if(pFile == nullptr)
+        return false;
+
+    char szLine[512];
+    if(fgets(szLine, sizeof(szLine), pFile) == nullptr) {     // Header
+        fclose(pFile);
+        return false;
+        }
+
+    while(fgets(szLine, sizeof(szLine), pFile) != nullptr) {
+        char* pEnd;
+        int64_t nTime = strtoll(szLine, &pEnd, 10);
+        if(nTime < nFrom || nTime >= nTo)
+            continue;
+
+        strtod(pEnd + 1, &pEnd);                   // centerWavelength
+        strtod(pEnd + 1, &pEnd);                   // wingShift
+        double temperature = strtod(pEnd + 1, &pEnd);
+
+        int64_t nStart = nFrom + (nTime - nFrom) / nBucket * nBucket;
+        if(pBuckets->isEmpty() || pBuckets->last().nStart != nStart) {
+            QuantumArchiveBucket bucket = { nStart, 0, 0.0, temperature, temperature };
+            pBuckets->append(bucket);
+            }
+
+        QuantumArchiveBucket& bucket = pBuckets->last();
+        bucket.nCount++;
+        bucket.mean += temperature;             // Sum for now
+        if(temperature < bucket.min)
+            bucket.min = temperature;
+        if(temperature > bucket.max)
+            bucket.max = temperature;
+        }
+
+    fclose(pFile);
+
+    for(int i = 0; i < pBuckets->size(); i++)
+        (*pBuckets)[i].mean /= double((*pBuckets)[i].nCount);
+
+    return true;
+}
+
+static qint64 fileSize(const QString& qsFile)
+{
+    QFile file(qsFile);
+    return file.size();
+}
+
+
+int main(int argc, char *argv[])
+{
+    int nDays = 30;
+    double rate = 1.0;
+    const char* szDir = "/tmp";
+    bool bKeep = false;
+
+    for(int i = 1; i < argc; i++) {
+        const char* szArg = argv[i];
+        const char* szValue = (i + 1 < argc) ? argv[i+1] : nullptr;
+
+        if(strcmp(szArg, "--keep") == 0)
+            bKeep = true;
+        else {
+            if(szValue == nullptr) {
+                fprintf(stderr, "Unknown option, or missing value: %s\n", szArg);
+                return 1;
+                }
+
+            if(strcmp(szArg, "--days") == 0)
+                nDays = atoi(szValue);
+            else if(strcmp(szArg, "--rate") == 0)
+                rate = atof(szValue);
+            else if(strcmp(szArg, "--dir") == 0)
+                szDir = szValue;
+            else {
+                fprintf(stderr, "Unknown option: %s\n", szArg);
+                return 1;
+                }
+            i++;
+            }
+        }
+
+    if(nDays < 1 || rate <= 0.0) {
+        fprintf(stderr, "Need at least a day, and a rate above 0\n");
+        return 1;
+        }
+
+    QString qsCsv = QString(szDir) + QString("/archivebench.csv");
+    QString qsArchive = QString(szDir) + QString("/archivebench.qsa");
+    QByteArray csvName = qsCsv.toLocal8Bit();
+
+    FILE* pCsv = fopen(csvName.constData(), "w");
+    QuantumArchiveWriter writer;
+    if(pCsv == nullptr || !writer.open(qsArchive)) {
+        fprintf(stderr, "Can't write to %s\n", szDir);
+        return 1;
+        }
+
+    // Days start at a round number, times are UTC so the answer is the same everywhere
+    int64_t nEpoch = 1767225600000LL;   // 2026-01-01
+    int64_t nStep = int64_t(1000.0 / rate);
+    uint32_t nSeed = 1;
+    uint64_t nSamples = 0;
+    qint64 nCsvTime = 0, nArchiveTime = 0;
+    QElapsedTimer timer;
+
+    fprintf(pCsv, "time,centerWavelength,wingShift,heater1Temperature,heater2Temperature,heater1PWM,"
+                  "heater2PWM,inputVoltage,errorCode,heater1PWMLimit,heater2PWMLimit,calibrationPotPos,flags\n");
+
+    for(int d = 0; d < nDays; d++) {
+        int64_t nSessionStart = nEpoch + d * DAY_MS + SESSION_START;
+        for(int64_t t = nSessionStart; t < nEpoch + d * DAY_MS + SESSION_END; t += nStep) {
+            QuantumRecord record;
+            makeSample(t, nSessionStart, &nSeed, &record);
+
+            timer.start();
+            fprintf(pCsv, "%lld,%.1f,%.1f,%.2f,%.2f,%.2f,%.2f,%.2f,%d,%d,%d,%d,%d\n", (long long)record.nWallTime,
+                    record.centerWavelength, record.wingShift, record.heater1Temperature, record.heater2Temperature,
+                    record.heater1PWM, record.heater2PWM, record.inputVoltage, record.nErrorCode,
+                    record.nHeater1PWMLimit, record.nHeater2PWMLimit, record.nCalibrationPotPos, record.nFlags);
+            nCsvTime += timer.nsecsElapsed();
+
+            timer.start();
+            writer.append(record);
+            nArchiveTime += timer.nsecsElapsed();
+            nSamples++;
+            }
+        }
+
+    fclose(pCsv);
+    timer.start();
+    writer.close();
+    nArchiveTime += timer.nsecsElapsed();
+
+    qint64 nCsvSize = fileSize(qsCsv);
+    qint64 nArchiveSize = fileSize(qsArchive);
+    printf("%d days, %llu samples\n\n", nDays, (unsigned long long)nSamples);
+    printf("%-10s %12s %12s %12s\n", "", "bytes", "per sample", "write ms");
+    printf("%-10s %12lld %12.2f %12.1f\n", "csv", (long long)nCsvSize, double(nCsvSize) / double(nSamples), double(nCsvTime) / 1e6);
+    printf("%-10s %12lld %12.2f %12.1f\n", "archive", (long long)nArchiveSize, double(nArchiveSize) / double(nSamples), double(nArchiveTime) / 1e6);
+    printf("%-10s %11.1fx\n\n", "smaller", double(nCsvSize) / double(nArchiveSize));
+
+    // The questions
+    struct BenchQuery {
+        const char  *szName;
+        int64_t     nFrom;
+        int64_t     nTo;
+        int64_t     nBucket;
+    } queries[] = {
+        { "last day 10:00-14:00, 1 min", nEpoch + (nDays - 1) * DAY_MS + 10 * HOUR_MS, nEpoch + (nDays - 1) * DAY_MS + 14 * HOUR_MS, 60000 },
+        { "everything, 1 hour", nEpoch, nEpoch + nDays * DAY_MS, HOUR_MS },
+    };
+
+    printf("%-30s %9s %12s %12s %16s %12s\n", "heater1Temperature", "buckets", "csv ms", "archive ms", "archive bytes", "mean diff");
+    for(size_t q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+        QVector<QuantumArchiveBucket> csvBuckets;
+        timer.start();
+        scanCsv(csvName.constData(), queries[q].nFrom, queries[q].nTo, queries[q].nBucket, &csvBuckets);
+        double csvMs = double(timer.nsecsElapsed()) / 1e6;
+
+        // Opening is part of it, the index has to come off the disk
+        QuantumArchiveReader reader;
+        QVector<QuantumArchiveBucket> buckets;
+        timer.start();
+        reader.open(qsArchive);
+        reader.query(QARC_HEATER1_TEMPERATURE, queries[q].nFrom, queries[q].nTo, queries[q].nBucket, &buckets);
+        double archiveMs = double(timer.nsecsElapsed()) / 1e6;
+
+        // Both should give the same answer, to the resolution the values were stored at
+        double maxDiff = 0.0;
+        if(buckets.size() != csvBuckets.size())
+            fprintf(stderr, "Bucket count differs: csv %d, archive %d\n", csvBuckets.size(), buckets.size());
+        else
+            for(int i = 0; i < buckets.size(); i++)
+                maxDiff = qMax(maxDiff, fabs(buckets[i].mean - csvBuckets[i].mean));
+
+        printf("%-30s %9d %12.2f %12.2f %16llu %12.4f\n", queries[q].szName, buckets.size(), csvMs, archiveMs,
+               (unsigned long long)reader.getBytesRead(), maxDiff);
+        }
+
+    if(!bKeep) {
+        QFile::remove(qsCsv);
+        QFile::remove(qsArchive);
+        }
+
+    return 0;
+}
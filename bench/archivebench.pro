@@ -0,0 +1,21 @@
+# Archive size and scan speed against plain CSV, on made up history.
+# See archivebench.cpp for the options.
+# ./archivebench --days 30
+
+TEMPLATE = app
+QT = core
+CONFIG += console c++11
+CONFIG -= app_bundle
+CONFIG += release
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    archivebench.cpp \
+    ../quantumarchive.cpp \
+    ../quantumrecorder.cpp
+
+HEADERS += \
+    ../quantumarchive.h \
+    ../quantumrecorder.h \
+    ../quantumstatus.h
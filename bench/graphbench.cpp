@@ -0,0 +1,261 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* WavelengthGraph benchmark. Paints the graph into an image, the same size as it is in
+ * the main window, at 1x and 2x pixel density, and reports the time per frame:
+ *
+ *   uncached           How it used to paint, everything from scratch every frame
+ *   moving             Filter warming up, the strip slides a tick every frame
+ *   still              Nothing changed, but painted anyway (an expose, say)
+ *   retarget           Target changes every frame, so the strip is redrawn every time
+ *
+ * Then a stream of polls with the wavelength wandering inside one tenth, to show how
+ * many repaints refresh() lets through.
+ *
+ * usage: graphbench [options]
+ *   --frames <n>       Frames to time for each (default 2000)
+ *   --width <px>       Graph size (default 711 x 111, as in the main window)
+ *   --height <px>
+ *
+ * Runs headless with QT_QPA_PLATFORM=offscreen.
+*/
+
+#include <QApplication>
+#include <QImage>
+#include <QPainter>
+#include <QElapsedTimer>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+#include "wavelengthgraph.h"
+
+/////////////////////////////////////////////////////////////
+/// Gets at the drawing without a window
+class BenchGraph : public WavelengthGraph
+{
+public:
+    BenchGraph(void) : WavelengthGraph(nullptr) {}
+
+    void drawInto(QImage& image) {
+        QPainter painter(&image);
+        draw(painter, image.devicePixelRatioF());
+    }
+
+    bool wouldRepaint(void) const { return currentState(devicePixelRatioF()) != paintedState; }
+
+    // The paintEvent() this replaced, kept here to compare against
+    void drawUncached(QImage& image) {
+        QBrush redBrush(QColor(198, 32,32, 255));
+        QBrush greenBrush(QColor(32, 198, 32, 255));
+        QBrush blueBrush(QColor(32, 32, 198, 255));
+
+        QPainter painter(&image);
+        painter.setPen(QPen(QColor(198,198,198,255)));
+
+        QFont fontGraph("Helvetica", 16);
+        QFont fontGraphBold("Helvetica", 18, QFont::Black);
+
+        painter.setFont(fontGraph);
+
+        if(bOnBand)
+            painter.setBrush(greenBrush);
+        else {
+            if(fTargetWavelength > fCurrentWavelength)
+                painter.setBrush(redBrush);
+            else
+                painter.setBrush(blueBrush);
+            }
+
+        painter.drawRect(geometry());
+
+        int nWidth = width();
+        int nHeight = height();
+        int nMargins = 10;
+        int nDivisions = (nWidth - (nMargins * 2)) / 20;
+
+        int nTickSpace = int((fCurrentWavelength - fDesignWavelength) * -10.0) * nDivisions;
+        float fStart = fDesignWavelength - 1.0f;
+        for(int i= nMargins+5; i < nWidth; i+= nDivisions) {
+            painter.drawLine(i + nTickSpace, 10, i + nTickSpace, 30);
+
+            QTransform t;
+            t.translate(i + nTickSpace, 25);
+            t.rotate(90.0f);
+            painter.save();
+            painter.setTransform(t);
+            QString out = QString::asprintf("%.1f", fStart);
+            out += angstromSymbol;
+
+            if(fabs(fStart - fTargetWavelength) < 0.01) {
+                painter.setPen(QPen(QColor(255,255,255,255)));
+                painter.setFont(fontGraphBold);
+                painter.drawText(-10, -2, out);
+                painter.setFont(fontGraph);
+                painter.setPen(QPen(QColor(198,198,198,255)));
+                }
+            else
+                painter.drawText(-5, -2, out);
+
+            fStart += 0.1f;
+            painter.restore();
+        }
+
+        painter.setPen(QPen(QColor(255,255,255,255)));
+        painter.drawLine(nWidth / 2, 0, nWidth/2, nHeight-25);
+        painter.drawLine((nWidth / 2)-1, 0, (nWidth/2)-1, nHeight-25);
+        painter.drawLine((nWidth / 2)-2, 0, (nWidth/2)-2, nHeight-25);
+    }
+};
+
+enum BenchCase {
+    CASE_UNCACHED,
+    CASE_MOVING,
+    CASE_STILL,
+    CASE_RETARGET,
+    CASE_COUNT
+};
+
+static const char* caseNames[CASE_COUNT] = { "uncached", "moving", "still", "retarget" };
+
+///////////////////////////////////////////////////////////////////////
+// Microseconds per frame, mean and p99
+static void timeCase(BenchGraph& graph, QImage& image, int nCase, int nFrames, double* pMean, double* pP99)
+{
+    std::vector<double> times;
+    times.reserve(size_t(nFrames));
+    QElapsedTimer timer;
+
+    const float fDesign = 6562.8f;
+    graph.SetDesignWavelength(fDesign);
+    graph.SetTargetWavelength(fDesign);
+    graph.SetCurrentWavelength(fDesign - 0.5f);
+    graph.SetOnBand(false);
+
+    for(int i = 0; i < nFrames; i++) {
+        switch(nCase) {
+            case CASE_UNCACHED:
+            case CASE_MOVING:
+                graph.SetCurrentWavelength(fDesign - 1.0f + 0.1f * float(i % 20));
+                break;
+            case CASE_RETARGET:
+                graph.SetTargetWavelength(fDesign - 0.5f + 0.1f * float(i % 10));
+                break;
+            default:
+                break;
+            }
+
+        timer.start();
+        if(nCase == CASE_UNCACHED)
+            graph.drawUncached(image);
+        else
+            graph.drawInto(image);
+        times.push_back(double(timer.nsecsElapsed()) / 1000.0);
+        }
+
+    double total = 0.0;
+    for(size_t i = 0; i < times.size(); i++)
+        total += times[i];
+    std::sort(times.begin(), times.end());
+
+    *pMean = total / double(times.size());
+    *pP99 = times[std::min(times.size() - 1, size_t(double(times.size()) * 0.99))];
+}
+
+
+int main(int argc, char *argv[])
+{
+    QApplication a(argc, argv);
+
+    int nFrames = 2000;
+    int nWidth = 711;
+    int nHeight = 111;
+
+    for(int i = 1; i < argc; i++) {
+        const char* szArg = argv[i];
+        const char* szValue = (i + 1 < argc) ? argv[i+1] : nullptr;
+        if(szValue == nullptr) {
+            fprintf(stderr, "Unknown option, or missing value: %s\n", szArg);
+            return 1;
+            }
+
+        if(strcmp(szArg, "--frames") == 0)
+            nFrames = atoi(szValue);
+        else if(strcmp(szArg, "--width") == 0)
+            nWidth = atoi(szValue);
+        else if(strcmp(szArg, "--height") == 0)
+            nHeight = atoi(szValue);
+        else {
+            fprintf(stderr, "Unknown option: %s\n", szArg);
+            return 1;
+            }
+        i++;
+        }
+
+    if(nFrames < 1 || nWidth < 40 || nHeight < 40) {
+        fprintf(stderr, "Need at least one frame, and at least 40 x 40\n");
+        return 1;
+        }
+
+    BenchGraph graph;
+    graph.resize(nWidth, nHeight);
+
+    printf("%d x %d, %d frames\n\n", nWidth, nHeight, nFrames);
+    printf("%-10s %6s %12s %12s   (microseconds per frame)\n", "", "scale", "mean", "p99");
+
+    for(int nScale = 1; nScale <= 2; nScale++) {
+        QImage image(nWidth * nScale, nHeight * nScale, QImage::Format_ARGB32_Premultiplied);
+        image.setDevicePixelRatio(nScale);
+        image.fill(Qt::black);
+
+        for(int c = 0; c < CASE_COUNT; c++) {
+            double mean, p99;
+            timeCase(graph, image, c, nFrames, &mean, &p99);
+            printf("%-10s %5dx %12.1f %12.1f\n", caseNames[c], nScale, mean, p99);
+            }
+        }
+
+    // A minute of polls at 4 a second, on band, the reading wobbling in the last digit
+    QImage image(nWidth, nHeight, QImage::Format_ARGB32_Premultiplied);
+    graph.SetTargetWavelength(6562.8f);
+    graph.SetOnBand(true);
+    graph.drawInto(image);
+
+    int nPolls = 240, nRepaints = 0;
+    srand(1);
+    for(int i = 0; i < nPolls; i++) {
+        graph.SetCurrentWavelength(6562.8f + 0.01f * float(rand() % 5 - 2));
+        graph.SetCurrentWingshift(0.0f);
+        if(graph.wouldRepaint()) {
+            graph.drawInto(image);
+            nRepaints++;
+            }
+        }
+
+    printf("\n%d polls on band, %d repaints\n", nPolls, nRepaints);
+    return 0;
+}
@@ -0,0 +1,18 @@
+# WavelengthGraph paint time per frame, at 1x and 2x pixel density.
+# QT_QPA_PLATFORM=offscreen ./graphbench --frames 2000
+
+QT += core gui widgets
+CONFIG += console c++11
+CONFIG -= app_bundle
+CONFIG += release
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    graphbench.cpp \
+    ../quantumtrace.cpp \
+    ../wavelengthgraph.cpp
+
+HEADERS += \
+    ../quantumtrace.h \
+    ../wavelengthgraph.h
@@ -0,0 +1,377 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* See latencybench.h for what is measured.
+ *
+ * usage: latencybench [options]
+ *   --cycles <n>       Wingshift changes to time (default 1000)
+ *   --latency <ms>     Simulated device latency before each reply (default 5)
+ *   --jitter <ms>      Plus up to this much more, at random (default 0)
+ *   --baud <rate>      Pace replies to this baud rate (default 0, no pacing; 9600 is real)
+ *   --speed <x>        Thermal model speed up (default 10000, so on band comes quickly)
+ *   --poll <ms>        Poll interval while the filter is moving (default 20)
+ *   --old              Old (decimal) firmware
+ *   --dual             Two heaters
+ *   --sequential       Don't pipeline the command and the GI
+ *   --budget <ms>      Fail (exit 2) if the p99 of enqueue -> status shows it is over this
+ *
+ * Runs headless with QT_QPA_PLATFORM=offscreen.
+*/
+
+#include <QApplication>
+#include <QThread>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "latencybench.h"
+#include "quantumdevicemanager.h"
+#include "quantumsimulator.h"
+#include "quantumsimpty.h"
+
+///////////////////////////////////////////////////////////////////////
+// Same clock as QuantumStatusSnapshot::nCaptureTime
+static int64_t nanosecondsNow(void)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+///////////////////////////////////////////////////////////////////////
+LatencyBench::LatencyBench(QuantumDevice *pQuantumDevice, int nCycleCount, QLabel *pStatusLabel)
+{
+    pDevice = pQuantumDevice;
+    nCycles = nCycleCount;
+    pLabel = pStatusLabel;
+
+    series[SERIES_ENQUEUE_WRITTEN].szName = "enqueue -> written";
+    series[SERIES_WRITTEN_REPLY].szName = "written -> reply complete";
+    series[SERIES_REPLY_SIGNAL].szName = "reply -> statusUpdated";
+    series[SERIES_SIGNAL_LABEL].szName = "statusUpdated -> label";
+    series[SERIES_ENQUEUE_VISIBLE].szName = "enqueue -> status shows it";
+    series[SERIES_ENQUEUE_ON_BAND].szName = "enqueue -> on band";
+    series[SERIES_SAMPLE_INTERVAL].szName = "sample to sample";
+
+    for(int i = 0; i < SERIES_COUNT; i++)
+        series[i].samples.reserve(size_t(nCycles) * 4);
+
+    cycleTimer.setSingleShot(true);
+    connect(&cycleTimer, &QTimer::timeout, this, &LatencyBench::cycleTimedOut);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Pty thread. Just note when things got there.
+void LatencyBench::commandHook(void* pContext, const char* szCommand, int64_t nArrivalTime)
+{
+    static_cast<LatencyBench*>(pContext)->commandArrived(szCommand, nArrivalTime);
+}
+
+void LatencyBench::commandArrived(const char* szCommand, int64_t nArrivalTime)
+{
+    std::lock_guard<std::mutex> lock(arrivalMutex);
+
+    if(strncmp(szCommand, "SE", 2) == 0)
+        nSEArrival = nArrivalTime;
+    else if(strncmp(szCommand, "GI", 2) == 0)
+        giArrivals[nGIArrivals++ % 64] = nArrivalTime;
+}
+
+///////////////////////////////////////////////////////////////////////
+// The GI whose reply this was is the last one to go out before the reply was done
+int64_t LatencyBench::lastGIArrivalBefore(int64_t nTime)
+{
+    std::lock_guard<std::mutex> lock(arrivalMutex);
+
+    int64_t nBest = 0;
+    int nCount = std::min(nGIArrivals, 64);
+    for(int i = 0; i < nCount; i++)
+        if(giArrivals[i] <= nTime && giArrivals[i] > nBest)
+            nBest = giArrivals[i];
+
+    return nBest;
+}
+
+int64_t LatencyBench::lastSEArrival(void)
+{
+    std::lock_guard<std::mutex> lock(arrivalMutex);
+    return nSEArrival;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Connected. Poll quickly while the filter moves so on band is seen as soon as it happens.
+void LatencyBench::start(void)
+{
+    bRunning = true;
+    nextCycle();
+}
+
+///////////////////////////////////////////////////////////////////////
+void LatencyBench::nextCycle(void)
+{
+    if(nCycle >= nCycles) {
+        bRunning = false;
+        cycleTimer.stop();
+        emit finished();
+        return;
+        }
+
+    nCycle++;
+    nTarget = (nCycle % 2) ? LATENCY_BENCH_SHIFT : -LATENCY_BENCH_SHIFT;
+    bVisible = false;
+    cycleTimer.start(LATENCY_BENCH_CYCLE_TIMEOUT);
+
+    nEnqueueTime = nanosecondsNow();
+    pDevice->addCommand(QuantumCommand::setWingshift(nTarget));
+}
+
+///////////////////////////////////////////////////////////////////////
+void LatencyBench::cycleTimedOut(void)
+{
+    nTimeouts++;
+    nextCycle();
+}
+
+///////////////////////////////////////////////////////////////////////
+// GUI thread, same as QuantumGui gets it
+void LatencyBench::statusUpdated(void)
+{
+    int64_t nSignalTime = nanosecondsNow();
+
+    QuantumStatusSnapshot snapshot;
+    pDevice->getStatusSnapshot(&snapshot);
+
+    // Already seen this one (two signals came in before we got to the first)
+    if(snapshot.nSequence == nLastSequence)
+        return;
+    nLastSequence = snapshot.nSequence;
+
+    series[SERIES_REPLY_SIGNAL].samples.push_back(nSignalTime - snapshot.nCaptureTime);
+    if(nLastCapture != 0)
+        series[SERIES_SAMPLE_INTERVAL].samples.push_back(snapshot.nCaptureTime - nLastCapture);
+    nLastCapture = snapshot.nCaptureTime;
+
+    // What the GUI does with it
+    pLabel->setText(QString::asprintf("%.1f  %+.1f  %s", snapshot.status.centerWavelength,
+                                      snapshot.status.wingShift, snapshot.status.bOnBand ? "On band" : ""));
+    pLabel->repaint();
+    int64_t nLabelTime = nanosecondsNow();
+    series[SERIES_SIGNAL_LABEL].samples.push_back(nLabelTime - nSignalTime);
+
+    if(!bRunning || snapshot.nCaptureTime < nEnqueueTime)
+        return;
+
+    if(lroundf(snapshot.status.wingShift * 10.0f) != nTarget)
+        return;
+
+    if(!bVisible) {
+        bVisible = true;
+        series[SERIES_ENQUEUE_VISIBLE].samples.push_back(nSignalTime - nEnqueueTime);
+
+        int64_t nWritten = lastSEArrival();
+        if(nWritten >= nEnqueueTime)
+            series[SERIES_ENQUEUE_WRITTEN].samples.push_back(nWritten - nEnqueueTime);
+
+        int64_t nGIWritten = lastGIArrivalBefore(snapshot.nCaptureTime);
+        if(nGIWritten >= nEnqueueTime)
+            series[SERIES_WRITTEN_REPLY].samples.push_back(snapshot.nCaptureTime - nGIWritten);
+        }
+
+    if(!snapshot.status.bOnBand)
+        return;
+
+    series[SERIES_ENQUEUE_ON_BAND].samples.push_back(nSignalTime - nEnqueueTime);
+
+    // Let this signal finish before starting the next one
+    QTimer::singleShot(0, this, &LatencyBench::nextCycle);
+    cycleTimer.stop();
+}
+
+///////////////////////////////////////////////////////////////////////
+// Nearest rank
+static double percentile(const std::vector<int64_t>& sorted, double fPercent)
+{
+    if(sorted.empty())
+        return 0.0;
+
+    size_t nRank = size_t(ceil(fPercent / 100.0 * double(sorted.size())));
+    if(nRank > 0)
+        nRank--;
+    if(nRank >= sorted.size())
+        nRank = sorted.size() - 1;
+
+    return double(sorted[nRank]);
+}
+
+double LatencyBench::report(void)
+{
+    double fVisibleP99 = 0.0;
+
+    printf("%-28s %8s %10s %10s %10s %10s   (microseconds)\n", "", "n", "p50", "p95", "p99", "max");
+    for(int i = 0; i < SERIES_COUNT; i++) {
+        std::vector<int64_t> sorted = series[i].samples;
+        std::sort(sorted.begin(), sorted.end());
+
+        double fP99 = percentile(sorted, 99.0);
+        printf("%-28s %8zu %10.0f %10.0f %10.0f %10.0f\n", series[i].szName, sorted.size(),
+               percentile(sorted, 50.0) / 1000.0, percentile(sorted, 95.0) / 1000.0,
+               fP99 / 1000.0, sorted.empty() ? 0.0 : double(sorted.back()) / 1000.0);
+
+        if(i == SERIES_ENQUEUE_VISIBLE)
+            fVisibleP99 = fP99 / 1000000.0;
+        }
+
+    QuantumPipelineStats stats;
+    pDevice->getPipelineStats(&stats);
+    printf("%d cycles, %d timed out, %llu pipelined, %llu sequential, %llu fallbacks\n",
+           nCycle, nTimeouts, (unsigned long long)stats.nPipelinedCycles,
+           (unsigned long long)stats.nSequentialCycles, (unsigned long long)stats.nFallbacks);
+
+    return fVisibleP99;
+}
+
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+
+    // Keep our device cache out of the real application's settings
+    QCoreApplication::setOrganizationName("Starstone Software Systems, Inc.");
+    QCoreApplication::setApplicationName("Quantum Latency Bench");
+
+    QuantumSimSettings simSettings;
+    QuantumSimLink link;
+    int nCycles = 1000;
+    int nPoll = 20;
+    bool bSequential = false;
+    double fBudget = 0.0;
+
+    link.nBaudRate = 0;
+    link.fSpeed = 10000.0;
+    simSettings.fStartTemp = QUANTUM_SIM_DESIGN_TEMP;
+
+    for(int i = 1; i < argc; i++) {
+        const char* szArg = argv[i];
+        const char* szValue = (i + 1 < argc) ? argv[i+1] : nullptr;
+
+        if(strcmp(szArg, "--old") == 0)
+            simSettings.bOldFirmware = true;
+        else if(strcmp(szArg, "--dual") == 0)
+            simSettings.bDualHeaters = true;
+        else if(strcmp(szArg, "--sequential") == 0)
+            bSequential = true;
+        else if(szValue == nullptr) {
+            fprintf(stderr, "Unknown option, or missing value: %s\n", szArg);
+            return 1;
+            }
+        else {
+            i++;
+            if(strcmp(szArg, "--cycles") == 0)
+                nCycles = atoi(szValue);
+            else if(strcmp(szArg, "--latency") == 0)
+                link.fLatency = atof(szValue);
+            else if(strcmp(szArg, "--jitter") == 0)
+                link.fJitter = atof(szValue);
+            else if(strcmp(szArg, "--baud") == 0)
+                link.nBaudRate = atoi(szValue);
+            else if(strcmp(szArg, "--speed") == 0)
+                link.fSpeed = atof(szValue);
+            else if(strcmp(szArg, "--poll") == 0)
+                nPoll = atoi(szValue);
+            else if(strcmp(szArg, "--budget") == 0)
+                fBudget = atof(szValue);
+            else {
+                fprintf(stderr, "Unknown option: %s\n", szArg);
+                return 1;
+                }
+            }
+        }
+
+    // The stand in device, on its own thread
+    QuantumSimulator simulator(simSettings);
+    QuantumSimPty pty(simulator, link);
+    if(!pty.open())
+        return 1;
+
+    QLabel label;
+    label.show();
+
+    QuantumDeviceManager manager(nullptr);
+    QuantumDevice *pDevice = manager.addDevice(QString(pty.getSlaveName()));
+    pDevice->setPipelined(!bSequential);
+    pDevice->setRecordHistory(false);
+
+    QuantumPollSettings pollSettings = QuantumPollScheduler::defaultSettings();
+    pollSettings.nActiveInterval = nPoll;
+    pollSettings.nMinInterval = 1;
+    pDevice->setPollSettings(pollSettings);
+
+    LatencyBench bench(pDevice, nCycles, &label);
+
+    // The hook goes in before the thread that calls it starts, and comes out after it ends
+    pty.setCommandHook(LatencyBench::commandHook, &bench);
+    std::atomic<bool> bStop(false);
+    std::thread ptyThread([&pty, &bStop]() {
+        while(!bStop)
+            pty.service(5);
+        });
+
+    QObject::connect(pDevice, &QuantumDevice::statusUpdated, &bench, &LatencyBench::statusUpdated, Qt::QueuedConnection);
+    QObject::connect(&manager, &QuantumDeviceManager::connectedToQuantum, &bench, &LatencyBench::start);
+    QObject::connect(&manager, &QuantumDeviceManager::couldNotOpen, &app, [&app]() {
+        fprintf(stderr, "Could not connect to the simulator\n");
+        app.exit(1);
+        });
+    QObject::connect(&bench, &LatencyBench::finished, &app, &QApplication::quit);
+
+    printf("Latency %.1f ms, jitter %.1f ms, %s baud, %s, %s firmware, %d cycles\n",
+           link.fLatency, link.fJitter, link.nBaudRate ? QByteArray::number(link.nBaudRate).constData() : "unlimited",
+           bSequential ? "sequential" : "pipelined", simSettings.bOldFirmware ? "decimal" : "hex", nCycles);
+
+    int nResult = app.exec();
+
+    // Before the device goes away, the pipeline stats come from it
+    double fVisibleP99 = 0.0;
+    if(nResult == 0)
+        fVisibleP99 = bench.report();
+
+    manager.shutdown();
+    bStop = true;
+    ptyThread.join();
+    pty.setCommandHook(nullptr, nullptr);
+
+    if(nResult != 0)
+        return nResult;
+
+    if(fBudget > 0.0 && fVisibleP99 > fBudget) {
+        fprintf(stderr, "Over budget: p99 enqueue -> status shows it is %.2f ms, budget is %.2f\n", fVisibleP99, fBudget);
+        return 2;
+        }
+
+    return 0;
+}
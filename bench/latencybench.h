@@ -0,0 +1,129 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* End to end latency benchmark. A QuantumDevice is run against the simulator on a pty,
+ * exactly as it would run against a filter, and every step from a wingshift being
+ * queued to it showing up on screen is timed:
+ *
+ *   enqueue -> written          addCommand() until the SE arrives at the (simulated) device
+ *   written -> reply complete   the GI arriving until its reply is parsed and published
+ *   reply -> statusUpdated      published until the GUI thread gets statusUpdated
+ *   statusUpdated -> label      setting and repainting a label with the new status
+ *   enqueue -> status shows it  addCommand() until the GUI has a status with the new wingshift
+ *   enqueue -> on band          and until that status is also on band
+ *   sample to sample            time between published samples (the poll cycle)
+ *
+ * All times come from the steady clock, the same one the status snapshots are stamped with,
+ * so times taken on the pty thread, the I/O thread, and the GUI thread line up.
+*/
+#ifndef LATENCYBENCH_H
+#define LATENCYBENCH_H
+
+#include <QObject>
+#include <QLabel>
+#include <QTimer>
+
+#include <stdint.h>
+#include <mutex>
+#include <vector>
+
+#include "quantumdevice.h"
+
+// Give up on a cycle after this long (milliseconds), so one lost reply can't hang the run
+#define LATENCY_BENCH_CYCLE_TIMEOUT 5000
+
+// Wingshift goes back and forth between these (tenths of an Angstrom)
+#define LATENCY_BENCH_SHIFT         5
+
+/////////////////////////////////////////////////////////////
+/// One set of measurements, in nanoseconds
+struct LatencySeries {
+    const char*             szName;
+    std::vector<int64_t>    samples;
+};
+
+
+class LatencyBench : public QObject
+{
+    Q_OBJECT
+public:
+    LatencyBench(QuantumDevice *pQuantumDevice, int nCycleCount, QLabel *pStatusLabel);
+
+    // From the pty thread, as each command reaches the simulator
+    static void commandHook(void* pContext, const char* szCommand, int64_t nArrivalTime);
+
+    // Percentiles of everything, to stdout. Returns the p99 of enqueue -> status shows it,
+    // in milliseconds.
+    double report(void);
+
+    int getTimeoutCount(void) const { return nTimeouts; }
+
+protected:
+    enum {
+        SERIES_ENQUEUE_WRITTEN,
+        SERIES_WRITTEN_REPLY,
+        SERIES_REPLY_SIGNAL,
+        SERIES_SIGNAL_LABEL,
+        SERIES_ENQUEUE_VISIBLE,
+        SERIES_ENQUEUE_ON_BAND,
+        SERIES_SAMPLE_INTERVAL,
+        SERIES_COUNT
+    };
+
+    QuantumDevice   *pDevice;
+    QLabel          *pLabel;
+    QTimer          cycleTimer;
+    LatencySeries   series[SERIES_COUNT];
+    int             nCycles;
+    int             nCycle = 0;
+    int             nTimeouts = 0;
+    int             nTarget = 0;                // Wingshift this cycle is waiting for
+    int64_t         nEnqueueTime = 0;
+    bool            bVisible = false;           // Has shown up in the status
+    bool            bRunning = false;
+    quint64         nLastSequence = 0;
+    int64_t         nLastCapture = 0;
+
+    // Written on the pty thread
+    std::mutex      arrivalMutex;
+    int64_t         nSEArrival = 0;             // Most recent
+    int64_t         giArrivals[64];             // Ring of the most recent
+    int             nGIArrivals = 0;
+
+    void    commandArrived(const char* szCommand, int64_t nArrivalTime);
+    int64_t lastGIArrivalBefore(int64_t nTime);
+    int64_t lastSEArrival(void);
+    void    nextCycle(void);
+
+public Q_SLOTS:
+    void start(void);
+    void statusUpdated(void);
+
+protected Q_SLOTS:
+    void cycleTimedOut(void);
+
+signals:
+    void finished(void);
+};
+
+#endif // LATENCYBENCH_H
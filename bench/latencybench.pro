@@ -0,0 +1,54 @@
+# End to end latency benchmark. QuantumDevice against the simulator on a pty
+# (Linux and macOS). See latencybench.cpp for the options.
+# QT_QPA_PLATFORM=offscreen ./latencybench --cycles 2000 --latency 5
+
+QT += core gui widgets serialport network
+CONFIG += console c++11
+CONFIG -= app_bundle
+CONFIG += release
+
+INCLUDEPATH += .. ../sim
+
+unix:!macx: LIBS += -lrt
+
+SOURCES += \
+    latencybench.cpp \
+    ../quantumcommand.cpp \
+    ../quantumcommandqueue.cpp \
+    ../quantumdevice.cpp \
+    ../quantumdevicemanager.cpp \
+    ../quantumdrift.cpp \
+    ../quantumframer.cpp \
+    ../quantuminfocache.cpp \
+    ../quantummetrics.cpp \
+    ../quantumparser.cpp \
+    ../quantumpollscheduler.cpp \
+    ../quantumpushserver.cpp \
+    ../quantumrecorder.cpp \
+    ../quantumshmwriter.cpp \
+    ../quantumtrace.cpp \
+    ../sim/quantumsimpty.cpp \
+    ../sim/quantumsimulator.cpp
+
+HEADERS += \
+    latencybench.h \
+    ../quantumcommand.h \
+    ../quantumcommandqueue.h \
+    ../quantumdevice.h \
+    ../quantumdevicemanager.h \
+    ../quantumdrift.h \
+    ../quantumframer.h \
+    ../quantuminfocache.h \
+    ../quantummetrics.h \
+    ../quantumparser.h \
+    ../quantumpollscheduler.h \
+    ../quantumpush.h \
+    ../quantumpushserver.h \
+    ../quantumrecorder.h \
+    ../quantumseqlock.h \
+    ../quantumshm.h \
+    ../quantumshmwriter.h \
+    ../quantumstatus.h \
+    ../quantumtrace.h \
+    ../sim/quantumsimpty.h \
+    ../sim/quantumsimulator.h
@@ -0,0 +1,120 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* Micro benchmark for the GI status parser. Every reply in the corpus is parsed
+ * repeatedly with the parser that would be picked for it at connect time, and the
+ * cost per sample is reported. Pass a budget in nanoseconds and the benchmark fails
+ * when the parser gets slower than that, so a regression can't sneak in.
+ *
+ * usage: parserbench [corpus file] [iterations] [max ns per sample]
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../quantumparser.h"
+
+struct CorpusLine {
+    std::string         line;
+    QuantumStatusParser pfnParser;
+};
+
+///////////////////////////////////////////////////////////////////////////////////////
+// Same decisions the device makes at connect time
+static QuantumStatusParser parserForLine(const std::string& line)
+{
+    QuantumSpan fields[QUANTUM_MAX_STATUS_FIELDS];
+    int nFields = quantumSplitFields(line.c_str(), int(line.size()), fields, QUANTUM_MAX_STATUS_FIELDS);
+    bool bOldFirmware = atof(line.c_str() + 1) < 1.26f;
+
+    return quantumSelectStatusParser(bOldFirmware, nFields > QUANTUM_SINGLE_HEATER_FIELDS);
+}
+
+int main(int argc, char *argv[])
+{
+    const char* szCorpus = (argc > 1) ? argv[1] : "gi_corpus.txt";
+    long nIterations = (argc > 2) ? atol(argv[2]) : 200000;
+    double fBudget = (argc > 3) ? atof(argv[3]) : 0.0;
+
+    FILE* pFile = fopen(szCorpus, "r");
+    if(pFile == nullptr) {
+        fprintf(stderr, "Could not open %s\n", szCorpus);
+        return 1;
+        }
+
+    std::vector<CorpusLine> corpus;
+    char szLine[1024];
+    while(fgets(szLine, sizeof(szLine), pFile)) {
+        szLine[strcspn(szLine, "\r\n")] = 0x0;
+        if(szLine[0] == 0x0 || szLine[0] == '#')
+            continue;
+
+        CorpusLine entry;
+        entry.line = szLine;
+        entry.pfnParser = parserForLine(entry.line);
+        corpus.push_back(entry);
+        }
+    fclose(pFile);
+
+    // Every line has to parse, or the numbers mean nothing
+    QuantumStatus status;
+    for(size_t i = 0; i < corpus.size(); i++)
+        if(!corpus[i].pfnParser(corpus[i].line.c_str(), int(corpus[i].line.size()), &status)) {
+            fprintf(stderr, "Failed to parse: %s\n", corpus[i].line.c_str());
+            return 1;
+            }
+
+    if(corpus.empty()) {
+        fprintf(stderr, "Corpus is empty\n");
+        return 1;
+        }
+
+    // Keep the compiler from throwing the work away
+    volatile float fSink = 0.0f;
+
+    auto start = std::chrono::steady_clock::now();
+    for(long n = 0; n < nIterations; n++)
+        for(size_t i = 0; i < corpus.size(); i++) {
+            corpus[i].pfnParser(corpus[i].line.c_str(), int(corpus[i].line.size()), &status);
+            fSink = fSink + status.centerWavelength;
+            }
+    auto stop = std::chrono::steady_clock::now();
+
+    double fSamples = double(nIterations) * double(corpus.size());
+    double fNanoseconds = std::chrono::duration<double, std::nano>(stop - start).count();
+    double fPerSample = fNanoseconds / fSamples;
+
+    printf("%zu replies, %.0f samples, %.1f ns per sample, %.2f M samples/s\n",
+           corpus.size(), fSamples, fPerSample, 1000.0 / fPerSample);
+
+    if(fBudget > 0.0 && fPerSample > fBudget) {
+        fprintf(stderr, "Over budget: %.1f ns per sample, budget is %.1f\n", fPerSample, fBudget);
+        return 2;
+        }
+
+    return 0;
+}
@@ -0,0 +1,20 @@
+# Micro benchmark for the GI status parser. No Qt needed.
+# Run from this directory: ./parserbench gi_corpus.txt 200000 <max ns per sample>
+
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= qt app_bundle
+CONFIG += release
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    parserbench.cpp \
+    ../quantumparser.cpp
+
+HEADERS += \
+    ../quantumparser.h \
+    ../quantumstatus.h
+
+DISTFILES += \
+    gi_corpus.txt
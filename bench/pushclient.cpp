@@ -0,0 +1,310 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* A push client, to watch what the push server sends (see quantumpush.h). Prints every
+ * frame as it comes in. Plain sockets, no Qt, Linux and macOS.
+ *
+ * usage: pushclient [options]
+ *   --port <n>         Where Quantum Control (or quantumcli --push) listens (default 5280)
+ *   --host <address>   Default 127.0.0.1
+ *   --name <text>      Put in front of every line, to tell clients apart (default pushclient)
+ *   --claim <p>        Claim control at this priority, 1 to 255
+ *   --wingshift <n>    Once in control, set the wingshift, tenths of an Angstrom
+ *   --stall <s>        Read nothing for this many seconds first, like a client that has
+ *                      fallen behind. The server should drop samples for it, not queue them.
+ *   --rcvbuf <bytes>   Small receive buffer, so a stall backs up into the server sooner
+ *   --seconds <s>      Quit after this long (default 0, keep going)
+ *   --quiet            Don't print each status, only the summary
+ *
+ * Two clients, the second one takes control from the first:
+ *   pushclient --name low --claim 1 &
+ *   pushclient --name high --claim 5 --wingshift 3
+ *
+ * A slow reader, to see the server drop samples:
+ *   pushclient --stall 120 --rcvbuf 1024 --seconds 130
+ *
+ * Status sequence numbers that don't follow on are counted as missed.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "quantumpush.h"
+
+static volatile sig_atomic_t bQuit = 0;
+
+static void onSignal(int)
+{
+    bQuit = 1;
+}
+
+static double nowSeconds(void)
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return double(now.tv_sec) + double(now.tv_nsec) * 1e-9;
+}
+
+static const char* resultName(int nResult)
+{
+    switch(nResult) {
+        case QPUSH_RESULT_OK:           return "ok";
+        case QPUSH_RESULT_NOT_OWNER:    return "not owner";
+        case QPUSH_RESULT_OUTRANKED:    return "outranked";
+        case QPUSH_RESULT_BAD_REQUEST:  return "bad request";
+        case QPUSH_RESULT_BUSY:         return "busy";
+        }
+    return "?";
+}
+
+static const char* requestName(int nType)
+{
+    switch(nType) {
+        case QPUSH_CLAIM:           return "claim";
+        case QPUSH_RELEASE:         return "release";
+        case QPUSH_SET_WINGSHIFT:   return "wingshift";
+        }
+    return "?";
+}
+
+static bool sendFrame(int nSocket, int nType, const uint8_t* pPayload, int nLength)
+{
+    uint8_t frame[QPUSH_HEADER_SIZE + QPUSH_MAX_PAYLOAD];
+    quantumPushHeader(frame, nType, nLength);
+    if(nLength > 0)
+        memcpy(frame + QPUSH_HEADER_SIZE, pPayload, size_t(nLength));
+
+    return send(nSocket, frame, size_t(QPUSH_HEADER_SIZE + nLength), 0) == QPUSH_HEADER_SIZE + nLength;
+}
+
+
+int main(int argc, char *argv[])
+{
+    const char* szHost = "127.0.0.1";
+    const char* szName = "pushclient";
+    int nPort = QPUSH_DEFAULT_PORT;
+    int nClaim = 0;
+    int nWingshift = 0;
+    bool bWingshift = false;
+    double fStall = 0.0;
+    int nReceiveBuffer = 0;
+    double fSeconds = 0.0;
+    bool bQuiet = false;
+
+    for(int i = 1; i < argc; i++) {
+        const char* szArg = argv[i];
+        const char* szValue = (i + 1 < argc) ? argv[i+1] : nullptr;
+
+        if(strcmp(szArg, "--quiet") == 0)
+            bQuiet = true;
+        else if(szValue == nullptr) {
+            fprintf(stderr, "Unknown option, or missing value: %s\n", szArg);
+            return 1;
+            }
+        else {
+            i++;
+            if(strcmp(szArg, "--port") == 0)
+                nPort = atoi(szValue);
+            else if(strcmp(szArg, "--host") == 0)
+                szHost = szValue;
+            else if(strcmp(szArg, "--name") == 0)
+                szName = szValue;
+            else if(strcmp(szArg, "--claim") == 0)
+                nClaim = atoi(szValue);
+            else if(strcmp(szArg, "--wingshift") == 0) {
+                nWingshift = atoi(szValue);
+                bWingshift = true;
+                }
+            else if(strcmp(szArg, "--stall") == 0)
+                fStall = atof(szValue);
+            else if(strcmp(szArg, "--rcvbuf") == 0)
+                nReceiveBuffer = atoi(szValue);
+            else if(strcmp(szArg, "--seconds") == 0)
+                fSeconds = atof(szValue);
+            else {
+                fprintf(stderr, "Unknown option: %s\n", szArg);
+                return 1;
+                }
+            }
+        }
+
+    if(nClaim < 0 || nClaim > 255 || nWingshift < -10 || nWingshift > 10) {
+        fprintf(stderr, "Priority is 1 to 255, wingshift -10 to 10\n");
+        return 1;
+        }
+
+    int nSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if(nSocket < 0) {
+        perror("socket");
+        return 1;
+        }
+
+    // Has to be before connecting, or the window is already agreed on
+    if(nReceiveBuffer > 0)
+        setsockopt(nSocket, SOL_SOCKET, SO_RCVBUF, &nReceiveBuffer, sizeof(nReceiveBuffer));
+
+    int nOne = 1;
+    setsockopt(nSocket, IPPROTO_TCP, TCP_NODELAY, &nOne, sizeof(nOne));
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(uint16_t(nPort));
+    if(inet_pton(AF_INET, szHost, &address.sin_addr) != 1) {
+        fprintf(stderr, "Not an IPv4 address: %s\n", szHost);
+        return 1;
+        }
+
+    if(connect(nSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        perror("connect");
+        return 1;
+        }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    double fStart = nowSeconds();
+
+    if(nClaim > 0) {
+        uint8_t priority = uint8_t(nClaim);
+        sendFrame(nSocket, QPUSH_CLAIM, &priority, 1);
+        }
+
+    if(fStall > 0.0) {
+        fprintf(stderr, "%s: not reading for %.0f s\n", szName, fStall);
+        while(!bQuit && nowSeconds() - fStart < fStall)
+            usleep(100000);
+        }
+
+    uint8_t buffer[4096];
+    int nBuffered = 0;
+    long nFrames = 0;
+    long nStatus = 0;
+    long nMissed = 0;
+    uint64_t nLastSequence = 0;
+
+    while(!bQuit) {
+        double fLeft = 1.0;
+        if(fSeconds > 0.0) {
+            fLeft = fSeconds - (nowSeconds() - fStart);
+            if(fLeft <= 0.0)
+                break;
+            }
+
+        timeval timeout;
+        timeout.tv_sec = long(fLeft);
+        timeout.tv_usec = long((fLeft - double(timeout.tv_sec)) * 1e6);
+        setsockopt(nSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        ssize_t nRead = recv(nSocket, buffer + nBuffered, sizeof(buffer) - size_t(nBuffered), 0);
+        if(nRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+            continue;
+        if(nRead <= 0) {
+            fprintf(stderr, "%s: server closed the connection\n", szName);
+            break;
+            }
+        nBuffered += int(nRead);
+
+        // Whole frames only, the rest waits for more
+        int nUsed = 0;
+        while(nBuffered - nUsed >= QPUSH_HEADER_SIZE) {
+            const uint8_t* pFrame = buffer + nUsed;
+            int nLength = quantumPushGet16(pFrame);
+            if(nBuffered - nUsed < QPUSH_HEADER_SIZE + nLength)
+                break;
+
+            const uint8_t* pPayload = pFrame + QPUSH_HEADER_SIZE;
+            double fTime = nowSeconds() - fStart;
+            nFrames++;
+
+            switch(pFrame[2]) {
+                case QPUSH_HELLO:
+                    if(nLength >= 6)
+                        printf("%s %8.3f hello version %d, design wavelength %.1f, serial %.*s\n", szName, fTime,
+                               quantumPushGet16(pPayload), double(quantumPushGetFloat(pPayload + 2)),
+                               nLength - 6, reinterpret_cast<const char*>(pPayload + 6));
+                    break;
+
+                case QPUSH_STATUS: {
+                    if(nLength != QPUSH_STATUS_SIZE)
+                        break;
+
+                    QuantumPushStatus status;
+                    quantumPushDecodeStatus(pPayload, &status);
+                    if(nLastSequence != 0 && status.nSequence > nLastSequence + 1)
+                        nMissed += long(status.nSequence - nLastSequence - 1);
+                    nLastSequence = status.nSequence;
+                    nStatus++;
+
+                    if(!bQuiet)
+                        printf("%s %8.3f status %llu, wavelength %.1f, wingshift %.1f, target %.1f, %s\n", szName, fTime,
+                               (unsigned long long)status.nSequence, double(status.fWavelength), double(status.fWingshift),
+                               double(status.fTarget), (status.nFlags & QPUSH_FLAG_ON_BAND) ? "on band" : "off band");
+                    break;
+                    }
+
+                case QPUSH_REPLY:
+                    if(nLength == 2)
+                        printf("%s %8.3f reply to %s: %s\n", szName, fTime, requestName(pPayload[0]), resultName(pPayload[1]));
+                    break;
+
+                case QPUSH_CONTROL:
+                    if(nLength == 2) {
+                        printf("%s %8.3f control %s, owner priority %d\n", szName, fTime,
+                               pPayload[0] ? "granted" : "lost", int(pPayload[1]));
+
+                        if(pPayload[0] && bWingshift) {
+                            int8_t nTenths = int8_t(nWingshift);
+                            sendFrame(nSocket, QPUSH_SET_WINGSHIFT, reinterpret_cast<const uint8_t*>(&nTenths), 1);
+                            bWingshift = false;
+                            }
+                        }
+                    break;
+
+                default:
+                    printf("%s %8.3f frame type %d, %d bytes\n", szName, fTime, int(pFrame[2]), nLength);
+                    break;
+                }
+
+            nUsed += QPUSH_HEADER_SIZE + nLength;
+            }
+
+        memmove(buffer, buffer + nUsed, size_t(nBuffered - nUsed));
+        nBuffered -= nUsed;
+        fflush(stdout);
+        }
+
+    close(nSocket);
+
+    fprintf(stderr, "%s: %ld frames, %ld status, %ld samples missed\n", szName, nFrames, nStatus, nMissed);
+    return 0;
+}
@@ -0,0 +1,15 @@
+# Push client, prints what the push server sends. No Qt needed, Linux and macOS.
+# ./pushclient --port 5280 --claim 5
+
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= qt app_bundle
+
+INCLUDEPATH += ..
+
+SOURCES += \
+    pushclient.cpp
+
+HEADERS += \
+    ../quantumpush.h \
+    ../quantumstatus.h
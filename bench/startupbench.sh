@@ -0,0 +1,48 @@
+#!/bin/sh
+# Startup time and memory, Quantum Control against quantumcli, both connecting to
+# the simulator. Each is run a few times, and each prints how long it took from
+# main() to the first status sample and how much memory it was holding then
+# (QUANTUM_STARTUP_STATS, see quantumprocess.h). Linux and macOS, it needs a pty.
+#
+# Build QuantumControl, cli/quantumcli and sim/quantumsim first, then
+#   bench/startupbench.sh ./QuantumControl cli/quantumcli sim/quantumsim [runs]
+
+GUI=$1
+CLI=$2
+SIM=$3
+RUNS=${4:-5}
+
+if [ -z "$GUI" ] || [ -z "$CLI" ] || [ -z "$SIM" ]; then
+    echo "usage: startupbench.sh <QuantumControl> <quantumcli> <quantumsim> [runs]" >&2
+    exit 1
+fi
+
+WORK=$(mktemp -d)
+LINK=$WORK/ttyQuantum
+
+"$SIM" --warm --baud 0 --latency 1 --link "$LINK" > /dev/null &
+SIM_PID=$!
+trap 'kill $SIM_PID 2> /dev/null; rm -rf "$WORK"' EXIT
+
+# Wait for the pty to show up
+n=0
+while [ ! -e "$LINK" ] && [ $n -lt 100 ]; do sleep 0.05; n=$((n + 1)); done
+
+# The GUI runs until it's closed, so wait for its line and then stop it
+runGui() {
+    rm -f "$WORK/gui.err"
+    QT_QPA_PLATFORM=offscreen QUANTUM_STARTUP_STATS=1 "$GUI" --port "$LINK" 2> "$WORK/gui.err" &
+    GUI_PID=$!
+    n=0
+    while ! grep -q "^startup:" "$WORK/gui.err" 2> /dev/null && [ $n -lt 200 ]; do sleep 0.05; n=$((n + 1)); done
+    kill $GUI_PID 2> /dev/null
+    wait $GUI_PID 2> /dev/null
+    grep "^startup:" "$WORK/gui.err"
+}
+
+i=0
+while [ $i -lt "$RUNS" ]; do
+    printf "gui  "; runGui
+    printf "cli  "; "$CLI" --port "$LINK" --count 1 --stats < /dev/null 2>&1 > /dev/null | grep "^startup:"
+    i=$((i + 1))
+done
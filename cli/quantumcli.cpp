@@ -0,0 +1,514 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* Command line controller. Connects to a Quantum on the given port, writes every
+ * status sample to stdout, one line each, and takes commands on stdin. QtCore and
+ * QtSerialPort only, so it runs on a box with no display and skips the cost of
+ * starting up widgets.
+ *
+ * usage: quantumcli --port <name or path> [options]
+ *   --format json|csv  Output, one JSON object per line (default) or CSV with a header
+ *   --count <n>        Quit after this many samples (default 0, keep going)
+ *   --no-history       Don't record samples to the history file
+ *   --stats            Startup time and memory on stderr once status is coming in
+ *   --push <port>      Also push samples to other programs over TCP (see quantumpush.h)
+ *   --push-any         and accept them from other machines, not just this one
+ *   --alpaca <port>    Serve the filter to ASCOM Alpaca clients (see quantumalpaca.h)
+ *   --alpaca-any       and to other machines, not just this one
+ *   --shm <name>       Write every sample to a shared memory segment (see quantumshm.h)
+ *
+ * Commands, one per line on stdin:
+ *   wingshift <A>      Set the wingshift, -1.0 to 1.0 Angstroms
+ *   up, down           Wingshift up or down a tenth, from where it is headed
+ *   center             Wingshift to zero
+ *   info               Model, serial number, firmware, design wavelength
+ *   quit
+ *
+ * Errors go to stderr, so stdout is only ever samples (and info when asked for).
+ * QUANTUM_TRACE works the same as for Quantum Control.
+ *
+ *   quantumcli --port /dev/ttyUSB0 --format csv > today.csv
+ *   echo "wingshift 0.3" | quantumcli --port COM3
+*/
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QStringList>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <chrono>
+#else
+#include <unistd.h>
+#include <QSocketNotifier>
+#endif
+
+#include "quantumcli.h"
+#include "quantumprocess.h"
+#include "quantumtrace.h"
+
+// Same limits as the buttons in the GUI, tenths of an Angstrom
+#define CLI_WINGSHIFT_LIMIT     10
+
+
+///////////////////////////////////////////////////////////////////////
+QuantumCli::QuantumCli(QuantumCliFormat outputFormat, int nSampleCount, bool bShowStats)
+{
+    format = outputFormat;
+    nSamplesLeft = nSampleCount;
+    bStats = bShowStats;
+}
+
+///////////////////////////////////////////////////////////////////////
+void QuantumCli::start(const QString& qsPort, bool bRecordHistory, quint16 nPush, bool bPushLoopback,
+                       quint16 nAlpaca, bool bAlpacaLoopback, const QString& qsShm)
+{
+    nPushPort = nPush;
+    bPushLoopbackOnly = bPushLoopback;
+    nAlpacaPort = nAlpaca;
+    bAlpacaLoopbackOnly = bAlpacaLoopback;
+    qsShmName = qsShm;
+
+    pDeviceManager = new QuantumDeviceManager(this);
+    connect(pDeviceManager, SIGNAL(connectedToQuantum(QuantumDevice*)), this, SLOT(connected(QuantumDevice*)), Qt::QueuedConnection);
+    connect(pDeviceManager, SIGNAL(couldNotOpen(QuantumDevice*)), this, SLOT(couldNotOpen(QuantumDevice*)), Qt::QueuedConnection);
+    connect(pDeviceManager, SIGNAL(fatalError(QuantumDevice*, int)), this, SLOT(fatalError(QuantumDevice*, int)), Qt::QueuedConnection);
+
+    // The history file is opened during startup, before we hear that it connected,
+    // so this has to be set now
+    QuantumDevice *pNewDevice = pDeviceManager->addDevice(qsPort);
+    pNewDevice->setRecordHistory(bRecordHistory);
+}
+
+///////////////////////////////////////////////////////////////////////
+void QuantumCli::connected(QuantumDevice* pQuantumDevice)
+{
+    pDevice = pQuantumDevice;
+    if(nPushPort != 0)
+        pDevice->startPushServer(nPushPort, bPushLoopbackOnly);
+    if(!qsShmName.isEmpty())
+        pDevice->startSharedStatus(qsShmName);
+
+    if(nAlpacaPort != 0) {
+        pAlpacaServer = new QuantumAlpacaServer(this, pDevice);
+        if(!pAlpacaServer->start(nAlpacaPort, bAlpacaLoopbackOnly))
+            fprintf(stderr, "Could not serve Alpaca on port %d\n", int(nAlpacaPort));
+        }
+
+    if(format == CLI_FORMAT_CSV) {
+        printf("sequence,time,wavelength,wingshift,target,onBand,errorCode,heater1Temperature,heater2Temperature,"
+               "heater1PWM,heater2PWM,inputVoltage,wavelengthRate,temperatureRate,secondsToOnBand\n");
+        fflush(stdout);
+        }
+
+    connect(pDevice, SIGNAL(statusUpdated()), this, SLOT(statusUpdated()), Qt::QueuedConnection);
+
+    // The first sample is already in by the time we're connected
+    statusUpdated();
+}
+
+void QuantumCli::couldNotOpen(QuantumDevice* pQuantumDevice)
+{
+    fprintf(stderr, "Could not connect to a Quantum on %s\n", qPrintable(pQuantumDevice->getPortName()));
+    pDeviceManager->removeDevice(pQuantumDevice);
+    finish(1);
+}
+
+void QuantumCli::fatalError(QuantumDevice* pQuantumDevice, int nErrorCode)
+{
+    fprintf(stderr, "Lost the connection to the Quantum (error %d)\n", nErrorCode);
+    delete pAlpacaServer;
+    pAlpacaServer = nullptr;
+    pDeviceManager->removeDevice(pQuantumDevice);
+    pDevice = nullptr;
+    finish(1);
+}
+
+///////////////////////////////////////////////////////////////////////
+// One line per new sample. Signals that pile up while we're busy are all
+// for the same latest sample, so the repeats are skipped.
+void QuantumCli::statusUpdated(void)
+{
+    if(pDevice == nullptr)
+        return;
+
+    QuantumStatusSnapshot snapshot;
+    pDevice->getStatusSnapshot(&snapshot);
+    if(snapshot.nSequence == 0 || snapshot.nSequence == nLastSequence)
+        return;
+    nLastSequence = snapshot.nSequence;
+
+    const QuantumStatus& status = snapshot.status;
+    const QuantumDrift& drift = snapshot.drift;
+    QByteArray time = QDateTime::fromMSecsSinceEpoch(snapshot.nWallTime, Qt::UTC).toString(Qt::ISODateWithMs).toLatin1();
+
+    if(format == CLI_FORMAT_JSON)
+        printf("{\"sequence\":%llu,\"time\":\"%s\",\"wavelength\":%.1f,\"wingshift\":%.1f,\"target\":%.1f,"
+               "\"onBand\":%s,\"errorCode\":%d,\"heater1Temperature\":%.2f,\"heater2Temperature\":%.2f,"
+               "\"heater1PWM\":%.2f,\"heater2PWM\":%.2f,\"inputVoltage\":%.2f,"
+               "\"wavelengthRate\":%.5f,\"temperatureRate\":%.4f,\"secondsToOnBand\":%.0f}\n",
+               (unsigned long long)snapshot.nSequence, time.constData(), double(status.centerWavelength),
+               double(status.wingShift), double(drift.fTarget), status.bOnBand ? "true" : "false", status.nErrorCode,
+               double(status.heater1Temprature), double(status.heater2Temperature), double(status.heater1PMW),
+               double(status.heater2PMW), double(status.inputVoltage), double(drift.fWavelengthRate),
+               double(drift.fTemperatureRate), double(drift.fSecondsToOnBand));
+    else
+        printf("%llu,%s,%.1f,%.1f,%.1f,%d,%d,%.2f,%.2f,%.2f,%.2f,%.2f,%.5f,%.4f,%.0f\n",
+               (unsigned long long)snapshot.nSequence, time.constData(), double(status.centerWavelength),
+               double(status.wingShift), double(drift.fTarget), status.bOnBand ? 1 : 0, status.nErrorCode,
+               double(status.heater1Temprature), double(status.heater2Temperature), double(status.heater1PMW),
+               double(status.heater2PMW), double(status.inputVoltage), double(drift.fWavelengthRate),
+               double(drift.fTemperatureRate), double(drift.fSecondsToOnBand));
+
+    // Whoever is reading wants it now, not when the buffer fills
+    fflush(stdout);
+
+    if(bStats) {
+        bStats = false;
+        quantumPrintStartupStats("first status");
+        }
+
+    if(nSamplesLeft > 0 && --nSamplesLeft == 0)
+        finish(0);
+}
+
+///////////////////////////////////////////////////////////////////////
+// A string as a JSON string, quotes included. Model names and the like come
+// straight from the device, so anything can be in them.
+static QByteArray jsonString(const QString& qsText)
+{
+    QByteArray utf8 = qsText.toUtf8();
+    QByteArray json;
+    json.reserve(utf8.size() + 2);
+
+    json += '"';
+    for(int i = 0; i < utf8.size(); i++) {
+        char c = utf8[i];
+        if(c == '"' || c == '\\') {
+            json += '\\';
+            json += c;
+            }
+        else if(static_cast<unsigned char>(c) < 0x20) {
+            char szEscape[8];
+            snprintf(szEscape, sizeof(szEscape), "\\u%04x", unsigned(static_cast<unsigned char>(c)));
+            json += szEscape;
+            }
+        else
+            json += c;
+        }
+    json += '"';
+
+    return json;
+}
+
+///////////////////////////////////////////////////////////////////////
+void QuantumCli::printInfo(void)
+{
+    QuantumStaticInfo info = pDevice->getStaticInfo();
+
+    if(format == CLI_FORMAT_JSON) {
+        // A number, or null if the device never told us
+        bool bOk;
+        double fDesign = info.qsDesignWavelength.toDouble(&bOk);
+        QByteArray design = bOk ? QByteArray::number(fDesign, 'f', 1) : QByteArray("null");
+
+        printf("{\"model\":%s,\"serialNumber\":%s,\"firmware\":%s,\"bandwidth\":%s,\"designWavelength\":%s}\n",
+               jsonString(info.qsModelString).constData(), jsonString(info.qsSerialNumber).constData(),
+               jsonString(info.qsFirmwareVersion).constData(), jsonString(info.qsBandwidthString).constData(),
+               design.constData());
+        }
+    else
+        printf("# model %s, serial number %s, firmware %s, bandwidth %s, design wavelength %s\n",
+               qPrintable(info.qsModelString), qPrintable(info.qsSerialNumber), qPrintable(info.qsFirmwareVersion),
+               qPrintable(info.qsBandwidthString), qPrintable(info.qsDesignWavelength));
+    fflush(stdout);
+}
+
+///////////////////////////////////////////////////////////////////////
+void QuantumCli::setWingshift(int nTenths)
+{
+    if(nTenths > CLI_WINGSHIFT_LIMIT || nTenths < -CLI_WINGSHIFT_LIMIT) {
+        fprintf(stderr, "Wingshift has to be between -1.0 and 1.0\n");
+        return;
+        }
+
+    if(!pDevice->addCommand(QuantumCommand::setWingshift(nTenths)))
+        fprintf(stderr, "Command queue is full, try again\n");
+}
+
+///////////////////////////////////////////////////////////////////////
+// A line from stdin
+void QuantumCli::commandLine(const QString& qsLine)
+{
+    QString qsWords = qsLine.simplified();
+    if(qsWords.isEmpty())
+        return;
+
+    QStringList words = qsWords.split(' ');
+
+    QString qsCommand = words[0].toLower();
+
+    if(qsCommand == "quit" || qsCommand == "exit") {
+        finish(0);
+        return;
+        }
+
+    if(pDevice == nullptr) {
+        fprintf(stderr, "Not connected yet\n");
+        return;
+        }
+
+    if(qsCommand == "wingshift" && words.size() == 2) {
+        bool bOk;
+        float fShift = words[1].toFloat(&bOk);
+        if(!bOk) {
+            fprintf(stderr, "Not a wingshift: %s\n", qPrintable(words[1]));
+            return;
+            }
+        setWingshift(int(lroundf(fShift * 10.0f)));
+        }
+    else if(qsCommand == "up")
+        setWingshift(int(lroundf(pDevice->getTargetWingshift() * 10.0f)) + 1);
+    else if(qsCommand == "down")
+        setWingshift(int(lroundf(pDevice->getTargetWingshift() * 10.0f)) - 1);
+    else if(qsCommand == "center")
+        setWingshift(0);
+    else if(qsCommand == "info")
+        printInfo();
+    else
+        fprintf(stderr, "Unknown command: %s\n", qPrintable(qsLine.trimmed()));
+}
+
+///////////////////////////////////////////////////////////////////////
+void QuantumCli::finish(int nExitCode)
+{
+    // Its clients read from the device
+    delete pAlpacaServer;
+    pAlpacaServer = nullptr;
+
+    if(pDevice != nullptr) {
+        pDeviceManager->removeDevice(pDevice);
+        pDevice = nullptr;
+        }
+
+    pDeviceManager->shutdown();
+    QCoreApplication::exit(nExitCode);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Commands come in on stdin. Running out of it isn't a reason to stop,
+// it's often /dev/null.
+#if defined(_WIN32)
+// Console and pipe handles can't be watched like a socket, so blocking reads
+// on a thread of their own. Each line is handed to the main thread.
+void QuantumCli::startInput(void)
+{
+    inputThread = std::thread([this]() {
+        nInputThreadId = GetCurrentThreadId();
+
+        char szLine[256];
+        while(!bInputStop && fgets(szLine, sizeof(szLine), stdin) != nullptr)
+            QMetaObject::invokeMethod(this, "commandLine", Qt::QueuedConnection, Q_ARG(QString, QString::fromUtf8(szLine)));
+
+        bInputDone = true;
+        });
+}
+
+// The reader is most likely stuck in fgets(). Knock it out of there until it notices.
+void QuantumCli::stopInput(void)
+{
+    if(!inputThread.joinable())
+        return;
+
+    bInputStop = true;
+    while(!bInputDone) {
+        HANDLE hThread = (nInputThreadId != 0) ? OpenThread(THREAD_TERMINATE, FALSE, nInputThreadId) : nullptr;
+        if(hThread != nullptr) {
+            CancelSynchronousIo(hThread);
+            CloseHandle(hThread);
+            }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+    inputThread.join();
+}
+
+// Only the notifier calls this, and there isn't one here
+void QuantumCli::inputReady(void)
+{
+}
+
+#else
+void QuantumCli::startInput(void)
+{
+    pInputNotifier = new QSocketNotifier(STDIN_FILENO, QSocketNotifier::Read, this);
+    connect(pInputNotifier, SIGNAL(activated(int)), this, SLOT(inputReady()));
+}
+
+void QuantumCli::stopInput(void)
+{
+    delete pInputNotifier;
+    pInputNotifier = nullptr;
+}
+
+// Whatever is there, which may be part of a line, or several
+void QuantumCli::inputReady(void)
+{
+    char buffer[256];
+    ssize_t nRead = read(STDIN_FILENO, buffer, sizeof(buffer));
+    if(nRead < 0 && (errno == EINTR || errno == EAGAIN))
+        return;
+
+    if(nRead <= 0) {
+        pInputNotifier->setEnabled(false);
+        if(!inputLine.isEmpty())
+            commandLine(QString::fromUtf8(inputLine));
+        inputLine.clear();
+        return;
+        }
+
+    inputLine.append(buffer, int(nRead));
+
+    int nEnd;
+    while((nEnd = inputLine.indexOf('\n')) >= 0) {
+        QString qsLine = QString::fromUtf8(inputLine.constData(), nEnd);
+        inputLine.remove(0, nEnd + 1);
+        commandLine(qsLine);
+        }
+}
+#endif
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: quantumcli --port <name or path> [--format json|csv] [--count <n>] [--no-history] [--stats]\n"
+                    "                  [--push <port>] [--push-any] [--alpaca <port>] [--alpaca-any]\n"
+                    "                  [--shm <name>]\n"
+                    "commands on stdin: wingshift <A>, up, down, center, info, quit\n");
+}
+
+
+int main(int argc, char *argv[])
+{
+    quantumProcessStarted();
+
+    // Same settings and history as Quantum Control
+    QCoreApplication::setApplicationName("Quantum Control");
+    QCoreApplication::setOrganizationName("Starstone Software Systems, Inc.");
+
+    QByteArray traceFile = qgetenv("QUANTUM_TRACE");
+    if(!traceFile.isEmpty()) {
+        quantumTraceStart(traceFile.constData());
+        quantumTraceThreadName("Main");
+        }
+
+    QCoreApplication app(argc, argv);
+
+    QString qsPort;
+    QuantumCliFormat format = CLI_FORMAT_JSON;
+    int nCount = 0;
+    bool bHistory = true;
+    bool bStats = !qgetenv("QUANTUM_STARTUP_STATS").isEmpty();
+    int nPushPort = 0;
+    bool bPushAny = false;
+    int nAlpacaPort = 0;
+    bool bAlpacaAny = false;
+    QString qsShm;
+
+    for(int i = 1; i < argc; i++) {
+        const char* szArg = argv[i];
+        const char* szValue = (i + 1 < argc) ? argv[i+1] : nullptr;
+
+        if(strcmp(szArg, "--no-history") == 0) {
+            bHistory = false;
+            continue;
+            }
+        if(strcmp(szArg, "--stats") == 0) {
+            bStats = true;
+            continue;
+            }
+        if(strcmp(szArg, "--push-any") == 0) {
+            bPushAny = true;
+            continue;
+            }
+        if(strcmp(szArg, "--alpaca-any") == 0) {
+            bAlpacaAny = true;
+            continue;
+            }
+
+        if(szValue == nullptr) {
+            usage();
+            return 1;
+            }
+
+        if(strcmp(szArg, "--port") == 0)
+            qsPort = QString::fromLocal8Bit(szValue);
+        else if(strcmp(szArg, "--count") == 0)
+            nCount = atoi(szValue);
+        else if(strcmp(szArg, "--push") == 0)
+            nPushPort = atoi(szValue);
+        else if(strcmp(szArg, "--alpaca") == 0)
+            nAlpacaPort = atoi(szValue);
+        else if(strcmp(szArg, "--shm") == 0)
+            qsShm = QString::fromLocal8Bit(szValue);
+        else if(strcmp(szArg, "--format") == 0) {
+            if(strcmp(szValue, "json") == 0)
+                format = CLI_FORMAT_JSON;
+            else if(strcmp(szValue, "csv") == 0)
+                format = CLI_FORMAT_CSV;
+            else {
+                usage();
+                return 1;
+                }
+            }
+        else {
+            usage();
+            return 1;
+            }
+        i++;
+        }
+
+    if(qsPort.isEmpty()) {
+        usage();
+        return 1;
+        }
+
+    QuantumCli cli(format, nCount, bStats);
+    cli.start(qsPort, bHistory, quint16(nPushPort), !bPushAny, quint16(nAlpacaPort), !bAlpacaAny, qsShm);
+
+    cli.startInput();
+
+    int nResult = app.exec();
+
+    cli.stopInput();
+
+    if(!traceFile.isEmpty())
+        quantumTraceStop();
+
+    return nResult;
+}
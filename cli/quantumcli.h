@@ -0,0 +1,102 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* Quantum Control without a window, for automation hosts. See quantumcli.cpp for
+ * the options and commands.
+*/
+#ifndef QUANTUMCLI_H
+#define QUANTUMCLI_H
+
+#include <QObject>
+#include <QString>
+
+#include <stdint.h>
+
+#if defined(_WIN32)
+#include <atomic>
+#include <thread>
+#else
+class QSocketNotifier;
+#endif
+
+#include "quantumdevicemanager.h"
+#include "quantumalpaca.h"
+
+enum QuantumCliFormat {
+    CLI_FORMAT_JSON,            // One object per line
+    CLI_FORMAT_CSV              // Header line, then one row per sample
+};
+
+class QuantumCli : public QObject
+{
+    Q_OBJECT
+public:
+    QuantumCli(QuantumCliFormat outputFormat, int nSampleCount, bool bShowStats);
+
+    // nPush is the push server's port, nAlpaca the Alpaca server's, 0 for none.
+    // qsShm names the shared memory segment, empty for none.
+    void start(const QString& qsPort, bool bRecordHistory, quint16 nPush, bool bPushLoopback,
+               quint16 nAlpaca, bool bAlpacaLoopback, const QString& qsShm);
+
+    // Take commands from stdin. Stop before this goes away.
+    void startInput(void);
+    void stopInput(void);
+
+protected:
+    QuantumDeviceManager *pDeviceManager = nullptr;
+    QuantumDevice   *pDevice = nullptr;
+    QuantumCliFormat format;
+    int             nSamplesLeft;               // Quit after this many, 0 runs forever
+    bool            bStats;
+    quint16         nPushPort = 0;
+    bool            bPushLoopbackOnly = true;
+    QuantumAlpacaServer *pAlpacaServer = nullptr;
+    quint16         nAlpacaPort = 0;
+    bool            bAlpacaLoopbackOnly = true;
+    QString         qsShmName;
+    uint64_t        nLastSequence = 0;
+
+#if defined(_WIN32)
+    std::thread     inputThread;
+    std::atomic<bool> bInputStop { false };
+    std::atomic<bool> bInputDone { false };
+    std::atomic<unsigned long> nInputThreadId { 0 };
+#else
+    QSocketNotifier *pInputNotifier = nullptr;
+    QByteArray      inputLine;                  // Partial line from stdin
+#endif
+
+    void printInfo(void);
+    void setWingshift(int nTenths);
+    void finish(int nExitCode);
+
+public Q_SLOTS:
+    void connected(QuantumDevice* pQuantumDevice);
+    void couldNotOpen(QuantumDevice* pQuantumDevice);
+    void fatalError(QuantumDevice* pQuantumDevice, int nErrorCode);
+    void statusUpdated(void);
+    void commandLine(const QString& qsLine);
+    void inputReady(void);
+};
+
+#endif // QUANTUMCLI_H
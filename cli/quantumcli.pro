@@ -0,0 +1,54 @@
+# Command line controller, no widgets. See quantumcli.cpp for the options and commands.
+# ./quantumcli --port /dev/ttyUSB0 --format csv
+
+TEMPLATE = app
+QT = core serialport network
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+INCLUDEPATH += ..
+
+win32: LIBS += -lpsapi
+unix:!macx: LIBS += -lrt
+
+SOURCES += \
+    quantumcli.cpp \
+    ../quantumalpaca.cpp \
+    ../quantumcommand.cpp \
+    ../quantumcommandqueue.cpp \
+    ../quantumdevice.cpp \
+    ../quantumdevicemanager.cpp \
+    ../quantumdrift.cpp \
+    ../quantumframer.cpp \
+    ../quantuminfocache.cpp \
+    ../quantummetrics.cpp \
+    ../quantumparser.cpp \
+    ../quantumpollscheduler.cpp \
+    ../quantumprocess.cpp \
+    ../quantumpushserver.cpp \
+    ../quantumrecorder.cpp \
+    ../quantumshmwriter.cpp \
+    ../quantumtrace.cpp
+
+HEADERS += \
+    quantumcli.h \
+    ../quantumalpaca.h \
+    ../quantumcommand.h \
+    ../quantumcommandqueue.h \
+    ../quantumdevice.h \
+    ../quantumdevicemanager.h \
+    ../quantumdrift.h \
+    ../quantumframer.h \
+    ../quantuminfocache.h \
+    ../quantummetrics.h \
+    ../quantumparser.h \
+    ../quantumpollscheduler.h \
+    ../quantumprocess.h \
+    ../quantumpush.h \
+    ../quantumpushserver.h \
+    ../quantumrecorder.h \
+    ../quantumseqlock.h \
+    ../quantumshm.h \
+    ../quantumshmwriter.h \
+    ../quantumstatus.h \
+    ../quantumtrace.h
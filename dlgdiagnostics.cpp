@@ -0,0 +1,133 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+#include <QShowEvent>
+#include <QHideEvent>
+#include <QTableWidgetItem>
+
+#include "dlgdiagnostics.h"
+#include "ui_dlgdiagnostics.h"
+
+// One column per number, one row per command
+enum DiagnosticsColumn {
+    COLUMN_SENT,
+    COLUMN_OK,
+    COLUMN_FAILED,
+    COLUMN_RETRIES,
+    COLUMN_TIMEOUTS,
+    COLUMN_PARTIAL,
+    COLUMN_PARSE,
+    COLUMN_BYTES_OUT,
+    COLUMN_BYTES_IN,
+    COLUMN_RTT_AVERAGE,
+    COLUMN_RTT_P50,
+    COLUMN_RTT_P95,
+    COLUMN_RTT_MAX,
+    COLUMN_COUNT
+};
+
+DlgDiagnostics::DlgDiagnostics(QWidget *parent, QuantumDevice *pDevice) :
+    QDialog(parent),
+    ui(new Ui::DlgDiagnostics)
+{
+    ui->setupUi(this);
+    pQuantumDevice = pDevice;
+
+    QStringList columns = { tr("Sent"), tr("OK"), tr("Failed"), tr("Retries"), tr("Timeouts"),
+                            tr("Partial"), tr("Bad reply"), tr("Bytes out"), tr("Bytes in"),
+                            tr("RTT avg"), tr("RTT p50"), tr("RTT p95"), tr("RTT max") };
+    ui->tableWidget->setColumnCount(COLUMN_COUNT);
+    ui->tableWidget->setHorizontalHeaderLabels(columns);
+
+    QStringList rows;
+    for(int i = 0; i < QCMD_COUNT; i++)
+        rows << QString(quantumCommandInfo(QuantumCommandCode(i)).szMnemonic);
+    ui->tableWidget->setRowCount(QCMD_COUNT);
+    ui->tableWidget->setVerticalHeaderLabels(rows);
+
+    for(int iRow = 0; iRow < QCMD_COUNT; iRow++)
+        for(int iColumn = 0; iColumn < COLUMN_COUNT; iColumn++) {
+            QTableWidgetItem *pItem = new QTableWidgetItem();
+            pItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            ui->tableWidget->setItem(iRow, iColumn, pItem);
+            }
+
+    connect(&refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+}
+
+DlgDiagnostics::~DlgDiagnostics()
+{
+    delete ui;
+}
+
+// No point doing this while nobody is looking
+void DlgDiagnostics::showEvent(QShowEvent *event)
+{
+    refresh();
+    refreshTimer.start(DIAGNOSTICS_REFRESH);
+    QDialog::showEvent(event);
+}
+
+void DlgDiagnostics::hideEvent(QHideEvent *event)
+{
+    refreshTimer.stop();
+    QDialog::hideEvent(event);
+}
+
+void DlgDiagnostics::on_pushButtonReset_clicked()
+{
+    pQuantumDevice->resetIOMetrics();
+    refresh();
+}
+
+////////////////////////////////////////////////////////////////////
+// Round trips are shown in milliseconds, everything else is a count
+void DlgDiagnostics::refresh(void)
+{
+    QuantumIOMetrics metrics;
+    pQuantumDevice->getIOMetrics(&metrics);
+
+    for(int iRow = 0; iRow < QCMD_COUNT; iRow++) {
+        const QuantumCommandMetrics& command = metrics.commands[iRow];
+        quint64 counts[] = { command.nSent, command.nSucceeded, command.nFailed, command.nRetries,
+                             command.nTimeouts, command.nPartialReads, command.nParseFailures,
+                             command.nBytesOut, command.nBytesIn };
+        for(int iColumn = 0; iColumn <= COLUMN_BYTES_IN; iColumn++)
+            ui->tableWidget->item(iRow, iColumn)->setText(QString::number(counts[iColumn]));
+
+        qint64 times[] = { quantumRttAverage(command), quantumRttPercentile(command, 50.0),
+                           quantumRttPercentile(command, 95.0), qint64(command.nRttMax) };
+        for(int i = 0; i < 4; i++)
+            ui->tableWidget->item(iRow, COLUMN_RTT_AVERAGE + i)->setText(
+                        command.nSucceeded ? QString::asprintf("%.1f", double(times[i]) / 1000.0) : QString());
+        }
+
+    QuantumPipelineStats pipeline;
+    pQuantumDevice->getPipelineStats(&pipeline);
+
+    QString summary = tr("Samples: %1    Missed: %2    Rate: %3/s    Pipelined: %4    Sequential: %5    Fallbacks: %6")
+            .arg(metrics.nSamples).arg(metrics.nMissedSamples)
+            .arg(pQuantumDevice->getSampleRate(), 0, 'f', 2)
+            .arg(pipeline.nPipelinedCycles).arg(pipeline.nSequentialCycles).arg(pipeline.nFallbacks);
+    ui->labelSummary->setText(summary);
+}
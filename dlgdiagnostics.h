@@ -0,0 +1,65 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* Link diagnostics. Shows the I/O metrics the device keeps for each command (see
+ * quantummetrics.h), so a slow or flaky serial link can be spotted in the field.
+ * Updates itself once a second while it is open.
+*/
+#ifndef DLGDIAGNOSTICS_H
+#define DLGDIAGNOSTICS_H
+
+#include <QDialog>
+#include <QTimer>
+
+#include "quantumdevice.h"
+
+// How often to refresh the numbers (milliseconds)
+#define DIAGNOSTICS_REFRESH     1000
+
+namespace Ui {
+class DlgDiagnostics;
+}
+
+class DlgDiagnostics : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit DlgDiagnostics(QWidget *parent, QuantumDevice *pDevice);
+    ~DlgDiagnostics();
+
+private:
+    Ui::DlgDiagnostics *ui;
+    QuantumDevice   *pQuantumDevice;
+    QTimer          refreshTimer;
+
+protected:
+    virtual void showEvent(QShowEvent *event) override;
+    virtual void hideEvent(QHideEvent *event) override;
+
+public Q_SLOTS:
+    void refresh(void);
+    void on_pushButtonReset_clicked();
+};
+
+#endif // DLGDIAGNOSTICS_H
@@ -0,0 +1,103 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+#include <QShowEvent>
+
+#include "dlghistory.h"
+#include "ui_dlghistory.h"
+
+DlgHistory::DlgHistory(QWidget *parent, QuantumDevice *pDevice) :
+    QDialog(parent),
+    ui(new Ui::DlgHistory)
+{
+    ui->setupUi(this);
+    pQuantumDevice = pDevice;
+
+    pChart = new HistoryChart(this);
+    pChart->SetDesignWavelength(pQuantumDevice->getWavelengthString().toFloat());
+    ui->verticalLayout->insertWidget(0, pChart, 1);
+
+    connect(pQuantumDevice, SIGNAL(statusUpdated()), this, SLOT(refresh()), Qt::QueuedConnection);
+}
+
+DlgHistory::~DlgHistory()
+{
+    delete ui;
+}
+
+void DlgHistory::showEvent(QShowEvent *event)
+{
+    refresh();
+    QDialog::showEvent(event);
+}
+
+////////////////////////////////////////////////////////////////////
+// Start over from the device's history file. It changes if a different filter
+// turns up on the port.
+bool DlgHistory::openHistory(void)
+{
+    QString qsFile = pQuantumDevice->getHistoryFile();
+    if(qsFile != qsHistoryFile) {
+        recorder.close();
+        qsHistoryFile = qsFile;
+        pChart->clear();
+        nLastLive = 0;
+
+        if(!qsFile.isEmpty() && recorder.openReadOnly(qsFile))
+            nNextSequence = recorder.getFirstSequence();
+        }
+
+    return recorder.isOpen();
+}
+
+////////////////////////////////////////////////////////////////////
+// Read whatever has been recorded since last time. Nothing to do while hidden,
+// it is all still in the file when we are shown again.
+void DlgHistory::refresh(void)
+{
+    if(!isVisible())
+        return;
+
+    if(openHistory()) {
+        QuantumRecord records[256];
+        int nRead;
+        do {
+            nRead = recorder.readRange(nNextSequence, records, 256, &nNextSequence);
+            for(int i = 0; i < nRead; i++)
+                pChart->appendRecord(records[i]);
+            } while(nRead > 0);
+        }
+    else {
+        // Not recording, so only what we see
+        QuantumStatusSnapshot snapshot;
+        pQuantumDevice->getStatusSnapshot(&snapshot);
+        if(snapshot.nSequence != 0 && snapshot.nSequence != nLastLive) {
+            QuantumRecord record;
+            quantumRecordFromSnapshot(snapshot, &record);
+            pChart->appendRecord(record);
+            nLastLive = snapshot.nSequence;
+            }
+        }
+
+    pChart->update();
+}
@@ -0,0 +1,68 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* History window. The chart (historychart.h) fed from the device's history file, so
+ * it opens with everything recorded so far, even from before a restart, then picks up
+ * each new sample as it is recorded. If recording is off, it shows what comes in
+ * while it is open.
+*/
+#ifndef DLGHISTORY_H
+#define DLGHISTORY_H
+
+#include <QDialog>
+
+#include "quantumdevice.h"
+#include "quantumrecorder.h"
+#include "historychart.h"
+
+namespace Ui {
+class DlgHistory;
+}
+
+class DlgHistory : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit DlgHistory(QWidget *parent, QuantumDevice *pDevice);
+    ~DlgHistory();
+
+private:
+    Ui::DlgHistory  *ui;
+    QuantumDevice   *pQuantumDevice;
+    HistoryChart    *pChart;
+    QuantumRecorder recorder;               // Read only, the device writes it
+    QString         qsHistoryFile;
+    quint64         nNextSequence = 0;      // Next one to read from the file
+    quint64         nLastLive = 0;          // Last live sample, when there is no file
+
+    bool openHistory(void);
+
+protected:
+    virtual void showEvent(QShowEvent *event) override;
+
+public Q_SLOTS:
+    void refresh(void);
+};
+
+#endif // DLGHISTORY_H
@@ -0,0 +1,359 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+#include <math.h>
+
+#include <QPainter>
+#include <QPen>
+#include <QColor>
+#include <QFont>
+#include <QDateTime>
+
+#include "historychart.h"
+#include "quantumtrace.h"
+
+/////////////////////////////////////////////////////////////
+/// The panes, top to bottom. Each autoscales to what is in
+/// view, but never to less than fMinSpan.
+struct HistoryPane {
+    const char  *szTitle;
+    int         series[2];
+    int         nSeries;
+    float       fMinSpan;
+    const char  *szFormat;
+};
+
+static const HistoryPane historyPanes[] = {
+    { "Wavelength",     { HSERIES_WAVELENGTH, HSERIES_TARGET },                     2, 0.5f,  "%.1f" },
+    { "Heater",         { HSERIES_HEATER1_TEMPERATURE, HSERIES_HEATER2_TEMPERATURE }, 2, 1.0f,  "%.1f" },
+    { "Drive %",        { HSERIES_HEATER1_PWM, HSERIES_HEATER2_PWM },               2, 10.0f, "%.0f" },
+    { "Supply V",       { HSERIES_VOLTAGE, 0 },                                     1, 0.5f,  "%.2f" },
+};
+
+static const int nHistoryPanes = int(sizeof(historyPanes) / sizeof(historyPanes[0]));
+
+static const QColor seriesColors[HSERIES_COUNT] = {
+    QColor(32, 198, 32),        // Wavelength
+    QColor(198, 198, 198),      // Target
+    QColor(198, 32, 32),        // Heater 1
+    QColor(198, 128, 32),       // Heater 2
+    QColor(198, 32, 32),
+    QColor(198, 128, 32),
+    QColor(64, 128, 255)        // Supply
+};
+
+
+HistoryChart::HistoryChart(QWidget *parent) : QWidget(parent), pyramid(HSERIES_COUNT)
+{
+    setMouseTracking(false);
+    setMinimumSize(320, 240);
+}
+
+///////////////////////////////////////////////////////////////////////
+void HistoryChart::clear(void)
+{
+    pyramid.clear();
+    bDualHeaters = false;
+    bFollow = true;
+    nViewFrom = nViewTo = 0;
+}
+
+///////////////////////////////////////////////////////////////////////
+// The pyramid wants time in order. If the clock was set back, pretend it wasn't.
+void HistoryChart::appendRecord(const QuantumRecord& record)
+{
+    if(pyramid.size() >= HISTORY_CHART_MAX_SAMPLES)
+        pyramid.dropOldest(HISTORY_CHART_MAX_SAMPLES / 4);
+
+    int64_t nTime = record.nWallTime;
+    if(pyramid.size() > 0 && nTime < pyramid.getTime(pyramid.size() - 1))
+        nTime = pyramid.getTime(pyramid.size() - 1);
+
+    float values[HSERIES_COUNT];
+    values[HSERIES_WAVELENGTH] = record.centerWavelength;
+    values[HSERIES_TARGET] = fDesignWavelength + record.wingShift;
+    values[HSERIES_HEATER1_TEMPERATURE] = record.heater1Temperature;
+    values[HSERIES_HEATER2_TEMPERATURE] = record.heater2Temperature;
+    values[HSERIES_HEATER1_PWM] = record.heater1PWM;
+    values[HSERIES_HEATER2_PWM] = record.heater2PWM;
+    values[HSERIES_VOLTAGE] = record.inputVoltage;
+    pyramid.append(nTime, values);
+
+    if(record.nFlags & QUANTUM_RECORD_DUAL_HEATERS)
+        bDualHeaters = true;
+
+    // Slide along with the newest, keeping the same span
+    if(bFollow) {
+        int64_t nSpan = nViewTo - nViewFrom;
+        if(nSpan <= 0 || pyramid.size() == 1)
+            showEverything();
+        else if(nTime > nViewTo) {
+            nViewTo = nTime;
+            nViewFrom = nTime - nSpan;
+            }
+        }
+}
+
+///////////////////////////////////////////////////////////////////////
+void HistoryChart::showEverything(void)
+{
+    bFollow = true;
+    if(pyramid.size() == 0)
+        return;
+
+    nViewFrom = pyramid.getTime(0);
+    nViewTo = pyramid.getTime(pyramid.size() - 1);
+    if(nViewTo - nViewFrom < HISTORY_CHART_MIN_SPAN)
+        nViewFrom = nViewTo - HISTORY_CHART_MIN_SPAN;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Room on the left for the scale, and at the bottom for the times
+QRect HistoryChart::plotRect(void) const
+{
+    return QRect(56, 4, width() - 64, height() - 24);
+}
+
+int64_t HistoryChart::timeAt(int x) const
+{
+    QRect plot = plotRect();
+    if(plot.width() <= 0)
+        return nViewFrom;
+
+    return nViewFrom + ((nViewTo - nViewFrom) * int64_t(x - plot.left())) / int64_t(plot.width());
+}
+
+///////////////////////////////////////////////////////////////////////
+// One min/max per pixel column, for every series. Nothing here depends on how many
+// samples there are, except the binary searches.
+void HistoryChart::paintEvent(QPaintEvent *event)
+{
+    QUANTUM_TRACE_SCOPE("HistoryChart::paintEvent");
+
+    event->accept();
+
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(32, 32, 32));
+
+    QFont fontLabel("Helvetica", 9);
+    painter.setFont(fontLabel);
+
+    QRect plot = plotRect();
+    int nColumns = plot.width();
+    if(nColumns <= 0 || plot.height() <= 0)
+        return;
+
+    if(pyramid.size() == 0 || nViewTo <= nViewFrom) {
+        painter.setPen(QPen(QColor(198, 198, 198)));
+        painter.drawText(plot, Qt::AlignCenter, tr("No history yet"));
+        return;
+        }
+
+    columns.resize(nColumns);
+    pyramid.columnsFor(nViewFrom, nViewTo + 1, nColumns, columns.data());
+    int nFirst = columns[0].nFirst;
+    int nEnd = columns[nColumns - 1].nEnd;
+
+    // Fewer samples than pixels, draw them as they are
+    bool bSparse = (nEnd - nFirst) <= nColumns;
+    double msPerPixel = double(nViewTo - nViewFrom) / double(nColumns);
+
+    int nPaneHeight = plot.height() / nHistoryPanes;
+    for(int p = 0; p < nHistoryPanes; p++) {
+        const HistoryPane& pane = historyPanes[p];
+        QRect paneRect(plot.left(), plot.top() + p * nPaneHeight, plot.width(), nPaneHeight - 4);
+
+        // Scale to what is in view
+        float fMin = 0.0f, fMax = 0.0f;
+        bool bAny = false;
+        for(int s = 0; s < pane.nSeries; s++) {
+            int nSeries = pane.series[s];
+            if(!bDualHeaters && (nSeries == HSERIES_HEATER2_TEMPERATURE || nSeries == HSERIES_HEATER2_PWM))
+                continue;
+
+            QuantumLodRange range = pyramid.rangeOf(nSeries, nFirst, nEnd);
+            if(range.nCount == 0)
+                continue;
+            if(!bAny || range.min < fMin) fMin = range.min;
+            if(!bAny || range.max > fMax) fMax = range.max;
+            bAny = true;
+            }
+
+        if(fMax - fMin < pane.fMinSpan) {
+            float fMiddle = (fMin + fMax) * 0.5f;
+            fMin = fMiddle - pane.fMinSpan * 0.5f;
+            fMax = fMiddle + pane.fMinSpan * 0.5f;
+            }
+        float fPad = (fMax - fMin) * 0.05f;
+        fMin -= fPad;
+        fMax += fPad;
+        double yScale = double(paneRect.height()) / double(fMax - fMin);
+
+        painter.setPen(QPen(QColor(64, 64, 64)));
+        painter.setBrush(Qt::NoBrush);
+        painter.drawRect(paneRect);
+
+        painter.setPen(QPen(QColor(198, 198, 198)));
+        painter.drawText(QRect(0, paneRect.top(), plot.left() - 4, 14), Qt::AlignRight, QString::asprintf(pane.szFormat, double(fMax)));
+        painter.drawText(QRect(0, paneRect.bottom() - 14, plot.left() - 4, 14), Qt::AlignRight, QString::asprintf(pane.szFormat, double(fMin)));
+        painter.drawText(paneRect.adjusted(4, 2, 0, 0), Qt::AlignLeft | Qt::AlignTop, QString(pane.szTitle));
+
+        if(!bAny)
+            continue;
+
+        painter.save();
+        painter.setClipRect(paneRect);
+        for(int s = 0; s < pane.nSeries; s++) {
+            int nSeries = pane.series[s];
+            if(!bDualHeaters && (nSeries == HSERIES_HEATER2_TEMPERATURE || nSeries == HSERIES_HEATER2_PWM))
+                continue;
+
+            painter.setPen(QPen(seriesColors[nSeries]));
+            line.clear();
+
+            if(bSparse) {
+                // One more on each side, so the line runs off the edges
+                int nFrom = (nFirst > 0) ? nFirst - 1 : 0;
+                int nTo = (nEnd < pyramid.size()) ? nEnd + 1 : nEnd;
+                for(int i = nFrom; i < nTo; i++) {
+                    if(i > nFrom && pyramid.getTime(i) - pyramid.getTime(i-1) > HISTORY_CHART_GAP) {
+                        painter.drawPolyline(line);
+                        line.clear();
+                        }
+
+                    double x = plot.left() + double(pyramid.getTime(i) - nViewFrom) / msPerPixel;
+                    double y = paneRect.bottom() - double(pyramid.getValue(nSeries, i) - fMin) * yScale;
+                    line.append(QPointF(x, y));
+                    }
+                }
+            else {
+                // Down and up each column. Empty columns are joined across, zoomed in
+                // they're just the time between polls. A real gap breaks the line.
+                int nLast = -1;                 // Last sample drawn
+                for(int c = 0; c < nColumns; c++) {
+                    QuantumLodRange range = pyramid.rangeOf(nSeries, columns[c].nFirst, columns[c].nEnd);
+                    if(range.nCount == 0)
+                        continue;
+
+                    if(nLast >= 0 && pyramid.getTime(columns[c].nFirst) - pyramid.getTime(nLast) > HISTORY_CHART_GAP) {
+                        painter.drawPolyline(line);
+                        line.clear();
+                        }
+                    nLast = columns[c].nEnd - 1;
+
+                    double x = plot.left() + c + 0.5;
+                    line.append(QPointF(x, paneRect.bottom() - double(range.max - fMin) * yScale));
+                    line.append(QPointF(x, paneRect.bottom() - double(range.min - fMin) * yScale));
+                    }
+                }
+
+            if(line.size() > 0)
+                painter.drawPolyline(line);
+            }
+        painter.restore();
+        }
+
+    // Times along the bottom, with the date if the view spans more than a day
+    QString qsFormat = (nViewTo - nViewFrom > 24LL * 3600LL * 1000LL) ? "MM-dd HH:mm" : "HH:mm:ss";
+    painter.setPen(QPen(QColor(198, 198, 198)));
+    for(int i = 0; i <= 4; i++) {
+        int x = plot.left() + (plot.width() * i) / 4;
+        QString qsTime = QDateTime::fromMSecsSinceEpoch(timeAt(x)).toString(qsFormat);
+        int nAlign = (i == 0) ? Qt::AlignLeft : (i == 4) ? Qt::AlignRight : Qt::AlignHCenter;
+        painter.drawText(QRect(x - 60, plot.bottom() + 4, 120, 16), nAlign, qsTime);
+        }
+}
+
+///////////////////////////////////////////////////////////////////////
+// Zoom in or out, keeping the time under the pointer where it is
+void HistoryChart::wheelEvent(QWheelEvent *event)
+{
+    event->accept();
+    if(pyramid.size() == 0)
+        return;
+
+    double factor = pow(0.8, double(event->angleDelta().y()) / 120.0);
+    int x = int(event->position().x());
+    int64_t nAnchor = timeAt(x);
+
+    int64_t nFullSpan = pyramid.getTime(pyramid.size() - 1) - pyramid.getTime(0);
+    int64_t nSpan = int64_t(double(nViewTo - nViewFrom) * factor);
+    if(nSpan < HISTORY_CHART_MIN_SPAN)
+        nSpan = HISTORY_CHART_MIN_SPAN;
+    if(nSpan > nFullSpan * 2 && nSpan > HISTORY_CHART_MIN_SPAN)
+        nSpan = (nFullSpan * 2 > HISTORY_CHART_MIN_SPAN) ? nFullSpan * 2 : HISTORY_CHART_MIN_SPAN;
+
+    QRect plot = plotRect();
+    double fraction = (plot.width() > 0) ? double(x - plot.left()) / double(plot.width()) : 1.0;
+    nViewFrom = nAnchor - int64_t(double(nSpan) * fraction);
+    nViewTo = nViewFrom + nSpan;
+
+    // Still showing the newest? Then keep following it.
+    bFollow = (nViewTo >= pyramid.getTime(pyramid.size() - 1));
+    update();
+}
+
+///////////////////////////////////////////////////////////////////////
+void HistoryChart::mousePressEvent(QMouseEvent *event)
+{
+    if(event->button() != Qt::LeftButton) {
+        QWidget::mousePressEvent(event);
+        return;
+        }
+
+    bDragging = true;
+    nDragX = event->pos().x();
+    nDragFrom = nViewFrom;
+    nDragTo = nViewTo;
+    event->accept();
+}
+
+void HistoryChart::mouseMoveEvent(QMouseEvent *event)
+{
+    if(!bDragging || pyramid.size() == 0)
+        return;
+
+    QRect plot = plotRect();
+    if(plot.width() <= 0)
+        return;
+
+    int64_t nShift = ((nDragTo - nDragFrom) * int64_t(nDragX - event->pos().x())) / int64_t(plot.width());
+    nViewFrom = nDragFrom + nShift;
+    nViewTo = nDragTo + nShift;
+    bFollow = (nViewTo >= pyramid.getTime(pyramid.size() - 1));
+    event->accept();
+    update();
+}
+
+void HistoryChart::mouseReleaseEvent(QMouseEvent *event)
+{
+    bDragging = false;
+    event->accept();
+}
+
+void HistoryChart::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    event->accept();
+    showEverything();
+    update();
+}
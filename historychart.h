@@ -0,0 +1,106 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* History chart. Center wavelength and target, heater temperatures, heater drive and
+ * supply voltage, one above the other, over whatever stretch of time is in view. Wheel
+ * zooms around the pointer, dragging pans, double click goes back to showing it all
+ * and following new samples as they come in.
+ *
+ * Everything goes through a min/max pyramid (quantumlod.h), so drawing costs the same
+ * for a minute or a whole day. Zoomed in far enough that there are fewer samples than
+ * pixels, the samples are drawn as they are.
+*/
+#ifndef HISTORYCHART_H
+#define HISTORYCHART_H
+
+#include <QWidget>
+#include <QPaintEvent>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QPolygonF>
+
+#include "quantumlod.h"
+#include "quantumrecorder.h"
+
+#define HISTORY_CHART_MAX_SAMPLES   QUANTUM_RECORDER_CAPACITY   // Same as the ring holds
+#define HISTORY_CHART_GAP           60000       // No line across a gap this long (ms)
+#define HISTORY_CHART_MIN_SPAN      10000       // Can't zoom in closer than this (ms)
+
+enum HistorySeries {
+    HSERIES_WAVELENGTH = 0,
+    HSERIES_TARGET,
+    HSERIES_HEATER1_TEMPERATURE,
+    HSERIES_HEATER2_TEMPERATURE,
+    HSERIES_HEATER1_PWM,
+    HSERIES_HEATER2_PWM,
+    HSERIES_VOLTAGE,
+    HSERIES_COUNT
+};
+
+class HistoryChart : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit HistoryChart(QWidget *parent);
+
+    // The target is drawn as this plus the wingshift
+    inline void SetDesignWavelength(float fCenter)  { fDesignWavelength = fCenter; }
+
+    // Adds to the end, call update() when done adding
+    void appendRecord(const QuantumRecord& record);
+    void clear(void);
+
+    int getSampleCount(void) const { return pyramid.size(); }
+
+protected:
+    QuantumLodPyramid   pyramid;
+    float               fDesignWavelength = 0.0f;
+    bool                bDualHeaters = false;   // Seen any samples with two heaters
+
+    // What's in view, milliseconds since the epoch
+    int64_t             nViewFrom = 0;
+    int64_t             nViewTo = 0;
+    bool                bFollow = true;         // Keep the newest sample in view
+
+    bool                bDragging = false;
+    int                 nDragX = 0;
+    int64_t             nDragFrom = 0;
+    int64_t             nDragTo = 0;
+
+    // Kept between paints so drawing doesn't allocate
+    QVector<QuantumLodColumn> columns;
+    QPolygonF           line;
+
+    QRect plotRect(void) const;
+    void showEverything(void);
+    int64_t timeAt(int x) const;
+
+    virtual void paintEvent(QPaintEvent *event) override;
+    virtual void wheelEvent(QWheelEvent *event) override;
+    virtual void mousePressEvent(QMouseEvent *event) override;
+    virtual void mouseMoveEvent(QMouseEvent *event) override;
+    virtual void mouseReleaseEvent(QMouseEvent *event) override;
+    virtual void mouseDoubleClickEvent(QMouseEvent *event) override;
+};
+
+#endif // HISTORYCHART_H
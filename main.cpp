@@ -23,11 +23,16 @@ SOFTWARE
 */
 
 #include "mainwindow.h"
+#include "quantumtrace.h"
+#include "quantumprocess.h"
 
 #include <QApplication>
 
+#include <string.h>
+
 int main(int argc, char *argv[])
 {
+    quantumProcessStarted();
 
     QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
     QCoreApplication::setApplicationName("Quantum Control");
@@ -36,8 +41,25 @@ int main(int argc, char *argv[])
     QCoreApplication::setApplicationVersion(QUANTUM_VERSION);
 
 
+    // QUANTUM_TRACE=trace.json records where the time goes, see quantumtrace.h
+    QByteArray traceFile = qgetenv("QUANTUM_TRACE");
+    if(!traceFile.isEmpty()) {
+        quantumTraceStart(traceFile.constData());
+        quantumTraceThreadName("GUI");
+        }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
-    return a.exec();
+
+    // --port <name or path> connects without going through the list
+    for(int i = 1; i + 1 < argc; i++)
+        if(strcmp(argv[i], "--port") == 0)
+            w.connectToPort(QString::fromLocal8Bit(argv[i+1]));
+    int nResult = a.exec();
+
+    if(!traceFile.isEmpty())
+        quantumTraceStop();
+
+    return nResult;
 }
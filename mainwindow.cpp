@@ -28,6 +28,7 @@ SOFTWARE
 
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "quantumprocess.h"
 
 #include <iostream>
 
@@ -37,7 +38,11 @@ MainWindow::MainWindow(QWidget *parent)
 {
     ui->setupUi(this);
     this->statusBar()->showMessage(tr("Quantum Not Connected"));
-    pSerialChooser = new SerialChooser(this);
+
+    // All device I/O happens on the manager's thread
+    pDeviceManager = new QuantumDeviceManager(this);
+
+    pSerialChooser = new SerialChooser(this, pDeviceManager);
     this->setCentralWidget(pSerialChooser);
 
     connect(pSerialChooser, SIGNAL(connectedToQuantum(QuantumDevice*)), this, SLOT(quantumHasConnected(QuantumDevice*)), Qt::QueuedConnection);
@@ -50,31 +55,45 @@ MainWindow::~MainWindow()
 
 void MainWindow::closeEvent(QCloseEvent *event)
 {
-    if(pQuantumDevice) {
-        pQuantumDevice->exit();
-        if(!pQuantumDevice->wait(500))
-            pQuantumDevice->terminate();
+    // Its clients read from the device
+    delete pAlpacaServer;
+    pAlpacaServer = nullptr;
+    removeQuantumGui();
 
-        delete pQuantumDevice;
+    if(pQuantumDevice) {
+        pDeviceManager->removeDevice(pQuantumDevice);
         pQuantumDevice = nullptr;
         }
 
+    pDeviceManager->shutdown();
+
     event->accept();
 }
 
+//////////////////////////////////////////////////////////////////////
+// The GUI and its dialogs (its children) hold on to the device, and have
+// timers and queued status updates that use it. They go before it does.
+void MainWindow::removeQuantumGui(void)
+{
+    if(pQuantumGui == nullptr)
+        return;
+
+    takeCentralWidget();
+    delete pQuantumGui;
+    pQuantumGui = nullptr;
+}
+
 void MainWindow::quantumHasDropped(int nErrorCode)
 {
     (void)nErrorCode; // For future use
-    pQuantumDevice->exit();
-    
+    delete pAlpacaServer;
+    pAlpacaServer = nullptr;
+    removeQuantumGui();
+    pDeviceManager->removeDevice(pQuantumDevice);
+    pQuantumDevice = nullptr;
+
     QMessageBox::critical(this, tr("Quantum Solar Filter"), tr("The connection has been lost to the Quantum Solar Filter and this program will now close."),
         QMessageBox::Ok);
-     
-    if(!pQuantumDevice->wait(500))
-        pQuantumDevice->terminate();
-
-    delete pQuantumDevice;
-    pQuantumDevice = nullptr;
 
     close();
 }
@@ -89,6 +108,24 @@ void MainWindow::quantumHasConnected(QuantumDevice *pDevice)
     pQuantumDevice = pDevice;
     
     connect(pQuantumDevice, SIGNAL(fatalError(int)), this, SLOT(quantumHasDropped(int)), Qt::QueuedConnection);
+    connect(pQuantumDevice, SIGNAL(staticInfoChanged()), this, SLOT(updateStatusBar()), Qt::QueuedConnection);
+
+    // QUANTUM_PUSH_PORT=5280 shares status with other programs, see quantumpush.h
+    int nPushPort = qgetenv("QUANTUM_PUSH_PORT").toInt();
+    if(nPushPort > 0)
+        pQuantumDevice->startPushServer(quint16(nPushPort));
+
+    // QUANTUM_SHM_NAME=/quantumcontrol puts every sample in shared memory, see quantumshm.h
+    QByteArray shmName = qgetenv("QUANTUM_SHM_NAME");
+    if(!shmName.isEmpty())
+        pQuantumDevice->startSharedStatus(QString::fromLocal8Bit(shmName));
+
+    // QUANTUM_ALPACA_PORT=11111 serves the filter to ASCOM Alpaca clients, see quantumalpaca.h
+    int nAlpacaPort = qgetenv("QUANTUM_ALPACA_PORT").toInt();
+    if(nAlpacaPort > 0) {
+        pAlpacaServer = new QuantumAlpacaServer(this, pQuantumDevice);
+        pAlpacaServer->start(quint16(nAlpacaPort));
+        }
 
     // Serial chooser is no longer needed and in the way
     pSerialChooser->close();
@@ -101,7 +138,22 @@ void MainWindow::quantumHasConnected(QuantumDevice *pDevice)
 
     QApplication::restoreOverrideCursor();
 
-    // Update the status bar
+    updateStatusBar();
+    pQuantumGui->updateStatusDisplay();
+
+    // For comparing with quantumcli, see quantumprocess.h
+    if(!qgetenv("QUANTUM_STARTUP_STATS").isEmpty())
+        quantumPrintStartupStats("first status");
+}
+
+//////////////////////////////////////////////////////////////////////
+// Who we are connected to. This can change once, right after we connect,
+// if what we remembered about the filter turns out to be out of date.
+void MainWindow::updateStatusBar(void)
+{
+    if(pQuantumDevice == nullptr)
+        return;
+
     QString status = " 0";
     status += pQuantumDevice->getBandwidthString();
     status += pQuantumGui->angstromSymbol;
@@ -118,8 +170,12 @@ void MainWindow::quantumHasConnected(QuantumDevice *pDevice)
     status += "      Firmware: ";
     status += pQuantumDevice->getFirmwareVersion();
 
+    // How long it took to get going
+    status += QString("      Connected in %1 ms").arg(pQuantumDevice->getConnectTime());
+    if(pQuantumDevice->wasConnectedFromCache())
+        status += tr(" (remembered)");
+
     ui->statusbar->showMessage(status);
-    pQuantumGui->updateStatusDisplay();
 }
 
 
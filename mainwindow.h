@@ -42,6 +42,8 @@ SOFTWARE
 
 #include "serialchooser.h"
 #include "quantumgui.h"
+#include "quantumdevicemanager.h"
+#include "quantumalpaca.h"
 
 
 QT_BEGIN_NAMESPACE
@@ -56,17 +58,24 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    // From the command line, --port
+    void connectToPort(const QString& qsPort) { pSerialChooser->connectToPort(qsPort); }
+
 private:
     Ui::MainWindow  *ui;
     SerialChooser   *pSerialChooser = nullptr;
+    QuantumDeviceManager *pDeviceManager = nullptr;
     QuantumDevice   *pQuantumDevice = nullptr;
     QuantumGui      *pQuantumGui = nullptr;
+    QuantumAlpacaServer *pAlpacaServer = nullptr;
 
     virtual void	closeEvent(QCloseEvent *event) override;
+    void removeQuantumGui(void);
 
 public Q_SLOTS:
     void quantumHasConnected(QuantumDevice *pDevice);
     void quantumHasDropped(int nErrorCode);
+    void updateStatusBar(void);
 
 };
 #endif // MAINWINDOW_H
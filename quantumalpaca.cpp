@@ -0,0 +1,641 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+#include "quantumalpaca.h"
+#include "quantumdevice.h"
+#include "quantumtrace.h"
+
+#include <QCoreApplication>
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QUrl>
+#include <math.h>
+#include <string.h>
+
+// Alpaca error numbers, in the JSON reply. HTTP itself only fails for requests
+// that don't make sense at all.
+#define ALPACA_NOT_IMPLEMENTED      0x400
+#define ALPACA_INVALID_VALUE        0x401
+#define ALPACA_VALUE_NOT_SET        0x402
+#define ALPACA_NOT_CONNECTED        0x407
+#define ALPACA_DRIVER_ERROR         0x500
+
+#define ALPACA_SWITCHES             4
+
+static const struct {
+    const char  *szName;
+    const char  *szDescription;
+    double      fMin;
+    double      fMax;
+    double      fStep;
+    } switchTable[ALPACA_SWITCHES] = {
+    { "Wingshift",          "Offset from the design wavelength, Angstroms", -1.0, 1.0, 0.1 },
+    { "On Band",            "1 when the filter is on band",                  0.0, 1.0, 1.0 },
+    { "Heater Temperature", "Heater temperature, degrees F",               -40.0, 212.0, 0.1 },
+    { "Error Status",       "Error code from the filter, 0 for no errors",   0.0, 255.0, 1.0 }
+    };
+
+///////////////////////////////////////////////////////////////////////
+// name=value&name=value, from a query string or a form body
+static void parseParameters(const QByteArray& encoded, QList<QPair<QString, QString> > *pList)
+{
+    QList<QByteArray> pairs = encoded.split('&');
+    for(int i = 0; i < pairs.size(); i++) {
+        if(pairs[i].isEmpty())
+            continue;
+
+        QByteArray pair = pairs[i];
+        pair.replace('+', ' ');
+        int iEquals = pair.indexOf('=');
+        QString qsName = QUrl::fromPercentEncoding(pair.left(iEquals < 0 ? pair.size() : iEquals));
+        QString qsValue = iEquals < 0 ? QString() : QUrl::fromPercentEncoding(pair.mid(iEquals + 1));
+        pList->append(qMakePair(qsName.toLower(), qsValue));
+        }
+}
+
+// Parameter names are not case sensitive
+static bool findParameter(const QList<QPair<QString, QString> >& list, const char *szName, QString *pqsValue)
+{
+    for(int i = 0; i < list.size(); i++)
+        if(list[i].first == QLatin1String(szName)) {
+            *pqsValue = list[i].second;
+            return true;
+            }
+
+    return false;
+}
+
+static bool parseBool(const QString& qsValue, bool *pbValue)
+{
+    if(qsValue.compare(QLatin1String("true"), Qt::CaseInsensitive) == 0)
+        *pbValue = true;
+    else if(qsValue.compare(QLatin1String("false"), Qt::CaseInsensitive) == 0)
+        *pbValue = false;
+    else
+        return false;
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////
+QuantumAlpacaHandler::QuantumAlpacaHandler(QuantumDevice *pQuantumDevice)
+{
+    pDevice = pQuantumDevice;
+}
+
+QuantumAlpacaHandler::~QuantumAlpacaHandler(void)
+{
+    shutdown();
+}
+
+///////////////////////////////////////////////////////////////////////
+// On the server thread. Returns where it's listening, 0 if it couldn't.
+quint16 QuantumAlpacaHandler::listen(quint16 nPort, bool bLoopbackOnly)
+{
+    pServer = new QTcpServer(this);
+    connect(pServer, &QTcpServer::newConnection, this, &QuantumAlpacaHandler::newConnection);
+    if(!pServer->listen(bLoopbackOnly ? QHostAddress(QHostAddress::LocalHost) : QHostAddress(QHostAddress::Any), nPort))
+        return 0;
+
+    // Discovery is for finding us from other machines, so not when we're loopback only.
+    // Other servers on this machine may want the port too.
+    if(!bLoopbackOnly) {
+        pDiscovery = new QUdpSocket(this);
+        if(pDiscovery->bind(QHostAddress(QHostAddress::AnyIPv4), QALPACA_DISCOVERY_PORT, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint))
+            connect(pDiscovery, &QUdpSocket::readyRead, this, &QuantumAlpacaHandler::discoveryReadyRead);
+        }
+
+    return pServer->serverPort();
+}
+
+///////////////////////////////////////////////////////////////////////
+void QuantumAlpacaHandler::shutdown(void)
+{
+    for(int i = 0; i < clientList.size(); i++) {
+        clientList[i]->pSocket->disconnect(this);
+        clientList[i]->pSocket->abort();
+        delete clientList[i]->pSocket;
+        }
+    qDeleteAll(clientList);
+    clientList.clear();
+
+    delete pDiscovery;
+    pDiscovery = nullptr;
+    delete pServer;
+    pServer = nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////
+QuantumAlpacaHandler::AlpacaClient* QuantumAlpacaHandler::findClient(QObject *pSocket)
+{
+    for(int i = 0; i < clientList.size(); i++)
+        if(clientList[i]->pSocket == pSocket)
+            return clientList[i];
+
+    return nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////
+void QuantumAlpacaHandler::newConnection(void)
+{
+    while(pServer->hasPendingConnections()) {
+        QTcpSocket *pSocket = pServer->nextPendingConnection();
+        pSocket->setParent(nullptr);
+        pSocket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+        AlpacaClient *pClient = new AlpacaClient;
+        pClient->pSocket = pSocket;
+        clientList.append(pClient);
+
+        connect(pSocket, &QTcpSocket::readyRead, this, &QuantumAlpacaHandler::clientReadyRead);
+        connect(pSocket, &QTcpSocket::disconnected, this, &QuantumAlpacaHandler::clientDisconnected);
+        }
+}
+
+///////////////////////////////////////////////////////////////////////
+void QuantumAlpacaHandler::clientDisconnected(void)
+{
+    AlpacaClient *pClient = findClient(sender());
+    if(pClient == nullptr)
+        return;
+
+    clientList.removeOne(pClient);
+    pClient->pSocket->deleteLater();
+    delete pClient;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Clients keep the connection open and send one request after another
+void QuantumAlpacaHandler::clientReadyRead(void)
+{
+    AlpacaClient *pClient = findClient(sender());
+    if(pClient == nullptr)
+        return;
+
+    pClient->received.append(pClient->pSocket->readAll());
+    while(handleRequest(pClient))
+        ;
+}
+
+///////////////////////////////////////////////////////////////////////
+// One whole request, if we have it. False when we need more, or the
+// client is gone.
+bool QuantumAlpacaHandler::handleRequest(AlpacaClient *pClient)
+{
+    int iHeaderEnd = pClient->received.indexOf("\r\n\r\n");
+    if(iHeaderEnd < 0) {
+        if(pClient->received.size() > QALPACA_MAX_REQUEST)
+            pClient->pSocket->abort();
+        return false;
+        }
+
+    QList<QByteArray> lines = pClient->received.left(iHeaderEnd).split('\n');
+    QList<QByteArray> requestLine = lines[0].trimmed().split(' ');
+    if(requestLine.size() != 3) {
+        pClient->pSocket->abort();
+        return false;
+        }
+
+    int nContentLength = 0;
+    bool bClose = (requestLine[2] == "HTTP/1.0");
+    for(int i = 1; i < lines.size(); i++) {
+        QByteArray line = lines[i].trimmed();
+        int iColon = line.indexOf(':');
+        if(iColon < 0)
+            continue;
+
+        QByteArray name = line.left(iColon).trimmed().toLower();
+        QByteArray value = line.mid(iColon + 1).trimmed().toLower();
+        if(name == "content-length")
+            nContentLength = value.toInt();
+        else if(name == "connection")
+            bClose = (value == "close") || (bClose && value != "keep-alive");
+        }
+
+    if(nContentLength < 0 || nContentLength > QALPACA_MAX_REQUEST) {
+        pClient->pSocket->abort();
+        return false;
+        }
+
+    int nRequestSize = iHeaderEnd + 4 + nContentLength;
+    if(pClient->received.size() < nRequestSize)
+        return false;
+
+    AlpacaRequest request;
+    request.method = requestLine[0];
+    QByteArray target = requestLine[1];
+    int iQuery = target.indexOf('?');
+    request.qsPath = QUrl::fromPercentEncoding(target.left(iQuery < 0 ? target.size() : iQuery)).toLower();
+    if(request.method == "PUT")
+        parseParameters(pClient->received.mid(iHeaderEnd + 4, nContentLength), &request.parameters);
+    else if(iQuery >= 0)
+        parseParameters(target.mid(iQuery + 1), &request.parameters);
+
+    pClient->received.remove(0, nRequestSize);
+
+    respond(pClient, request);
+
+    if(bClose) {
+        pClient->pSocket->disconnectFromHost();
+        return false;
+        }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////
+void QuantumAlpacaHandler::sendResponse(AlpacaClient *pClient, int nHttpStatus, const char *szContentType, const QByteArray& body)
+{
+    const char *szReason = "OK";
+    if(nHttpStatus == 400)
+        szReason = "Bad Request";
+    else if(nHttpStatus == 404)
+        szReason = "Not Found";
+
+    QByteArray response = QByteArray("HTTP/1.1 ") + QByteArray::number(nHttpStatus) + " " + szReason + "\r\n";
+    response += QByteArray("Content-Type: ") + szContentType + "\r\n";
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n\r\n";
+    response += body;
+    pClient->pSocket->write(response);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Every Alpaca reply has the value, the transaction numbers, and an error
+// number that's 0 when all is well
+QByteArray QuantumAlpacaHandler::alpacaReply(const AlpacaRequest& request, const QJsonValue& value, int nErrorNumber, const QString& qsErrorMessage)
+{
+    QString qsClientTransaction;
+    quint32 nClientTransaction = 0;
+    if(findParameter(request.parameters, "clienttransactionid", &qsClientTransaction))
+        nClientTransaction = qsClientTransaction.toUInt();
+
+    QJsonObject reply;
+    if(!value.isUndefined())
+        reply.insert("Value", value);
+    reply.insert("ClientTransactionID", qint64(nClientTransaction));
+    reply.insert("ServerTransactionID", qint64(++nServerTransaction));
+    reply.insert("ErrorNumber", nErrorNumber);
+    reply.insert("ErrorMessage", qsErrorMessage);
+
+    return QJsonDocument(reply).toJson(QJsonDocument::Compact);
+}
+
+///////////////////////////////////////////////////////////////////////
+void QuantumAlpacaHandler::respond(AlpacaClient *pClient, const AlpacaRequest& request)
+{
+    QUANTUM_TRACE_SCOPE("alpaca request");
+
+    static const char szJson[] = "application/json";
+    static const char szDevicePath[] = "/api/v1/switch/0/";
+    const QString& qsPath = request.qsPath;
+
+    if(qsPath == "/management/apiversions") {
+        QJsonArray versions;
+        versions.append(1);
+        sendResponse(pClient, 200, szJson, alpacaReply(request, versions));
+        return;
+        }
+
+    if(qsPath == "/management/v1/description") {
+        QJsonObject description;
+        description.insert("ServerName", "Quantum Control");
+        description.insert("Manufacturer", "Starstone Software Systems, Inc.");
+        description.insert("ManufacturerVersion", QCoreApplication::applicationVersion());
+        description.insert("Location", "");
+        sendResponse(pClient, 200, szJson, alpacaReply(request, description));
+        return;
+        }
+
+    if(qsPath == "/management/v1/configureddevices") {
+        QuantumStaticInfo info = pDevice->getStaticInfo();
+        QJsonObject device;
+        device.insert("DeviceName", "Quantum " + info.qsSerialNumber);
+        device.insert("DeviceType", "Switch");
+        device.insert("DeviceNumber", 0);
+        device.insert("UniqueID", "daystar-quantum-" + info.qsSerialNumber);
+        QJsonArray devices;
+        devices.append(device);
+        sendResponse(pClient, 200, szJson, alpacaReply(request, devices));
+        return;
+        }
+
+    // Nothing to set up, it's all done in Quantum Control
+    if(qsPath == "/setup" || qsPath == "/setup/v1/switch/0/setup") {
+        sendResponse(pClient, 200, "text/html", "<html><body><p>The Quantum is set up in Quantum Control.</p></body></html>");
+        return;
+        }
+
+    if(!qsPath.startsWith(szDevicePath)) {
+        sendResponse(pClient, 404, "text/plain", "No such device or method\n");
+        return;
+        }
+
+    QJsonValue value(QJsonValue::Undefined);
+    QString qsError;
+    int nHttpStatus = 200;
+    int nErrorNumber = switchMethod(request, qsPath.mid(int(sizeof(szDevicePath)) - 1), &value, &qsError, &nHttpStatus);
+    if(nHttpStatus != 200)
+        sendResponse(pClient, nHttpStatus, "text/plain", qsError.toUtf8() + "\n");
+    else
+        sendResponse(pClient, 200, szJson, alpacaReply(request, value, nErrorNumber, qsError));
+}
+
+///////////////////////////////////////////////////////////////////////
+// The common device methods, and ISwitchV2. Returns the Alpaca error number.
+// Requests that are malformed, rather than wrong, get an HTTP error instead.
+int QuantumAlpacaHandler::switchMethod(const AlpacaRequest& request, const QString& qsMethod, QJsonValue* pValue, QString* pqsError, int* pnHttpStatus)
+{
+    bool bPut = (request.method == "PUT");
+    bool bSetter = qsMethod == "action" || qsMethod.startsWith("command") || qsMethod.startsWith("setswitch");
+    if(qsMethod != "connected" && bPut != bSetter) {
+        *pnHttpStatus = 400;
+        *pqsError = QString("%1 is a %2 method").arg(qsMethod, bSetter ? "PUT" : "GET");
+        return 0;
+        }
+
+    // No Id needed
+    if(qsMethod == "connected") {
+        if(!bPut) {
+            *pValue = bConnected;
+            return 0;
+            }
+
+        QString qsConnected;
+        bool bValue;
+        if(!findParameter(request.parameters, "connected", &qsConnected) || !parseBool(qsConnected, &bValue)) {
+            *pnHttpStatus = 400;
+            *pqsError = "Connected must be True or False";
+            return 0;
+            }
+
+        bConnected = bValue;
+        return 0;
+        }
+
+    if(qsMethod == "description") {
+        *pValue = QString("Daystar Quantum solar filter");
+        return 0;
+        }
+
+    if(qsMethod == "driverinfo") {
+        *pValue = QString("Quantum Control's Alpaca server. Wingshift is settable, on band, temperature and errors are read only.");
+        return 0;
+        }
+
+    if(qsMethod == "driverversion") {
+        *pValue = QCoreApplication::applicationVersion();
+        return 0;
+        }
+
+    if(qsMethod == "interfaceversion") {
+        *pValue = 2;
+        return 0;
+        }
+
+    if(qsMethod == "name") {
+        *pValue = "Quantum " + pDevice->getStaticInfo().qsSerialNumber;
+        return 0;
+        }
+
+    if(qsMethod == "supportedactions") {
+        *pValue = QJsonArray();
+        return 0;
+        }
+
+    if(qsMethod == "maxswitch") {
+        *pValue = ALPACA_SWITCHES;
+        return 0;
+        }
+
+    if(qsMethod == "action" || qsMethod.startsWith("command") || qsMethod == "setswitchname") {
+        *pqsError = qsMethod + " is not implemented";
+        return ALPACA_NOT_IMPLEMENTED;
+        }
+
+    static const char *szIdMethods[] = { "canwrite", "getswitchname", "getswitchdescription", "minswitchvalue", "maxswitchvalue",
+                                         "switchstep", "getswitch", "getswitchvalue", "setswitch", "setswitchvalue" };
+    bool bKnown = false;
+    for(size_t i = 0; i < sizeof(szIdMethods) / sizeof(szIdMethods[0]); i++)
+        if(qsMethod == QLatin1String(szIdMethods[i]))
+            bKnown = true;
+
+    if(!bKnown) {
+        *pnHttpStatus = 400;
+        *pqsError = QString("No such method %1").arg(qsMethod);
+        return 0;
+        }
+
+    // Everything from here on is about one switch
+    QString qsId;
+    if(!findParameter(request.parameters, "id", &qsId)) {
+        *pnHttpStatus = 400;
+        *pqsError = "Id is missing";
+        return 0;
+        }
+
+    bool bOk;
+    int nId = qsId.toInt(&bOk);
+    if(!bOk || nId < 0 || nId >= ALPACA_SWITCHES) {
+        *pqsError = QString("Switch %1 does not exist").arg(qsId);
+        return ALPACA_INVALID_VALUE;
+        }
+
+    if(qsMethod == "canwrite") {
+        *pValue = (nId == 0);
+        return 0;
+        }
+
+    if(qsMethod == "getswitchname") {
+        *pValue = QString(switchTable[nId].szName);
+        return 0;
+        }
+
+    if(qsMethod == "getswitchdescription") {
+        *pValue = QString(switchTable[nId].szDescription);
+        return 0;
+        }
+
+    if(qsMethod == "minswitchvalue") {
+        *pValue = switchTable[nId].fMin;
+        return 0;
+        }
+
+    if(qsMethod == "maxswitchvalue") {
+        *pValue = switchTable[nId].fMax;
+        return 0;
+        }
+
+    if(qsMethod == "switchstep") {
+        *pValue = switchTable[nId].fStep;
+        return 0;
+        }
+
+    // Left are the ones that need the filter
+    if(!bConnected) {
+        *pqsError = "Not connected";
+        return ALPACA_NOT_CONNECTED;
+        }
+
+    if(qsMethod == "setswitch" || qsMethod == "setswitchvalue") {
+        if(nId != 0) {
+            *pqsError = QString("%1 is read only").arg(switchTable[nId].szName);
+            return ALPACA_NOT_IMPLEMENTED;
+            }
+
+        // On is all the way up, off all the way down
+        double fWingshift;
+        QString qsValue;
+        if(qsMethod == "setswitch") {
+            bool bState;
+            if(!findParameter(request.parameters, "state", &qsValue) || !parseBool(qsValue, &bState)) {
+                *pnHttpStatus = 400;
+                *pqsError = "State must be True or False";
+                return 0;
+                }
+            fWingshift = bState ? switchTable[0].fMax : switchTable[0].fMin;
+            }
+        else {
+            if(!findParameter(request.parameters, "value", &qsValue)) {
+                *pnHttpStatus = 400;
+                *pqsError = "Value is missing";
+                return 0;
+                }
+            fWingshift = qsValue.toDouble(&bOk);
+            if(!bOk || !(fWingshift >= switchTable[0].fMin - 0.001 && fWingshift <= switchTable[0].fMax + 0.001)) {
+                *pqsError = QString("Wingshift %1 is out of range").arg(qsValue);
+                return ALPACA_INVALID_VALUE;
+                }
+            }
+
+        if(!pDevice->addCommand(QuantumCommand::setWingshift(int(lround(fWingshift * 10.0))))) {
+            *pqsError = "Too many commands waiting for the filter";
+            return ALPACA_DRIVER_ERROR;
+            }
+
+        return 0;
+        }
+
+    // getswitch or getswitchvalue, straight from the latest sample
+    QuantumStatusSnapshot snapshot;
+    pDevice->getStatusSnapshot(&snapshot);
+    if(snapshot.nSequence == 0) {
+        *pqsError = "No status from the filter yet";
+        return ALPACA_VALUE_NOT_SET;
+        }
+
+    double fValue = 0.0;
+    switch(nId) {
+        case 0:
+            fValue = double(lroundf(snapshot.status.wingShift * 10.0f)) * 0.1;
+            break;
+        case 1:
+            fValue = snapshot.status.bOnBand ? 1.0 : 0.0;
+            break;
+        case 2:
+            fValue = double(lroundf(snapshot.status.heater1Temprature * 10.0f)) * 0.1;
+            break;
+        case 3:
+            fValue = double(snapshot.status.nErrorCode);
+            break;
+        }
+
+    if(qsMethod == "getswitch")
+        *pValue = (fValue != switchTable[nId].fMin);
+    else
+        *pValue = fValue;
+
+    return 0;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Alpaca discovery. Anyone asking gets told which port we're on.
+void QuantumAlpacaHandler::discoveryReadyRead(void)
+{
+    while(pDiscovery->hasPendingDatagrams()) {
+        char szDatagram[64];
+        QHostAddress sender;
+        quint16 nSenderPort = 0;
+        qint64 nSize = pDiscovery->readDatagram(szDatagram, sizeof(szDatagram), &sender, &nSenderPort);
+        if(nSize < 16 || memcmp(szDatagram, "alpacadiscovery1", 16) != 0)
+            continue;
+
+        QByteArray reply = "{\"AlpacaPort\":" + QByteArray::number(pServer->serverPort()) + "}";
+        pDiscovery->writeDatagram(reply, sender, nSenderPort);
+        }
+}
+
+
+///////////////////////////////////////////////////////////////////////
+QuantumAlpacaServer::QuantumAlpacaServer(QObject *parent, QuantumDevice *pQuantumDevice) : QObject(parent)
+{
+    pDevice = pQuantumDevice;
+}
+
+QuantumAlpacaServer::~QuantumAlpacaServer(void)
+{
+    stop();
+}
+
+///////////////////////////////////////////////////////////////////////
+// The handler is moved to the thread before it makes any sockets, so they
+// all belong to the server thread
+bool QuantumAlpacaServer::start(quint16 nPort, bool bLoopbackOnly)
+{
+    stop();
+
+    pThread = new QThread(this);
+    pThread->setObjectName("Quantum Alpaca");
+    pThread->start();
+
+    pHandler = new QuantumAlpacaHandler(pDevice);
+    pHandler->moveToThread(pThread);
+
+    QMetaObject::invokeMethod(pHandler, "listen", Qt::BlockingQueuedConnection, Q_RETURN_ARG(quint16, nListening),
+                              Q_ARG(quint16, nPort), Q_ARG(bool, bLoopbackOnly));
+    if(nListening == 0) {
+        stop();
+        return false;
+        }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////
+// The handler goes when its thread finishes
+void QuantumAlpacaServer::stop(void)
+{
+    if(pThread == nullptr)
+        return;
+
+    QMetaObject::invokeMethod(pHandler, "shutdown", Qt::BlockingQueuedConnection);
+    pHandler->deleteLater();
+    pHandler = nullptr;
+
+    pThread->quit();
+    pThread->wait();
+    delete pThread;
+    pThread = nullptr;
+    nListening = 0;
+}
@@ -0,0 +1,130 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* ASCOM Alpaca, so automation software can find and drive the filter over HTTP while
+ * Quantum Control owns the serial port. The filter shows up as Switch device 0
+ * (ISwitchV2), with these switches:
+ *
+ *   0  Wingshift            -1.0 to 1.0 Angstroms in tenths, the only one you can set
+ *   1  On Band              1 when on band
+ *   2  Heater Temperature   Degrees F
+ *   3  Error Status         The Quantum's error code, 0 for none
+ *
+ * Everything read comes from the latest published sample, the same one the GUI
+ * shows, so polling it costs nothing at the device however often it's done. Setting
+ * the wingshift queues the command like the GUI's own buttons.
+ *
+ * The server has a thread of its own, so busy clients don't hold up the serial port
+ * or the GUI. Loopback only unless asked otherwise, in which case it also answers
+ * Alpaca discovery broadcasts.
+*/
+#ifndef QUANTUMALPACA_H
+#define QUANTUMALPACA_H
+
+#include <QObject>
+#include <QThread>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUdpSocket>
+#include <QList>
+#include <QPair>
+#include <QByteArray>
+#include <QJsonValue>
+
+#define QALPACA_DEFAULT_PORT        11111
+#define QALPACA_DISCOVERY_PORT      32227
+#define QALPACA_MAX_REQUEST         8192    // Header or body, anything bigger isn't a real client
+
+class QuantumDevice;
+
+/////////////////////////////////////////////////////////////
+/// Runs on the server thread, does the actual work
+class QuantumAlpacaHandler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QuantumAlpacaHandler(QuantumDevice *pQuantumDevice);
+    ~QuantumAlpacaHandler(void);
+
+protected:
+    struct AlpacaClient {
+        QTcpSocket  *pSocket = nullptr;
+        QByteArray  received;               // Partial request
+    };
+
+    // One parsed request
+    struct AlpacaRequest {
+        QByteArray  method;                 // GET or PUT
+        QString     qsPath;                 // Lower case
+        QList<QPair<QString, QString> > parameters;     // Names lower case
+    };
+
+    QuantumDevice   *pDevice = nullptr;
+    QTcpServer      *pServer = nullptr;
+    QUdpSocket      *pDiscovery = nullptr;
+    QList<AlpacaClient*> clientList;
+    quint32         nServerTransaction = 0;
+    bool            bConnected = false;     // As far as Alpaca clients are concerned
+
+    AlpacaClient* findClient(QObject *pSocket);
+    bool handleRequest(AlpacaClient *pClient);
+    void respond(AlpacaClient *pClient, const AlpacaRequest& request);
+    void sendResponse(AlpacaClient *pClient, int nHttpStatus, const char *szContentType, const QByteArray& body);
+    QByteArray alpacaReply(const AlpacaRequest& request, const QJsonValue& value, int nErrorNumber = 0, const QString& qsErrorMessage = QString());
+    int switchMethod(const AlpacaRequest& request, const QString& qsMethod, QJsonValue* pValue, QString* pqsError, int* pnHttpStatus);
+
+public Q_SLOTS:
+    quint16 listen(quint16 nPort, bool bLoopbackOnly);
+    void shutdown(void);
+
+protected Q_SLOTS:
+    void newConnection(void);
+    void clientReadyRead(void);
+    void clientDisconnected(void);
+    void discoveryReadyRead(void);
+};
+
+
+/////////////////////////////////////////////////////////////
+/// Owns the server thread. Start and stop it from the thread that made it.
+class QuantumAlpacaServer : public QObject
+{
+    Q_OBJECT
+public:
+    QuantumAlpacaServer(QObject *parent, QuantumDevice *pQuantumDevice);
+    ~QuantumAlpacaServer(void);
+
+    // Waits until it is listening, or isn't going to be. False if the port is taken.
+    bool start(quint16 nPort = QALPACA_DEFAULT_PORT, bool bLoopbackOnly = true);
+    void stop(void);
+
+    quint16 getPort(void) const { return nListening; }
+
+protected:
+    QuantumDevice           *pDevice = nullptr;
+    QThread                 *pThread = nullptr;
+    QuantumAlpacaHandler    *pHandler = nullptr;
+    quint16                 nListening = 0;
+};
+
+#endif // QUANTUMALPACA_H
@@ -0,0 +1,525 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+#include <string.h>
+#include <math.h>
+
+#include <QMap>
+
+#include "quantumarchive.h"
+
+#define QUANTUM_ARCHIVE_MAGIC       "QSFARCH"
+#define QUANTUM_ARCHIVE_END         "QSFAEND"
+#define QUANTUM_ARCHIVE_VERSION     1
+
+// Scales match what the Quantum sends, see quantumparser.cpp. PWM is a percentage
+// worked out from two integers, it gets hundredths.
+const QuantumArchiveColumnInfo quantumArchiveColumns[QARC_COLUMN_COUNT] = {
+    { "time",                   1 },
+    { "centerWavelength",       10 },
+    { "wingShift",              10 },
+    { "heater1Temperature",     100 },
+    { "heater2Temperature",     100 },
+    { "heater1PWM",             100 },
+    { "heater2PWM",             100 },
+    { "inputVoltage",           100 },
+    { "errorCode",              1 },
+    { "heater1PWMLimit",        1 },
+    { "heater2PWMLimit",        1 },
+    { "calibrationPotPos",      1 },
+    { "flags",                  1 }
+};
+
+struct QuantumArchiveHeader {
+    char        szMagic[8];
+    uint32_t    nVersion;
+    uint32_t    nColumns;
+};
+
+struct QuantumArchiveFooter {
+    uint64_t    nIndexOffset;
+    uint32_t    nChunks;
+    uint32_t    nColumns;
+    char        szMagic[8];
+};
+
+static_assert(sizeof(QuantumArchiveColumnIndex) == 56, "The index is part of the file format");
+static_assert(sizeof(QuantumArchiveFooter) == 24, "The footer is part of the file format");
+
+
+///////////////////////////////////////////////////////////////////////
+int quantumArchiveFindColumn(const char* szName)
+{
+    for(int i = 0; i < QARC_COLUMN_COUNT; i++)
+        if(strcmp(quantumArchiveColumns[i].szName, szName) == 0)
+            return i;
+
+    return -1;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Bits it takes to hold anything from 0 to nRange
+static int bitsFor(uint64_t nRange)
+{
+    int nBits = 0;
+    while(nRange != 0) {
+        nBits++;
+        nRange >>= 1;
+        }
+
+    return nBits;
+}
+
+// Values are packed low bit first, one after the other, with no padding
+static void packBits(uint8_t* pBuffer, uint64_t& nBitPos, uint64_t nValue, int nBits)
+{
+    while(nBits > 0) {
+        int nShift = int(nBitPos & 7);
+        int nTake = (8 - nShift < nBits) ? 8 - nShift : nBits;
+        pBuffer[nBitPos >> 3] |= uint8_t((nValue & ((1u << nTake) - 1)) << nShift);
+        nValue >>= nTake;
+        nBitPos += uint64_t(nTake);
+        nBits -= nTake;
+        }
+}
+
+static uint64_t unpackBits(const uint8_t* pBuffer, uint64_t& nBitPos, int nBits)
+{
+    uint64_t nValue = 0;
+    int nHave = 0;
+    while(nHave < nBits) {
+        int nShift = int(nBitPos & 7);
+        int nTake = (8 - nShift < nBits - nHave) ? 8 - nShift : nBits - nHave;
+        uint64_t nPart = (pBuffer[nBitPos >> 3] >> nShift) & ((1u << nTake) - 1);
+        nValue |= nPart << nHave;
+        nBitPos += uint64_t(nTake);
+        nHave += nTake;
+        }
+
+    return nValue;
+}
+
+static inline int64_t quantize(float value, int nScale)
+{
+    return int64_t(llround(double(value) * double(nScale)));
+}
+
+
+///////////////////////////////////////////////////////////////////////
+QuantumArchiveWriter::QuantumArchiveWriter(void)
+{
+    for(int i = 0; i < QARC_COLUMN_COUNT; i++)
+        columns[i].reserve(QUANTUM_ARCHIVE_CHUNK);
+}
+
+QuantumArchiveWriter::~QuantumArchiveWriter(void)
+{
+    if(file.isOpen())
+        close();
+}
+
+///////////////////////////////////////////////////////////////////////
+bool QuantumArchiveWriter::open(const QString& qsFileName)
+{
+    file.setFileName(qsFileName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    for(int i = 0; i < QARC_COLUMN_COUNT; i++)
+        columns[i].clear();
+    chunkIndex.clear();
+    nSamples = 0;
+    bFailed = false;
+
+    QuantumArchiveHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.szMagic, QUANTUM_ARCHIVE_MAGIC, sizeof(header.szMagic));
+    header.nVersion = QUANTUM_ARCHIVE_VERSION;
+    header.nColumns = QARC_COLUMN_COUNT;
+
+    if(file.write(reinterpret_cast<const char*>(&header), sizeof(header)) != qint64(sizeof(header))) {
+        file.close();
+        return false;
+        }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////
+void QuantumArchiveWriter::append(const QuantumRecord& record)
+{
+    const QuantumArchiveColumnInfo* pInfo = quantumArchiveColumns;
+
+    columns[QARC_TIME].append(record.nWallTime);
+    columns[QARC_CENTER_WAVELENGTH].append(quantize(record.centerWavelength, pInfo[QARC_CENTER_WAVELENGTH].nScale));
+    columns[QARC_WINGSHIFT].append(quantize(record.wingShift, pInfo[QARC_WINGSHIFT].nScale));
+    columns[QARC_HEATER1_TEMPERATURE].append(quantize(record.heater1Temperature, pInfo[QARC_HEATER1_TEMPERATURE].nScale));
+    columns[QARC_HEATER2_TEMPERATURE].append(quantize(record.heater2Temperature, pInfo[QARC_HEATER2_TEMPERATURE].nScale));
+    columns[QARC_HEATER1_PWM].append(quantize(record.heater1PWM, pInfo[QARC_HEATER1_PWM].nScale));
+    columns[QARC_HEATER2_PWM].append(quantize(record.heater2PWM, pInfo[QARC_HEATER2_PWM].nScale));
+    columns[QARC_INPUT_VOLTAGE].append(quantize(record.inputVoltage, pInfo[QARC_INPUT_VOLTAGE].nScale));
+    columns[QARC_ERROR_CODE].append(record.nErrorCode);
+    columns[QARC_HEATER1_PWM_LIMIT].append(record.nHeater1PWMLimit);
+    columns[QARC_HEATER2_PWM_LIMIT].append(record.nHeater2PWMLimit);
+    columns[QARC_CALIBRATION_POT].append(record.nCalibrationPotPos);
+    columns[QARC_FLAGS].append(record.nFlags);
+    nSamples++;
+
+    if(columns[QARC_TIME].size() >= QUANTUM_ARCHIVE_CHUNK)
+        flushChunk();
+}
+
+///////////////////////////////////////////////////////////////////////
+// Pack each column of the chunk the smaller of the two ways, and note it in the index
+bool QuantumArchiveWriter::flushChunk(void)
+{
+    int nCount = columns[QARC_TIME].size();
+    if(nCount == 0 || bFailed)
+        return !bFailed;
+
+    QuantumArchiveChunkIndex chunk;
+    memset(&chunk, 0, sizeof(chunk));
+    chunk.nCount = uint32_t(nCount);
+
+    for(int c = 0; c < QARC_COLUMN_COUNT; c++) {
+        const int64_t* pValues = columns[c].constData();
+        QuantumArchiveColumnIndex& index = chunk.columns[c];
+
+        index.nMin = index.nMax = index.nFirst = pValues[0];
+        int64_t nMinDelta = 0, nMaxDelta = 0;
+        for(int i = 0; i < nCount; i++) {
+            int64_t nValue = pValues[i];
+            index.nSum += nValue;
+            if(nValue < index.nMin) index.nMin = nValue;
+            if(nValue > index.nMax) index.nMax = nValue;
+
+            if(i == 0)
+                continue;
+
+            int64_t nDelta = nValue - pValues[i-1];
+            if(i == 1 || nDelta < nMinDelta) nMinDelta = nDelta;
+            if(i == 1 || nDelta > nMaxDelta) nMaxDelta = nDelta;
+            }
+
+        int nDeltaBits = bitsFor(uint64_t(nMaxDelta - nMinDelta));
+        int nOffsetBits = bitsFor(uint64_t(index.nMax - index.nMin));
+        bool bDelta = uint64_t(nDeltaBits) * uint64_t(nCount - 1) < uint64_t(nOffsetBits) * uint64_t(nCount);
+
+        index.nEncoding = bDelta ? QUANTUM_ARCHIVE_DELTA : QUANTUM_ARCHIVE_OFFSET;
+        index.nBits = uint8_t(bDelta ? nDeltaBits : nOffsetBits);
+        index.nBase = bDelta ? nMinDelta : index.nMin;
+
+        uint64_t nTotalBits = uint64_t(index.nBits) * uint64_t(nCount);
+        packed.fill(0, int((nTotalBits + 7) / 8));
+        uint8_t* pPacked = reinterpret_cast<uint8_t*>(packed.data());
+        uint64_t nBitPos = 0;
+
+        if(index.nBits > 0) {
+            if(bDelta) {
+                for(int i = 1; i < nCount; i++)
+                    packBits(pPacked, nBitPos, uint64_t(pValues[i] - pValues[i-1] - index.nBase), index.nBits);
+                }
+            else {
+                for(int i = 0; i < nCount; i++)
+                    packBits(pPacked, nBitPos, uint64_t(pValues[i] - index.nBase), index.nBits);
+                }
+            }
+
+        index.nOffset = uint64_t(file.pos());
+        index.nBytes = uint32_t((nBitPos + 7) / 8);
+        if(index.nBytes > 0 && file.write(packed.constData(), index.nBytes) != qint64(index.nBytes))
+            bFailed = true;
+
+        columns[c].clear();
+        }
+
+    chunkIndex.append(chunk);
+    return !bFailed;
+}
+
+///////////////////////////////////////////////////////////////////////
+bool QuantumArchiveWriter::close(void)
+{
+    if(!file.isOpen())
+        return false;
+
+    flushChunk();
+
+    QuantumArchiveFooter footer;
+    memset(&footer, 0, sizeof(footer));
+    footer.nIndexOffset = uint64_t(file.pos());
+    footer.nChunks = uint32_t(chunkIndex.size());
+    footer.nColumns = QARC_COLUMN_COUNT;
+    memcpy(footer.szMagic, QUANTUM_ARCHIVE_END, sizeof(footer.szMagic));
+
+    qint64 nIndexBytes = qint64(chunkIndex.size()) * qint64(sizeof(QuantumArchiveChunkIndex));
+    if(file.write(reinterpret_cast<const char*>(chunkIndex.constData()), nIndexBytes) != nIndexBytes)
+        bFailed = true;
+
+    if(file.write(reinterpret_cast<const char*>(&footer), sizeof(footer)) != qint64(sizeof(footer)))
+        bFailed = true;
+
+    file.close();
+    return !bFailed;
+}
+
+
+///////////////////////////////////////////////////////////////////////
+QuantumArchiveReader::QuantumArchiveReader(void)
+{
+}
+
+QuantumArchiveReader::~QuantumArchiveReader(void)
+{
+    close();
+}
+
+///////////////////////////////////////////////////////////////////////
+// Check both ends of the file, then read the index. That is all that stays in memory.
+bool QuantumArchiveReader::open(const QString& qsFileName)
+{
+    close();
+
+    file.setFileName(qsFileName);
+    if(!file.open(QIODevice::ReadOnly))
+        return false;
+
+    qint64 nSize = file.size();
+    QuantumArchiveHeader header;
+    QuantumArchiveFooter footer;
+    if(nSize < qint64(sizeof(header) + sizeof(footer))
+            || file.read(reinterpret_cast<char*>(&header), sizeof(header)) != qint64(sizeof(header))
+            || !file.seek(nSize - qint64(sizeof(footer)))
+            || file.read(reinterpret_cast<char*>(&footer), sizeof(footer)) != qint64(sizeof(footer))) {
+        close();
+        return false;
+        }
+
+    if(memcmp(header.szMagic, QUANTUM_ARCHIVE_MAGIC, sizeof(header.szMagic)) != 0
+            || memcmp(footer.szMagic, QUANTUM_ARCHIVE_END, sizeof(footer.szMagic)) != 0
+            || header.nVersion != QUANTUM_ARCHIVE_VERSION
+            || header.nColumns != QARC_COLUMN_COUNT || footer.nColumns != QARC_COLUMN_COUNT) {
+        close();
+        return false;
+        }
+
+    // The index has to fill exactly the space between the chunks and the footer
+    qint64 nIndexBytes = qint64(footer.nChunks) * qint64(sizeof(QuantumArchiveChunkIndex));
+    if(qint64(footer.nIndexOffset) + nIndexBytes + qint64(sizeof(footer)) != nSize) {
+        close();
+        return false;
+        }
+
+    chunkIndex.resize(int(footer.nChunks));
+    if(!file.seek(qint64(footer.nIndexOffset))
+            || file.read(reinterpret_cast<char*>(chunkIndex.data()), nIndexBytes) != nIndexBytes) {
+        close();
+        return false;
+        }
+
+    nBytesRead = 0;
+    nChunksDecoded = 0;
+    nChunksFromIndex = 0;
+    return true;
+}
+
+void QuantumArchiveReader::close(void)
+{
+    if(file.isOpen())
+        file.close();
+
+    chunkIndex.clear();
+}
+
+///////////////////////////////////////////////////////////////////////
+uint64_t QuantumArchiveReader::getSampleCount(void) const
+{
+    uint64_t nCount = 0;
+    for(int i = 0; i < chunkIndex.size(); i++)
+        nCount += chunkIndex[i].nCount;
+
+    return nCount;
+}
+
+int64_t QuantumArchiveReader::getFirstTime(void) const
+{
+    if(chunkIndex.isEmpty())
+        return 0;
+
+    int64_t nTime = chunkIndex[0].columns[QARC_TIME].nMin;
+    for(int i = 1; i < chunkIndex.size(); i++)
+        if(chunkIndex[i].columns[QARC_TIME].nMin < nTime)
+            nTime = chunkIndex[i].columns[QARC_TIME].nMin;
+
+    return nTime;
+}
+
+int64_t QuantumArchiveReader::getLastTime(void) const
+{
+    if(chunkIndex.isEmpty())
+        return 0;
+
+    int64_t nTime = chunkIndex[0].columns[QARC_TIME].nMax;
+    for(int i = 1; i < chunkIndex.size(); i++)
+        if(chunkIndex[i].columns[QARC_TIME].nMax > nTime)
+            nTime = chunkIndex[i].columns[QARC_TIME].nMax;
+
+    return nTime;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Read and unpack one column of one chunk
+bool QuantumArchiveReader::readColumn(const QuantumArchiveChunkIndex& chunk, int nColumn, QVector<int64_t>* pValues)
+{
+    const QuantumArchiveColumnIndex& index = chunk.columns[nColumn];
+    int nCount = int(chunk.nCount);
+    pValues->resize(nCount);
+    int64_t* pOut = pValues->data();
+
+    uint64_t nNeeded = (uint64_t(index.nBits) * uint64_t(nCount) + 7) / 8;
+    if(index.nBytes > nNeeded)
+        return false;
+
+    packed.fill(0, int(nNeeded));
+    if(index.nBytes > 0) {
+        if(!file.seek(qint64(index.nOffset))
+                || file.read(packed.data(), qint64(index.nBytes)) != qint64(index.nBytes))
+            return false;
+        nBytesRead += index.nBytes;
+        }
+
+    const uint8_t* pPacked = reinterpret_cast<const uint8_t*>(packed.constData());
+    uint64_t nBitPos = 0;
+
+    if(index.nEncoding == QUANTUM_ARCHIVE_DELTA) {
+        int64_t nValue = index.nFirst;
+        pOut[0] = nValue;
+        for(int i = 1; i < nCount; i++) {
+            nValue += index.nBase + int64_t(unpackBits(pPacked, nBitPos, index.nBits));
+            pOut[i] = nValue;
+            }
+        }
+    else {
+        for(int i = 0; i < nCount; i++)
+            pOut[i] = index.nBase + int64_t(unpackBits(pPacked, nBitPos, index.nBits));
+        }
+
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Chunks outside the range are skipped on the index alone, and so are chunks that land
+// entirely in one bucket. Only the rest get read, and only two columns of those.
+bool QuantumArchiveReader::query(int nColumn, int64_t nFrom, int64_t nTo, int64_t nBucket, QVector<QuantumArchiveBucket>* pBuckets)
+{
+    pBuckets->clear();
+    if(nColumn < 0 || nColumn >= QARC_COLUMN_COUNT || !file.isOpen())
+        return false;
+
+    struct Totals {
+        uint32_t    nCount;
+        int64_t     nSum;
+        int64_t     nMin;
+        int64_t     nMax;
+    };
+
+    QMap<int64_t, Totals> totals;
+    QVector<int64_t> times;
+    QVector<int64_t> values;
+    double scale = double(quantumArchiveColumns[nColumn].nScale);
+
+    for(int c = 0; c < chunkIndex.size(); c++) {
+        const QuantumArchiveChunkIndex& chunk = chunkIndex[c];
+        const QuantumArchiveColumnIndex& timeIndex = chunk.columns[QARC_TIME];
+        if(timeIndex.nMax < nFrom || timeIndex.nMin >= nTo)
+            continue;
+
+        // The whole chunk is one bucket's worth, the index already has the sums
+        if(nBucket > 0 && timeIndex.nMin >= nFrom && timeIndex.nMax < nTo
+                && (timeIndex.nMin - nFrom) / nBucket == (timeIndex.nMax - nFrom) / nBucket) {
+            const QuantumArchiveColumnIndex& index = chunk.columns[nColumn];
+            int64_t nKey = (timeIndex.nMin - nFrom) / nBucket;
+            Totals& bucket = totals[nKey];
+            if(bucket.nCount == 0 || index.nMin < bucket.nMin) bucket.nMin = index.nMin;
+            if(bucket.nCount == 0 || index.nMax > bucket.nMax) bucket.nMax = index.nMax;
+            bucket.nCount += chunk.nCount;
+            bucket.nSum += index.nSum;
+            nChunksFromIndex++;
+            continue;
+            }
+
+        if(!readColumn(chunk, QARC_TIME, &times) || !readColumn(chunk, nColumn, &values))
+            return false;
+        nChunksDecoded++;
+
+        for(int i = 0; i < int(chunk.nCount); i++) {
+            int64_t nTime = times[i];
+            if(nTime < nFrom || nTime >= nTo)
+                continue;
+
+            if(nBucket <= 0) {
+                double value = double(values[i]) / scale;
+                QuantumArchiveBucket sample = { nTime, 1, value, value, value };
+                pBuckets->append(sample);
+                continue;
+                }
+
+            Totals& bucket = totals[(nTime - nFrom) / nBucket];
+            if(bucket.nCount == 0 || values[i] < bucket.nMin) bucket.nMin = values[i];
+            if(bucket.nCount == 0 || values[i] > bucket.nMax) bucket.nMax = values[i];
+            bucket.nCount++;
+            bucket.nSum += values[i];
+            }
+        }
+
+    for(QMap<int64_t, Totals>::const_iterator it = totals.constBegin(); it != totals.constEnd(); ++it) {
+        QuantumArchiveBucket bucket;
+        bucket.nStart = nFrom + it.key() * nBucket;
+        bucket.nCount = it.value().nCount;
+        bucket.mean = double(it.value().nSum) / double(it.value().nCount) / scale;
+        bucket.min = double(it.value().nMin) / scale;
+        bucket.max = double(it.value().nMax) / scale;
+        pBuckets->append(bucket);
+        }
+
+    return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////
+uint64_t quantumArchiveFromRecorder(const QuantumRecorder& recorder, QuantumArchiveWriter* pWriter, uint64_t nFrom)
+{
+    QuantumRecord records[256];
+
+    uint64_t nNext = nFrom;
+    for(;;) {
+        int nRead = recorder.readRange(nNext, records, 256, &nNext);
+        for(int i = 0; i < nRead; i++)
+            pWriter->append(records[i]);
+
+        if(nNext >= recorder.getNextSequence())
+            break;
+        }
+
+    return nNext;
+}
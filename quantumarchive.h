@@ -0,0 +1,191 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* Long term archive of the recorded history. The ring file (quantumrecorder.h) is
+ * for the last day or so; this is for keeping, and for asking questions of months
+ * of it without reading it all.
+ *
+ * Samples are stored in chunks of up to QUANTUM_ARCHIVE_CHUNK. Inside a chunk each
+ * field is a column of integers, at the resolution the Quantum reports it (0.1A for
+ * wavelengths, 0.01 for temperatures and volts), bit packed either as the change from
+ * one sample to the next, or as the offset from the smallest, whichever is smaller.
+ * Time is milliseconds since the epoch, and with a steady poll rate packs to nothing.
+ *
+ * The index at the end of the file has, for every chunk and column, the count, min,
+ * max and sum, and where the column is in the file. A query only reads the chunks in
+ * its time range, and only the time column and the one it wants out of those. A chunk
+ * that falls inside one bucket isn't read at all, the index has the answer.
+ *
+ *  [header][chunk 0 columns][chunk 1 columns]...[index][footer]
+ *
+ * Numbers are stored little endian, which is every machine this runs on.
+*/
+#ifndef QUANTUMARCHIVE_H
+#define QUANTUMARCHIVE_H
+
+#include <stdint.h>
+
+#include <QString>
+#include <QFile>
+#include <QVector>
+
+#include "quantumrecorder.h"
+
+#define QUANTUM_ARCHIVE_CHUNK       4096    // Samples per chunk
+
+/////////////////////////////////////////////////////////////
+/// The columns, in file order
+enum QuantumArchiveColumn {
+    QARC_TIME = 0,                  // Milliseconds since the epoch, UTC
+    QARC_CENTER_WAVELENGTH,
+    QARC_WINGSHIFT,
+    QARC_HEATER1_TEMPERATURE,
+    QARC_HEATER2_TEMPERATURE,
+    QARC_HEATER1_PWM,
+    QARC_HEATER2_PWM,
+    QARC_INPUT_VOLTAGE,
+    QARC_ERROR_CODE,
+    QARC_HEATER1_PWM_LIMIT,
+    QARC_HEATER2_PWM_LIMIT,
+    QARC_CALIBRATION_POT,
+    QARC_FLAGS,                     // QUANTUM_RECORD_ON_BAND etc.
+    QARC_COLUMN_COUNT
+};
+
+struct QuantumArchiveColumnInfo {
+    const char  *szName;
+    int         nScale;             // Stored as round(value * nScale)
+};
+
+extern const QuantumArchiveColumnInfo quantumArchiveColumns[QARC_COLUMN_COUNT];
+
+// -1 if there is no column by that name
+int quantumArchiveFindColumn(const char* szName);
+
+/////////////////////////////////////////////////////////////
+/// One bucket of a query, in the units of the column
+struct QuantumArchiveBucket {
+    int64_t     nStart;             // Milliseconds since the epoch, start of the bucket
+    uint32_t    nCount;             // Samples that fell in it
+    double      mean;
+    double      min;
+    double      max;
+};
+
+/////////////////////////////////////////////////////////////
+/// What the index knows about one column of one chunk. Values
+/// are as stored, before the scale comes off.
+struct QuantumArchiveColumnIndex {
+    int64_t     nMin;
+    int64_t     nMax;
+    int64_t     nSum;
+    int64_t     nFirst;             // First value, where the deltas start from
+    int64_t     nBase;              // Smallest delta, or smallest value
+    uint64_t    nOffset;            // Where the packed bits are in the file
+    uint32_t    nBytes;
+    uint8_t     nEncoding;          // QUANTUM_ARCHIVE_DELTA or QUANTUM_ARCHIVE_OFFSET
+    uint8_t     nBits;              // Per value, 0 if they are all the same
+    uint8_t     reserved[2];
+};
+
+struct QuantumArchiveChunkIndex {
+    uint32_t    nCount;
+    uint32_t    nReserved;
+    QuantumArchiveColumnIndex columns[QARC_COLUMN_COUNT];
+};
+
+#define QUANTUM_ARCHIVE_DELTA       0   // Change from the last value, less nBase
+#define QUANTUM_ARCHIVE_OFFSET      1   // Value less nBase
+
+
+/////////////////////////////////////////////////////////////
+/// Writes an archive, a chunk at a time. Memory use is one
+/// chunk, no matter how long the archive gets.
+class QuantumArchiveWriter
+{
+public:
+    QuantumArchiveWriter(void);
+    ~QuantumArchiveWriter(void);
+
+    bool open(const QString& qsFileName);
+    void append(const QuantumRecord& record);
+
+    // Writes the last chunk and the index. Nothing is readable until this is done.
+    bool close(void);
+
+    uint64_t getSampleCount(void) const { return nSamples; }
+
+protected:
+    bool flushChunk(void);
+
+    QFile               file;
+    QVector<int64_t>    columns[QARC_COLUMN_COUNT];     // The chunk being filled
+    QVector<QuantumArchiveChunkIndex> chunkIndex;
+    QByteArray          packed;
+    uint64_t            nSamples = 0;
+    bool                bFailed = false;
+};
+
+/////////////////////////////////////////////////////////////
+/// Reads an archive. Opening reads the index only.
+class QuantumArchiveReader
+{
+public:
+    QuantumArchiveReader(void);
+    ~QuantumArchiveReader(void);
+
+    bool open(const QString& qsFileName);
+    void close(void);
+
+    uint64_t getSampleCount(void) const;
+    int getChunkCount(void) const { return chunkIndex.size(); }
+    int64_t getFirstTime(void) const;           // Milliseconds since the epoch
+    int64_t getLastTime(void) const;
+
+    // Samples of one column from nFrom up to (not including) nTo, averaged into buckets
+    // nBucket milliseconds long, starting at nFrom. Empty buckets are left out. A bucket
+    // of 0 or less gives back every sample, each as a bucket of one.
+    bool query(int nColumn, int64_t nFrom, int64_t nTo, int64_t nBucket, QVector<QuantumArchiveBucket>* pBuckets);
+
+    // What the queries so far have cost
+    uint64_t getBytesRead(void) const { return nBytesRead; }
+    uint32_t getChunksDecoded(void) const { return nChunksDecoded; }
+    uint32_t getChunksFromIndex(void) const { return nChunksFromIndex; }
+
+protected:
+    bool readColumn(const QuantumArchiveChunkIndex& chunk, int nColumn, QVector<int64_t>* pValues);
+
+    QFile               file;
+    QVector<QuantumArchiveChunkIndex> chunkIndex;
+    QByteArray          packed;
+    uint64_t            nBytesRead = 0;
+    uint32_t            nChunksDecoded = 0;
+    uint32_t            nChunksFromIndex = 0;
+};
+
+
+// Everything in the recording from nFrom on goes into the archive. Returns where to
+// pick up next time. Fine to run while the recording is live.
+uint64_t quantumArchiveFromRecorder(const QuantumRecorder& recorder, QuantumArchiveWriter* pWriter, uint64_t nFrom = 0);
+
+#endif // QUANTUMARCHIVE_H
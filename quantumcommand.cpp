@@ -0,0 +1,84 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+
+#include "quantumcommand.h"
+
+// In the same order as QuantumCommandCode
+static const QuantumCommandInfo commandTable[QCMD_COUNT] = {
+    //  Mnemonic    Reply           Value   Idempotent  Absolute setter
+    {   "GI",       REPLY_STATUS,   false,  true,       false   },
+    {   "GS",       REPLY_TEXT,     false,  true,       false   },
+    {   "GY",       REPLY_TEXT,     false,  true,       false   },
+    {   "GA",       REPLY_INTEGER,  false,  true,       false   },
+    {   "GB",       REPLY_TEXT,     false,  true,       false   },
+    {   "GN",       REPLY_TEXT,     false,  true,       false   },
+    {   "GX",       REPLY_INTEGER,  false,  true,       false   },
+    {   "SE",       REPLY_TEXT,     true,   true,       true    }
+};
+
+
+////////////////////////////////////////////////////////////////////////////////////////////
+const QuantumCommandInfo& quantumCommandInfo(QuantumCommandCode code)
+{
+    return commandTable[code];
+}
+
+const QuantumCommandInfo& QuantumCommand::info(void) const
+{
+    return commandTable[code];
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Mnemonic, then the value in decimal if there is one, then a newline
+int QuantumCommand::encode(char* pBuffer, int nSize) const
+{
+    const QuantumCommandInfo& commandInfo = commandTable[code];
+
+    char szDigits[12];
+    int nDigits = 0;
+    bool bNegative = false;
+    if(commandInfo.bHasValue) {
+        uint32_t nMagnitude = (nValue < 0) ? uint32_t(0) - uint32_t(nValue) : uint32_t(nValue);
+        bNegative = (nValue < 0);
+        do {
+            szDigits[nDigits++] = char('0' + nMagnitude % 10);
+            nMagnitude /= 10;
+            } while(nMagnitude != 0);
+        }
+
+    int nLength = 2 + (bNegative ? 1 : 0) + nDigits + 1;
+    if(nLength > nSize)
+        return 0;
+
+    int i = 0;
+    pBuffer[i++] = commandInfo.szMnemonic[0];
+    pBuffer[i++] = commandInfo.szMnemonic[1];
+    if(bNegative)
+        pBuffer[i++] = '-';
+    while(nDigits > 0)
+        pBuffer[i++] = szDigits[--nDigits];
+    pBuffer[i++] = '\n';
+
+    return i;
+}
@@ -0,0 +1,84 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* Typed Quantum commands. A command is just a code and, for setters, a value. It is
+ * encoded straight into the caller's buffer when it goes out, so nothing is formatted
+ * or allocated until then. The command table says what each one looks like on the
+ * wire, what kind of reply it gets, and whether it is safe to send twice.
+ *
+ * No Qt in here.
+*/
+#ifndef QUANTUMCOMMAND_H
+#define QUANTUMCOMMAND_H
+
+#include <stdint.h>
+
+// Longest encoded command, mnemonic + value + terminator
+#define QUANTUM_MAX_COMMAND_SIZE    16
+
+enum QuantumCommandCode {
+    QCMD_GET_INFO = 0,              // GI, the status line
+    QCMD_GET_SERIAL_NUMBER,         // GS
+    QCMD_GET_RUNTIME,               // GY, boot count and runtime
+    QCMD_GET_BODY_STYLE,            // GA
+    QCMD_GET_BANDWIDTH,             // GB
+    QCMD_GET_MODEL_NAME,            // GN
+    QCMD_GET_DESIGN_WAVELENGTH,     // GX
+    QCMD_SET_WINGSHIFT,             // SE, value is in tenths of an angstrom
+    QCMD_COUNT
+};
+
+enum QuantumReplyFormat {
+    REPLY_STATUS,                   // Full GI status line, see quantumparser.h
+    REPLY_INTEGER,                  // One number, hex or decimal depending on firmware
+    REPLY_TEXT                      // Free form text
+};
+
+struct QuantumCommandInfo {
+    char                szMnemonic[3];
+    QuantumReplyFormat  replyFormat;
+    bool                bHasValue;          // Value goes on the wire after the mnemonic
+    bool                bIdempotent;        // Sending it twice is the same as once, ok to retry
+    bool                bAbsoluteSetter;    // Sets a value outright, only the latest one matters
+};
+
+/////////////////////////////////////////////////////////////
+/// One command, ready to be queued or sent
+struct QuantumCommand {
+    QuantumCommandCode  code;
+    int32_t             nValue;
+
+    QuantumCommand(QuantumCommandCode commandCode = QCMD_GET_INFO, int32_t nCommandValue = 0)
+        : code(commandCode), nValue(nCommandValue) {}
+
+    static QuantumCommand setWingshift(int nTenths) { return QuantumCommand(QCMD_SET_WINGSHIFT, nTenths); }
+
+    const QuantumCommandInfo& info(void) const;
+
+    // Write the command into pBuffer, returns the number of bytes or 0 if it won't fit
+    int encode(char* pBuffer, int nSize) const;
+};
+
+const QuantumCommandInfo& quantumCommandInfo(QuantumCommandCode code);
+
+#endif // QUANTUMCOMMAND_H
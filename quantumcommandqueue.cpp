@@ -0,0 +1,72 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+
+#include "quantumcommandqueue.h"
+
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Walk back from the end of the queue over setters only. If one of them is the same kind
+// as this one, it is replaced in place. Anything with side effects stops the search, so
+// nothing ever moves past it.
+QuantumCommandQueue::EnqueueResult QuantumCommandQueue::enqueue(const QuantumCommand& command)
+{
+    if(command.info().bAbsoluteSetter) {
+        for(int i = nCount - 1; i >= 0; i--) {
+            if(!at(i).info().bAbsoluteSetter)
+                break;
+
+            if(at(i).code == command.code) {
+                at(i) = command;
+                return COMMAND_MERGED;
+                }
+            }
+        }
+
+    if(nCount == QUANTUM_COMMAND_QUEUE_SIZE)
+        return COMMAND_QUEUE_FULL;
+
+    at(nCount) = command;
+    nCount++;
+    return COMMAND_ADDED;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Don't call this on an empty queue
+QuantumCommand QuantumCommandQueue::dequeue(void)
+{
+    QuantumCommand command = at(0);
+    nHead = (nHead + 1) % QUANTUM_COMMAND_QUEUE_SIZE;
+    nCount--;
+    return command;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+bool QuantumCommandQueue::hasPending(QuantumCommandCode code) const
+{
+    for(int i = 0; i < nCount; i++)
+        if(at(i).code == code)
+            return true;
+
+    return false;
+}
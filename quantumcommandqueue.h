@@ -0,0 +1,73 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* The queue of commands waiting to go to the Quantum. It knows enough about the
+ * commands to collapse absolute setters (SE, etc.) that have been superseded before
+ * they were ever sent. Clicking the wingshift up five times should send one SE with
+ * the final value, not five of them a poll cycle apart.
+ *
+ * Commands with side effects are never merged or reordered. A setter is only merged
+ * with one that is queued after the last of those, so the order the user asked for
+ * things in is what the filter sees.
+ *
+ * The queue is a fixed ring, nothing is allocated. Not thread safe, the device
+ * protects it with its own mutex.
+*/
+#ifndef QUANTUMCOMMANDQUEUE_H
+#define QUANTUMCOMMANDQUEUE_H
+
+#include "quantumcommand.h"
+
+// Most commands that can be waiting at once. With setters merged, this is plenty.
+#define QUANTUM_COMMAND_QUEUE_SIZE  32
+
+class QuantumCommandQueue
+{
+public:
+    enum EnqueueResult {
+        COMMAND_ADDED,              // Added to the end
+        COMMAND_MERGED,             // Replaced one already waiting
+        COMMAND_QUEUE_FULL          // No room, dropped
+    };
+
+    QuantumCommandQueue(void) : nHead(0), nCount(0) {}
+
+    EnqueueResult enqueue(const QuantumCommand& command);
+
+    QuantumCommand dequeue(void);
+    bool isEmpty(void) const                { return nCount == 0; }
+    int  size(void) const                   { return nCount; }
+
+    // Is a command with this code waiting?
+    bool hasPending(QuantumCommandCode code) const;
+
+protected:
+    QuantumCommand  commands[QUANTUM_COMMAND_QUEUE_SIZE];
+    int             nHead;
+    int             nCount;
+
+    QuantumCommand& at(int i)               { return commands[(nHead + i) % QUANTUM_COMMAND_QUEUE_SIZE]; }
+    const QuantumCommand& at(int i) const   { return commands[(nHead + i) % QUANTUM_COMMAND_QUEUE_SIZE]; }
+};
+
+#endif // QUANTUMCOMMANDQUEUE_H
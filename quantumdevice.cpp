@@ -23,30 +23,47 @@ SOFTWARE
 */
 
 #include <QTimer>
+#include <QDateTime>
+
+#include <chrono>
+#include <math.h>
+#include <string.h>
 
 #include "quantumdevice.h"
+#include "quantumtrace.h"
+#include "quantumpushserver.h"
+
+// The commands themselves are in quantumcommand.h/.cpp
+
+// Static info that is taken from the cache at startup, and checked in the background
+// afterwards. One of these goes out per poll cycle.
+static const QuantumCommandCode refreshCommands[] = {
+    QCMD_GET_BODY_STYLE,
+    QCMD_GET_DESIGN_WAVELENGTH,
+    QCMD_GET_MODEL_NAME,
+    QCMD_GET_BANDWIDTH
+};
 
-const char* qCmdGetInfo = "GI\n";               // Gather common info
-const char* qCmdGetSerialNumber = "GS\n";       // Get serial number
-const char* qCmdGetRuntime = "GY\n";            // Boot count and runtime
-const char* qCmdGetBodyStyle = "GA\n";          // Body Style
-const char* qCmdGetBandwidth = "GB\n";          // Get Bandwidth
-const char* qCmdGetModelName = "GN\n";          // Get Modelname
-const char* qCmdGetDesignWavelength = "GX\n";   // Get Design wavelength
+#define QUANTUM_REFRESH_COUNT   int(sizeof(refreshCommands) / sizeof(refreshCommands[0]))
 
 
 /////////////////////////////////////////////////////////////////////////////////////////
 // This is all called within the calling thread. Just setup variables here, but do
-// not do any real work.
-QuantumDevice::QuantumDevice(QObject *parent, QSerialPortInfo serialPortInformation) : QThread(parent)
+// not do any real work. The device manager moves us to an I/O thread, and everything
+// after that happens there.
+QuantumDevice::QuantumDevice(QObject *parent, QSerialPortInfo serialPortInformation) : QObject(parent)
 {
     serialPortInfo = serialPortInformation;
+    qsPortName = serialPortInfo.portName();
+    quantumResetMetrics(&ioMetrics);
+    quantumResetMetrics(&publishedMetrics);
+}
 
-    // I know this is frowned on in some circles, but really... I just can't justify writing
-    // a bunch of extra convoluted code when this class "should" simply run the signals/slots
-    // through it's own message pump, especially when the connections are marked as queued.
-    // Fight me...
-    moveToThread(this);
+QuantumDevice::QuantumDevice(QObject *parent, const QString& qsPort) : QObject(parent)
+{
+    qsPortName = qsPort;
+    quantumResetMetrics(&ioMetrics);
+    quantumResetMetrics(&publishedMetrics);
 }
 
 QuantumDevice::~QuantumDevice(void)
@@ -56,331 +73,915 @@ QuantumDevice::~QuantumDevice(void)
 
 
 ////////////////////////////////////////////////////////////////////////////////////////////
-// The lowest level read command. Just waiting for ready read is too agressive, so
-// a small delay is added to give the device a chance to respond. All returned strings
-bool QuantumDevice::sendCommand(const char* szCommand)
+// The lowest level command. This just writes the command and returns, the reply is
+// gathered as it arrives and commandFinished() is called when it is complete. The stage
+// says what to do with the reply. If the shape of the reply is known (a GI, once we have
+// seen one), it is done the moment the last byte arrives.
+void QuantumDevice::sendCommand(const QuantumCommand& command, DeviceStage nextStage)
     {
-    // Clear buffer - just so nothing from past responses can come through
-    memset(szReturnBuffer, 0, MAX_COMM_BUFFER_SIZE);
-
     // This actually never should have been called
     Q_ASSERT(pSerialPort != nullptr);
-    if(!pSerialPort)
-        return false;
 
-    ///////////////////////////////////////////////////////////
-    /// There is a slight chance some commands can be dropped
-    /// Allow up to two retries
-    int nTries = 0;
-    while(nTries++ < 3) {
-        pSerialPort->write(szCommand);
-        // This flush causes a hang and time out on macOS.
-        //pSerialPort->flush();
-        if(!pSerialPort->waitForBytesWritten())
-            return false; // This is an actual error... no retries
-
-        if(pSerialPort->waitForReadyRead(QUANTUM_TIMEOUT))
+    deviceStage = nextStage;
+    pendingCommand = command;
+    bPendingIdempotent = command.info().bIdempotent;
+    szExpectedMarker = nullptr;
+    nTries = 0;
+
+    if(command.info().replyFormat == REPLY_STATUS) {
+        nExpectedFields = nStatusFields;
+        nExpectedLastWidth = nStatusLastWidth;
+        }
+    else {
+        nExpectedFields = 0;
+        nExpectedLastWidth = 0;
+        }
+
+    nTxLength = command.encode(szTxBuffer, sizeof(szTxBuffer));
+    ioMetrics.commands[command.code].nSent++;
+
+    QUANTUM_TRACE_ASYNC_BEGIN(command.info().szMnemonic, quintptr(this));
+    writeCommand();
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Send a command with a GI right behind it. The command reply ends at its terminator, or
+// where the GI reply starts.
+void QuantumDevice::sendPipelinedCommand(const QuantumCommand& command)
+    {
+    Q_ASSERT(pSerialPort != nullptr);
+
+    deviceStage = STAGE_PIPELINED_COMMAND;
+    pipelinedCommand = command;
+    pendingCommand = command;
+    bPendingIdempotent = command.info().bIdempotent;
+    nExpectedFields = 0;
+    nExpectedLastWidth = 0;
+    szExpectedMarker = szStatusMarker;
+    nTries = 0;
+
+    nTxLength = command.encode(szTxBuffer, sizeof(szTxBuffer));
+    nPipelinedLength = nTxLength;
+    nTxLength += QuantumCommand(QCMD_GET_INFO).encode(szTxBuffer + nTxLength, int(sizeof(szTxBuffer)) - nTxLength);
+    ioMetrics.commands[command.code].nSent++;
+    ioMetrics.commands[QCMD_GET_INFO].nSent++;
+
+    QUANTUM_TRACE_ASYNC_BEGIN(command.info().szMnemonic, quintptr(this));
+    writeCommand();
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Put the pending command on the wire. There is a slight chance some commands can be
+// dropped, so this is called again (up to two retries) if nothing comes back.
+void QuantumDevice::writeCommand(void)
+    {
+    QUANTUM_TRACE_SCOPE("write");
+
+    nTries++;
+    if(nTries > 1)
+        ioMetrics.commands[pendingCommand.code].nRetries++;
+
+    // Anything sitting in the buffer now is from a reply we already gave up on
+    pSerialPort->readAll();
+    framer.begin(nExpectedFields, nExpectedLastWidth, szExpectedMarker);
+
+    commandTimer.start();
+    if(nTxLength == 0 || pSerialPort->write(szTxBuffer, nTxLength) != nTxLength) {
+        finishCommand(false); // This is an actual error... no retries
+        return;
+        }
+
+    // The GI riding along is counted on its own
+    if(deviceStage == STAGE_PIPELINED_COMMAND) {
+        ioMetrics.commands[pendingCommand.code].nBytesOut += uint64_t(nPipelinedLength);
+        ioMetrics.commands[QCMD_GET_INFO].nBytesOut += uint64_t(nTxLength - nPipelinedLength);
+        }
+    else
+        ioMetrics.commands[pendingCommand.code].nBytesOut += uint64_t(nTxLength);
+
+    // A retry starts the wait over
+    traceReplyEnd();
+    QUANTUM_TRACE_ASYNC_BEGIN("wait first byte", quintptr(this));
+    nTraceReply = TRACE_REPLY_WAITING;
+
+    pReplyTimer->start(QUANTUM_TIMEOUT);
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Close whichever part of the reply is open in the trace
+void QuantumDevice::traceReplyEnd(void)
+    {
+    if(nTraceReply == TRACE_REPLY_WAITING)
+        QUANTUM_TRACE_ASYNC_END("wait first byte", quintptr(this));
+    else if(nTraceReply == TRACE_REPLY_DRAINING)
+        QUANTUM_TRACE_ASYNC_END("drain", quintptr(this));
+
+    nTraceReply = TRACE_REPLY_NONE;
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Bytes have arrived. Feed them to the framer, it will tell us when we have it all.
+void QuantumDevice::serialReadyRead(void)
+    {
+    char chunk[MAX_COMM_BUFFER_SIZE];
+
+    if(nTraceReply == TRACE_REPLY_WAITING) {
+        traceReplyEnd();
+        QUANTUM_TRACE_ASYNC_BEGIN("drain", quintptr(this));
+        nTraceReply = TRACE_REPLY_DRAINING;
+        }
+
+    while(pSerialPort->bytesAvailable() > 0) {
+        qint64 nRead = pSerialPort->read(chunk, sizeof(chunk));
+        if(nRead <= 0)
             break;
-        else
+
+        // Not expecting anything, just toss it
+        if(deviceStage == STAGE_IDLE)
             continue;
+
+        int nUsed = framer.feed(chunk, int(nRead));
+        ioMetrics.commands[pendingCommand.code].nBytesIn += uint64_t(nUsed);
+
+        // The command reply is done, and the GI reply right behind it gets the rest
+        if(framer.isDone() && deviceStage == STAGE_PIPELINED_COMMAND) {
+            pipelinedCommandFinished();
+            ioMetrics.commands[QCMD_GET_INFO].nBytesIn += uint64_t(nRead - nUsed);
+            framer.feed(chunk + nUsed, int(nRead) - nUsed);
+            }
+
+        if(framer.isDone()) {
+            finishCommand(true);
+            return;
+            }
+        }
+
+    if(deviceStage == STAGE_IDLE)
+        return;
+
+    // Something is coming, stop the retry clock and wait for the rest
+    if(framer.getState() == QuantumFramer::FRAME_RECEIVING) {
+        pReplyTimer->stop();
+        pGapTimer->start(QUANTUM_GAP_TIMEOUT);
+        }
     }
 
-    if(nTries > 3) return false; // Gave up..
-
-    pSerialPort->waitForReadyRead(100);
-    int iIndex = 0;
-    char nextChar = 0x0;
-    //char lastChar = 0x0;
-    while(!pSerialPort->atEnd() && iIndex < MAX_COMM_BUFFER_SIZE) {
-        pSerialPort->getChar(&nextChar);
-        szReturnBuffer[iIndex] = nextChar;
-        iIndex++;
-
-        // The docs say \r\n is at the end of response strings, but I have yet
-        // to see this...
-        // signals end
-        //if(nextChar == 0x0a && lastChar == 0x0d)
-        //    break;
-        //lastChar = nextChar;
-
-        pSerialPort->waitForReadyRead(10);
+////////////////////////////////////////////////////////////////////////////////////////////
+// Nothing came back at all. Try again, or give up.
+void QuantumDevice::replyTimedOut(void)
+    {
+    ioMetrics.commands[pendingCommand.code].nTimeouts++;
+
+    // Lost in a pipelined cycle. The device may not take a second frame right behind
+    // the first, so stop sending them together, and don't count this one as saved.
+    if(bPipelinedCycle)
+        pipelineFailed();
+
+    // Only try again if doing it twice can't hurt
+    if(nTries < 3 && bPendingIdempotent) {
+        writeCommand();
+        return;
         }
-    szReturnBuffer[iIndex] = 0x0;
 
-    return true;
+    finishCommand(false); // Gave up..
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Bytes came in, but no terminator, and now the line is quiet. That is the reply.
+void QuantumDevice::replyWentQuiet(void)
+    {
+    // We knew what this reply looked like, and this isn't it
+    if(nExpectedFields > 0 && nExpectedLastWidth > 0)
+        ioMetrics.commands[pendingCommand.code].nPartialReads++;
+
+    framer.finish();
+
+    // Only the command reply is done, the GI reply is still coming
+    if(deviceStage == STAGE_PIPELINED_COMMAND) {
+        pipelinedCommandFinished();
+        return;
+        }
+
+    finishCommand(true);
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// The command went out with a GI right behind it, and the command reply is in. Switch
+// over to the GI reply, which may already have started (the marker that ended the
+// command reply is the front of it).
+void QuantumDevice::pipelinedCommandFinished(void)
+    {
+    pGapTimer->stop();
+
+    QUANTUM_TRACE_ASYNC_END(pipelinedCommand.info().szMnemonic, quintptr(this));
+
+    qint64 nMicroseconds = commandTimer.nsecsElapsed() / 1000;
+    ioMetrics.commands[pipelinedCommand.code].nSucceeded++;
+    quantumRecordRtt(&ioMetrics.commands[pipelinedCommand.code], nMicroseconds);
+
+    emit commandCompleted(pipelinedCommand.code, true, nMicroseconds);
+
+    // The GI is already on the wire. If it has to be retried, it goes alone.
+    deviceStage = STAGE_POLL_INFO;
+    pendingCommand = QuantumCommand(QCMD_GET_INFO);
+    QUANTUM_TRACE_ASYNC_BEGIN(pendingCommand.info().szMnemonic, quintptr(this));
+    bPendingIdempotent = true;
+    nTxLength = pendingCommand.encode(szTxBuffer, sizeof(szTxBuffer));
+    nExpectedFields = nStatusFields;
+    nExpectedLastWidth = nStatusLastWidth;
+    szExpectedMarker = nullptr;
+    nTries = 1;
+
+    bool bStarted = framer.endedAtMarker();
+    framer.begin(nExpectedFields, nExpectedLastWidth);
+    if(bStarted)
+        framer.feed(szStatusMarker, int(strlen(szStatusMarker)));
+
+    pReplyTimer->start(QUANTUM_TIMEOUT);
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// The exchange is over one way or another. Hand the reply off to whoever is next.
+void QuantumDevice::finishCommand(bool bSuccess)
+    {
+    pReplyTimer->stop();
+    pGapTimer->stop();
+
+    traceReplyEnd();
+    QUANTUM_TRACE_ASYNC_END(pendingCommand.info().szMnemonic, quintptr(this));
+
+    qint64 nMicroseconds = commandTimer.nsecsElapsed() / 1000;
+
+    DeviceStage finishedStage = deviceStage;
+    deviceStage = STAGE_IDLE;
+
+    QuantumCommandMetrics& metrics = ioMetrics.commands[pendingCommand.code];
+    if(framer.getState() == QuantumFramer::FRAME_OVERFLOW)
+        metrics.nPartialReads++;
+
+    if(bSuccess) {
+        metrics.nSucceeded++;
+        quantumRecordRtt(&metrics, nMicroseconds);
+        }
+    else
+        metrics.nFailed++;
+
+    emit commandCompleted(pendingCommand.code, bSuccess, nMicroseconds);
+
+    commandFinished(finishedStage, bSuccess);
+    publishMetrics();
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Hand a copy of the link metrics over to everyone else. A couple of KB, once per
+// exchange, is nothing next to the exchange itself.
+void QuantumDevice::publishMetrics(void)
+    {
+    QUANTUM_TRACE_SCOPE("publish metrics");
+
+    mutexBlocker.lock();
+    if(bResetMetrics) {
+        quantumResetMetrics(&ioMetrics);
+        bResetMetrics = false;
+        }
+    memcpy(&publishedMetrics, &ioMetrics, sizeof(QuantumIOMetrics));
+    mutexBlocker.unlock();
+    }
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// A reply is in the framer. What happens next depends on where we are.
+void QuantumDevice::commandFinished(DeviceStage finishedStage, bool bSuccess)
+    {
+    switch(finishedStage) {
+        case STAGE_STARTUP_INFO:
+        case STAGE_STARTUP_SERIAL:
+        case STAGE_STARTUP_BODY:
+        case STAGE_STARTUP_WAVELENGTH:
+        case STAGE_STARTUP_MODEL:
+        case STAGE_STARTUP_BANDWIDTH:
+            if(!bSuccess || !getStaticInfoFromDevice(finishedStage))
+                emit couldNotOpen(this);
+            break;
+
+        case STAGE_REFRESH_INFO:
+            refreshFinished(bSuccess);
+
+            // A poll came due while we were at it
+            if(bUpdateRequested)
+                updateStatus();
+            break;
+
+        case STAGE_USER_COMMAND:
+            // Check return based on command
+            // E OK
+            //printf("%s\n", framer.getData());
+
+            // Anything else waiting goes out now, in order, then the GI
+            if(!sendNextQueuedCommand())
+                sendCommand(QuantumCommand(QCMD_GET_INFO), STAGE_POLL_INFO);
+            break;
+
+        case STAGE_PIPELINED_COMMAND:
+            // Never heard back from the pair. Maybe this firmware can't take two commands
+            // at once, go back to one at a time and get the status the old way.
+            ioMetrics.commands[QCMD_GET_INFO].nFailed++;
+            pipelineFailed();
+            sendCommand(QuantumCommand(QCMD_GET_INFO), STAGE_POLL_INFO);
+            break;
+
+        case STAGE_POLL_INFO:
+            if(!bSuccess) {
+                ioMetrics.nMissedSamples++;
+                QUANTUM_TRACE_ASYNC_END("poll cycle", quintptr(this));
+                emit fatalError(-1);
+                return;
+                }
+
+            pollFinished();
+            break;
+
+        case STAGE_IDLE:
+            break;
+        }
     }
 
 
 /////////////////////////////////////////////////////////////////////////////////////////
-// Convert a string to an integer. For firmware versions prior to 1.25, this is decimal
-// After that it is hexidecmial.
-int QuantumDevice::toInteger(const char* szStringField)
+// Convert a single value reply to an integer. For firmware versions prior to 1.26, this
+// is decimal. After that it is hexidecmial.
+int QuantumDevice::toInteger(void)
 {
-    if(szStringField == NULL)
-        return 0;
-        
-    // It's just ascii decimal
-    if(bOldFirmware)
-        return atoi(szStringField);
-
-    // It's in hex
-    int returnValue;
-    sscanf(szStringField, "%x", &returnValue);
+    int32_t returnValue = 0;
+    if(!quantumDecodeInteger(framer.getData(), framer.getLength(), bOldFirmware, &returnValue))
+        ioMetrics.commands[pendingCommand.code].nParseFailures++;
     return returnValue;
 }
 
-////////////////////////////////////////////////////////////////////////////////////////
-// Convert a string to a decimal. Hex value is 2's complement
-int QuantumDevice::toSignedInteger(const char* szStringField)
+
+/////////////////////////////////////////////////////////////////////////////////////////
+/// Settings are 9600 baud, 8 bits, no parity, 1 stop bit, with no handshaking.
+void QuantumDevice::configureSerialPort(QSerialPort *pPort)
 {
-    if(szStringField == NULL)
-        return 0;
-        
-    // It's just ascii decimal
-    if(bOldFirmware)
-        return atoi(szStringField);
-
-    // It's in hex
-    unsigned int returnValue;
-    sscanf(szStringField, "%x", &returnValue);
-    signed char twos = returnValue;
-    return ~(-twos) + 1;
+    pPort->setBaudRate(9600);
+    pPort->setDataBits(QSerialPort::Data8);
+    pPort->setParity(QSerialPort::NoParity);
+    pPort->setStopBits(QSerialPort::OneStop);
+    pPort->setFlowControl(QSerialPort::NoFlowControl);
+    pPort->setReadBufferSize(MAX_COMM_BUFFER_SIZE);
 }
 
-
 /////////////////////////////////////////////////////////////////////////////////////////
-/// We are in the thread, but the event loop is not running yet. This is where we
-/// attempt to connect to the device. If we can't connect it is game over. Once we are
-/// connected, everything is event driven
-/// There is a big assumption here... I'm firing off signals before the event loop has
-/// started. First run/testing this works, but different OS's and future versions of
-/// Qt may not? Evaluate, but if in the futre this stops working, a past version is
-/// is saying "I told you so"...
-void QuantumDevice::run()
+/// We are on the I/O thread now. This is where we open the serial port and kick off
+/// the startup sequence. If we can't open the port it is game over. Once the port is
+/// open, everything is event driven, and the rest of the connection (getting the static
+/// info) happens as the replies come in. Other devices share this thread, so nothing
+/// in here can ever block.
+void QuantumDevice::open(void)
 {
-    // Yes, we can kill you if you misbehave... make another one just like you ;-)
-    setTerminationEnabled(true);
-
-    //Settings are 9600 baud, 8 bits, no parity, 1 stop bit, with no handshaking.
-    pSerialPort = new QSerialPort(serialPortInfo, nullptr);
-
-    pSerialPort->setBaudRate(9600);
-    pSerialPort->setDataBits(QSerialPort::Data8);
-    pSerialPort->setParity(QSerialPort::NoParity);
-    pSerialPort->setStopBits(QSerialPort::OneStop);
-    pSerialPort->setFlowControl(QSerialPort::NoFlowControl);
-    pSerialPort->setReadBufferSize(MAX_COMM_BUFFER_SIZE);
-
+    quantumTraceThreadName("Quantum I/O");
+
+    pSerialPort = new QSerialPort(nullptr);
+    pSerialPort->setPortName(qsPortName);
+    configureSerialPort(pSerialPort);
+
+    // These all belong to this thread
+    pReplyTimer = new QTimer();
+    pReplyTimer->setSingleShot(true);
+    pGapTimer = new QTimer();
+    pGapTimer->setSingleShot(true);
+    pPollTimer = new QTimer();
+    pPollTimer->setSingleShot(true);
+    pPollTimer->setTimerType(Qt::PreciseTimer);
+    uptimeTimer.start();
+    connectTimer.start();
+
+    // If we have seen a Quantum on this port before, we may not need to ask it much
+    bCacheLoaded = QuantumInfoCache::load(qsPortName, &cachedInfo);
+
+    connect(pSerialPort, &QSerialPort::readyRead, this, &QuantumDevice::serialReadyRead);
+    connect(pReplyTimer, &QTimer::timeout, this, &QuantumDevice::replyTimedOut);
+    connect(pGapTimer, &QTimer::timeout, this, &QuantumDevice::replyWentQuiet);
+    connect(pPollTimer, &QTimer::timeout, this, &QuantumDevice::updateStatus);
 
     // Basic serial port opening, doesn't prove anything yet..
-    bool bReady = false;
     if(pSerialPort->open(QIODevice::ReadWrite))
-        if(getStaticInfoFromDevice())
-            bReady = true;
-
-    if(bReady) {
-        //connect(this, SIGNAL(connectedToQuantum(QuantumDevice*)), SLOT(updateStatus()), Qt::QueuedConnection);
-        emit connectedToQuantum(this);
-        updateStatus();
-        }
+        sendCommand(QuantumCommand(QCMD_GET_INFO), STAGE_STARTUP_INFO);
     else
         emit couldNotOpen(this);
+}
 
-    // This begins the default behavior, which starts an event loop for this thread.
-    QThread::run();
+/////////////////////////////////////////////////////////////////////////////////////////
+/// We are done with the device. Also on the I/O thread, the device manager calls this
+/// before it lets go of us.
+void QuantumDevice::close(void)
+{
+    if(pSerialPort == nullptr)
+        return;
+
+    deviceStage = STAGE_IDLE;
+
+    delete pPollTimer;
+    delete pGapTimer;
+    delete pReplyTimer;
+    pPollTimer = nullptr;
+    pGapTimer = nullptr;
+    pReplyTimer = nullptr;
 
-    // The event loop has terminated. Do any remaining cleanup.
     pSerialPort->close();
     delete pSerialPort;
+    pSerialPort = nullptr;
+
+    recorder.close();
+    driftEstimator.clear();
+
+    delete pPushServer;
+    pPushServer = nullptr;
+
+    shmWriter.close();
+    mutexBlocker.lock();
+    bShmOpen = false;
+    mutexBlocker.unlock();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// Start, stop, or move the push server, whatever startPushServer() or stopPushServer()
+// last asked for. On this thread, so samples can go straight out from parseStatusInfo().
+void QuantumDevice::applyPushServer(void)
+{
+    mutexBlocker.lock();
+    bool bWanted = bPushWanted;
+    quint16 nPort = nPushPort;
+    bool bLoopback = bPushLoopback;
+    nPushListening = 0;
+    mutexBlocker.unlock();
+
+    delete pPushServer;
+    pPushServer = nullptr;
+
+    if(!bWanted)
+        return;
+
+    // Not being able to serve is no reason not to run the filter either
+    pPushServer = new QuantumPushServer(this);
+    if(!pPushServer->listen(nPort, bLoopback)) {
+        delete pPushServer;
+        pPushServer = nullptr;
+        return;
+        }
 
+    mutexBlocker.lock();
+    nPushListening = pPushServer->getPort();
+    mutexBlocker.unlock();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// Open or close the shared memory segment, whatever startSharedStatus() or stopSharedStatus()
+// last asked for. Readers get the latest sample right away, not at the next poll.
+void QuantumDevice::applySharedStatus(void)
+{
+    mutexBlocker.lock();
+    bool bWanted = bShmWanted;
+    QByteArray name = qsShmName.toLocal8Bit();
+    mutexBlocker.unlock();
+
+    shmWriter.close();
+    bool bOpen = bWanted && shmWriter.open(name.constData());
+    if(bOpen && nSampleCount != 0) {
+        QuantumStatusSnapshot snapshot;
+        statusPublisher.read(&snapshot);
+        shmWriter.publish(snapshot);
+        }
+
+    mutexBlocker.lock();
+    bShmOpen = bOpen;
+    mutexBlocker.unlock();
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////
 // Get static information from device that does not have to be thread safe. This data is
-// read during initialization before the device interface should be used.
-bool QuantumDevice::getStaticInfoFromDevice(void)
+// read during initialization before the device interface should be used. Each reply
+// comes through here and sends the next command, until we have it all.
+bool QuantumDevice::getStaticInfoFromDevice(DeviceStage finishedStage)
     {
-    if(!sendCommand(qCmdGetInfo))
-        return false;
+    switch(finishedStage) {
+        case STAGE_STARTUP_INFO: {
+            if(framer.getLength() < 74)
+                return false;
+
+            // The firmware version is the first field
+            const char *szReply = framer.getData();
+            const char *szSpace = strchr(szReply, ' ');
+            if(szSpace == nullptr)
+                return false;                   // Not a Quantum, or garbled
+            staticInfo.qsFirmwareVersion = QString::fromUtf8(szReply, int(szSpace - szReply));
+
+            // Every GI reply starts with this, which is how we find the front of one
+            // that comes in right behind another reply
+            int nMarkerLength = qMin(int(szSpace - szReply) + 1, int(sizeof(szStatusMarker)) - 1);
+            memcpy(szStatusMarker, szReply, nMarkerLength);
+            szStatusMarker[nMarkerLength] = 0x0;
+            bOldFirmware = atof(szReply+1) < 1.26f;
+
+            // Now we know what a GI reply looks like. Newer firmware uses fixed width hex
+            // fields, so the last byte of the last field ends the reply.
+            nStatusFields = framer.getFieldCount();
+            nStatusLastWidth = bOldFirmware ? 0 : framer.getLastFieldWidth();
+
+            // None of this changes while we are connected, so pick the parser once
+            pfnParseStatus = quantumSelectStatusParser(bOldFirmware, nStatusFields > QUANTUM_SINGLE_HEATER_FIELDS);
+
+            // Get the initial status info
+            if(!parseStatusInfo())
+                return false;
+
+            // Serial number
+            sendCommand(QuantumCommand(QCMD_GET_SERIAL_NUMBER), STAGE_STARTUP_SERIAL);
+            break;
+            }
+
+        case STAGE_STARTUP_SERIAL:
+            storeStaticReply(QCMD_GET_SERIAL_NUMBER, &staticInfo);
+
+            // Same filter, same firmware, as last time on this port? Then we already know
+            // the rest. It gets checked again once we are running.
+            if(bCacheLoaded && cachedInfo.qsSerialNumber == staticInfo.qsSerialNumber &&
+                    cachedInfo.qsFirmwareVersion == staticInfo.qsFirmwareVersion) {
+                staticInfo = cachedInfo;
+                refreshedInfo = cachedInfo;
+                nRefreshIndex = 0;
+                bFromCache = true;
+                startupFinished();
+                break;
+                }
+
+            // Body Style
+            sendCommand(QuantumCommand(QCMD_GET_BODY_STYLE), STAGE_STARTUP_BODY);
+            break;
 
-    if(strlen(szReturnBuffer) < 74)
-        return false;
+        case STAGE_STARTUP_BODY:
+            storeStaticReply(QCMD_GET_BODY_STYLE, &staticInfo);
 
-    // Get the initial status info
-    parseStatusInfo();
+            // Design wavelength
+            sendCommand(QuantumCommand(QCMD_GET_DESIGN_WAVELENGTH), STAGE_STARTUP_WAVELENGTH);
+            break;
 
-    // The firmware version and serial number are retrieved here
-    const char *szFW = strtok(szReturnBuffer, " ");
-    qsFirmwareVersion = QString::fromUtf8(szFW);
-    bOldFirmware = atof(szFW+1) < 1.26f;
+        case STAGE_STARTUP_WAVELENGTH:
+            storeStaticReply(QCMD_GET_DESIGN_WAVELENGTH, &staticInfo);
 
-    // Serial number
-    if(!sendCommand(qCmdGetSerialNumber))
-        return false;
+            // Model String
+            sendCommand(QuantumCommand(QCMD_GET_MODEL_NAME), STAGE_STARTUP_MODEL);
+            break;
 
-    qsSerialNumber = QString::fromUtf8(szReturnBuffer);
+        case STAGE_STARTUP_MODEL:
+            storeStaticReply(QCMD_GET_MODEL_NAME, &staticInfo);
 
-    // Body Style
-    if(!sendCommand(qCmdGetBodyStyle))
-        return false;
+            // Bandwidth String
+            sendCommand(QuantumCommand(QCMD_GET_BANDWIDTH), STAGE_STARTUP_BANDWIDTH);
+            break;
 
-    nBodyStyle = toInteger(szReturnBuffer);
+        case STAGE_STARTUP_BANDWIDTH:
+            storeStaticReply(QCMD_GET_BANDWIDTH, &staticInfo);
 
-    // Bandwidth String
-    if(!sendCommand(qCmdGetDesignWavelength))
-        return false;
+            // Number of boots and run time. Does not seem to work. Always times out.
+            //sendCommand(QuantumCommand(QCMD_GET_RUNTIME), ...);
 
-    qsDesignWavelength = QString::asprintf("%0.1f", float(toInteger(szReturnBuffer))*0.1f);
+            // That's everything, remember it for next time
+            nRefreshIndex = QUANTUM_REFRESH_COUNT;
+            QuantumInfoCache::save(qsPortName, staticInfo);
+            startupFinished();
+            break;
 
-    // Model String
-    if(!sendCommand(qCmdGetModelName))
-        return false;
+        default:
+            return false;
+        }
 
-    qsModelString = QString::fromUtf8(szReturnBuffer);
+    return true;
+    }
 
-    // Design wavelength
-    if(!sendCommand(qCmdGetBandwidth))
-        return false;
 
-     qsBandwidthString = QString::fromUtf8(szReturnBuffer);
+///////////////////////////////////////////////////////////////////////////////////////////
+// Put a static info reply where it goes
+void QuantumDevice::storeStaticReply(QuantumCommandCode code, QuantumStaticInfo* pInfo)
+    {
+    QString qsReply = QString::fromUtf8(framer.getData(), framer.getLength());
 
-     // Number of boots and run time. Does not seem to work. Always times out.
-     //sendCommand("GY\n");
+    switch(code) {
+        case QCMD_GET_SERIAL_NUMBER:
+            pInfo->qsSerialNumber = qsReply;
+            break;
 
-    return true;
+        case QCMD_GET_BODY_STYLE:
+            pInfo->nBodyStyle = toInteger();
+            break;
+
+        case QCMD_GET_DESIGN_WAVELENGTH:
+            pInfo->qsDesignWavelength = QString::asprintf("%0.1f", float(toInteger())*0.1f);
+            break;
+
+        case QCMD_GET_MODEL_NAME:
+            pInfo->qsModelString = qsReply;
+            break;
+
+        case QCMD_GET_BANDWIDTH:
+            pInfo->qsBandwidthString = qsReply;
+            break;
+
+        default:
+            break;
+        }
     }
 
+///////////////////////////////////////////////////////////////////////////////////////////
+// We know who we are talking to, and already have a status. We are in business.
+void QuantumDevice::startupFinished(void)
+    {
+    nConnectTime = connectTimer.elapsed();
+    openHistory();
+
+    emit connectedToQuantum(this);
+    updateStatus();
+    }
 
 ///////////////////////////////////////////////////////////////////////////////////////////
-/// Parse the status string
-/// example: v2.00 00 01 0001005C 00 0026 039D 0000289F 00000488 00000000 00002EE0 00ED
-/// Firmware Version
-/// On Error code
-/// On band indicator
-/// Wavelength
-/// Wingshift
-/// Current first heater raw PMW
-/// First heater PMW Limit
-/// Temperature of first heater
-/// Temperature of the second heater (optional)
-/// Current Voltage
-/// Calibration pot position
-/// 2nd heater temperature
-/// 2nd heater pmw
-///
-void QuantumDevice::parseStatusInfo()
-{
-    // NO... use the GA command to get the body style
-    // Count the number of spaces so we now if we have two heaters or one
-    int nSpaces = 0;
-    int length = strlen(szReturnBuffer);
-    for(int i = 0; i < length; i++)
-        if(szReturnBuffer[i] == 32)
-            nSpaces++;
-
-    _deviceStatus.bDualHeaters = (nSpaces > 11);
-
-    // First field is firmware, we already have that
-    char *nextField = strtok(szReturnBuffer, " ");
-    (void)nextField;
-
-    // Next field is the error code
-    nextField = strtok(NULL, " ");
-    _deviceStatus.nErrorCode = toInteger(nextField);
-
-    // Next field is on band indication
-    nextField = strtok(NULL, " ");
-    _deviceStatus.bOnBand = (toInteger(nextField) == 1);
-
-    // Current wavelength
-    nextField = strtok(NULL, " ");
-    int currWavelength = toInteger(nextField);
-    _deviceStatus.centerWavelength = float(currWavelength) * 0.1f;
-
-    // Wingshift
-    nextField = strtok(NULL, " ");
-    int currWingShift = toSignedInteger(nextField);
-    _deviceStatus.wingShift = float(currWingShift) * 0.1f;
-
-    // First heaters raw PMW
-    nextField = strtok(NULL, " ");
-    int pmw = toInteger(nextField);
-
-    // PMW Limit
-    nextField = strtok(NULL, " ");
-    _deviceStatus.heater1PMWLimit = toInteger(nextField);
-    _deviceStatus.heater1PMW = (float(pmw) * 100.0f) / float(_deviceStatus.heater1PMWLimit);
-
-    // Temperature of first heater
-    nextField = strtok(NULL, " ");
-    int temp = toInteger(nextField);
-    _deviceStatus.heater1Temprature = float(temp) * 0.01;
-
-    // Temperature of the second heater
-    if(_deviceStatus.bDualHeaters) {
-        nextField = strtok(NULL, " ");
-        temp = toInteger(nextField);
-        _deviceStatus.heater2Temperature = float(temp) * 0.01;
-       }
-
-    // Input voltage
-    nextField = strtok(NULL, " ");
-    _deviceStatus.inputVoltage = float(toInteger(nextField)) * 0.01;
-
-    // Calibration Pot Position
-    nextField = strtok(NULL, " ");
-    _deviceStatus.calibrationPotPos = toInteger(nextField);
-
-    // Second heater duty cycle (if present)
-    if(_deviceStatus.bDualHeaters) {
-        // First heaters raw PMW
-        nextField = strtok(NULL, " ");
-        int pmw = toInteger(nextField);
-
-        // PMW Limit
-        nextField = strtok(NULL, " ");
-        _deviceStatus.heater2PMWLimit = toInteger(nextField);
-        _deviceStatus.heater2PMW = (float(pmw) * 100.0f) / float(_deviceStatus.heater2PMWLimit);
+// Start (or pick up) the history file for whichever filter this is
+void QuantumDevice::openHistory(void)
+    {
+    recorder.close();
+
+    mutexBlocker.lock();
+    bool bRecord = bRecordHistory;
+    QString qsSerialNumber = staticInfo.qsSerialNumber;
+    qsHistoryFile.clear();
+    mutexBlocker.unlock();
+
+    if(!bRecord)
+        return;
+
+    // Not being able to record is no reason not to run the filter
+    QString qsFile = QuantumRecorder::fileForSerial(qsSerialNumber);
+    if(!recorder.open(qsFile))
+        return;
+
+    // The status that came with the startup GI went out before we knew whose history
+    // this is. It belongs in here too.
+    if(nSampleCount != 0) {
+        QuantumStatusSnapshot snapshot;
+        statusPublisher.read(&snapshot);
+        recorder.append(snapshot);
+        }
+
+    mutexBlocker.lock();
+    qsHistoryFile = qsFile;
+    mutexBlocker.unlock();
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// Ask for the next piece of static info we took from the cache. False if there's
+// nothing left to check.
+bool QuantumDevice::sendNextRefresh(void)
+    {
+    if(nRefreshIndex >= QUANTUM_REFRESH_COUNT)
+        return false;
+
+    sendCommand(QuantumCommand(refreshCommands[nRefreshIndex]), STAGE_REFRESH_INFO);
+    return true;
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////
+// One piece of cached info has been checked. When they all have, if anything was
+// different, the device wins and the cache is fixed. If the device doesn't answer,
+// we keep what we have and try again on the next connection.
+void QuantumDevice::refreshFinished(bool bSuccess)
+    {
+    if(!bSuccess) {
+        nRefreshIndex = QUANTUM_REFRESH_COUNT;
+        return;
         }
 
+    storeStaticReply(refreshCommands[nRefreshIndex], &refreshedInfo);
+    nRefreshIndex++;
+
+    if(nRefreshIndex < QUANTUM_REFRESH_COUNT)
+        return;
+
     mutexBlocker.lock();
-    memcpy(&deviceStatus, &_deviceStatus, sizeof(QuantumStatus));
+    bool bChanged = (refreshedInfo != staticInfo);
+    if(bChanged)
+        staticInfo = refreshedInfo;
     mutexBlocker.unlock();
+
+    if(bChanged) {
+        QuantumInfoCache::save(qsPortName, refreshedInfo);
+
+        // Not the filter we remembered, its history goes somewhere else
+        if(refreshedInfo.qsSerialNumber != cachedInfo.qsSerialNumber)
+            openHistory();
+
+        emit staticInfoChanged();
+        }
+    }
+
+///////////////////////////////////////////////////////////////////////////////////////////
+/// Parse the status string, straight out of the framer. See quantumparser.h for the
+/// layout. A garbled reply is dropped and the last good status stands. Good status is
+/// stamped and published for everyone else.
+bool QuantumDevice::parseStatusInfo()
+{
+    bool bParsed;
+    {
+        QUANTUM_TRACE_SCOPE("parse");
+        bParsed = pfnParseStatus(framer.getData(), framer.getLength(), &_deviceStatus);
+    }
+
+    if(!bParsed) {
+        ioMetrics.commands[QCMD_GET_INFO].nParseFailures++;
+        return false;
+        }
+
+    ioMetrics.nSamples++;
+
+    // Publish it. No lock, readers sort themselves out.
+    QuantumStatusSnapshot snapshot;
+    snapshot.status = _deviceStatus;
+    snapshot.nSequence = ++nSampleCount;
+    snapshot.nCaptureTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+    snapshot.nWallTime = QDateTime::currentMSecsSinceEpoch();
+
+    // Where it's headed, and how fast it's getting there. Nothing to go on until
+    // the design wavelength is in.
+    if(staticInfo.qsDesignWavelength != qsDriftDesign) {
+        qsDriftDesign = staticInfo.qsDesignWavelength;
+        fDriftDesign = qsDriftDesign.toFloat();
+        }
+
+    if(fDriftDesign > 0.0f) {
+        float fTarget = floorf((fDriftDesign + _deviceStatus.wingShift) * 10.0f) * 0.1f;
+        driftEstimator.update(snapshot, fTarget, &snapshot.drift);
+        }
+    else {
+        memset(&snapshot.drift, 0, sizeof(snapshot.drift));
+        snapshot.drift.fSecondsToOnBand = -1.0f;
+        }
+
+    QUANTUM_TRACE_SCOPE("publish status");
+    statusPublisher.write(snapshot);
+    if(pPushServer != nullptr)
+        pPushServer->publish(snapshot);
+    shmWriter.publish(snapshot);
+    recorder.append(snapshot);
+
+    return true;
 }
 
 
 
 ////////////////////////////////////////////////////////////////////////////////////////////
-/// This is the polling function. It calls a one shot timer each cycle to prevent flooding
-/// the message queue if it get's backed up.
+/// This is the polling function. It runs any queued command and then the GI (Get Info).
+/// The poll scheduler decides when the next one is, and a new command polls right away.
+/// If an exchange is already under way, the request is remembered and handled as soon
+/// as that finishes, so there is only ever one poll cycle in flight.
 void QuantumDevice::updateStatus(void)
 {
-    QString cmd;
+    // Closed, or never opened
+    if(pSerialPort == nullptr)
+        return;
+
+    if(deviceStage != STAGE_IDLE) {
+        bUpdateRequested = true;
+        return;
+        }
+
+    pPollTimer->stop();
+    bUpdateRequested = false;
+
+    // One poll cycle, queued commands and the GI, from here to pollFinished()
+    QUANTUM_TRACE_ASYNC_BEGIN("poll cycle", quintptr(this));
+
+    // Are there any commands in the queue to be run? GI follows when they are done
+    if(sendNextQueuedCommand())
+        return;
+
+    // Every cycle, we want the GI (Get Info) to run which contains a lot of useful data
+    sendCommand(QuantumCommand(QCMD_GET_INFO), STAGE_POLL_INFO);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+/// Send the next queued command, if there is one. The queue has already thrown out
+/// any settings that were superseded while they waited.
+bool QuantumDevice::sendNextQueuedCommand(void)
+{
+    QUANTUM_TRACE_SCOPE("dequeue");
+
+    QuantumCommand command;
+    bool bLastCommand = false;
+    bool bPipeline = false;
     mutexBlocker.lock();
-    if(!commandQueue.isEmpty())
-        cmd = commandQueue.dequeue();
+    if(commandQueue.isEmpty()) {
+        mutexBlocker.unlock();
+        return false;
+        }
+
+    command = commandQueue.dequeue();
+    bLastCommand = commandQueue.isEmpty();
+    bPipeline = bPipelined && !bPipelineFailed;
     mutexBlocker.unlock();
 
-    // Are there any commands in the queue to be run?
-    if(!cmd.isEmpty()) {
-        // Send the command
-        sendCommand(cmd.toUtf8());
+    if(command.code == QCMD_SET_WINGSHIFT)
+        bSetpointSent = true;
 
-        // Check return based on command
-        // E OK
-        //printf("%s\n", szReturnBuffer);
+    // Something is about to change, keep a close eye on it
+    mutexBlocker.lock();
+    pollScheduler.commandSent(uptimeTimer.elapsed());
+    mutexBlocker.unlock();
+
+    // The last command of the cycle takes the GI along with it. Both replies come back in
+    // one round trip instead of two.
+    if(bLastCommand && bPipeline) {
+        bPipelinedCycle = true;
+        sendPipelinedCommand(command);
+        return true;
         }
 
-    // Every cycle, we want the GI (Get Info) to run which contains a lot of useful data
-    if(sendCommand(qCmdGetInfo))
-        parseStatusInfo();
-    else {
-        emit fatalError(-1);
+    sendCommand(command, STAGE_USER_COMMAND);
+
+    if(bLastCommand) {
+        mutexBlocker.lock();
+        pipelineStats.nSequentialCycles++;
+        mutexBlocker.unlock();
+        }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+/// Back to sending commands one at a time for the rest of this connection.
+void QuantumDevice::pipelineFailed(void)
+{
+    bPipelinedCycle = false;
+
+    // A pair that times out comes here from the timeout and again when it gives up
+    if(bPipelineFailed)
         return;
+
+    mutexBlocker.lock();
+    bPipelineFailed = true;
+    pipelineStats.nFallbacks++;
+    mutexBlocker.unlock();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+/// Fresh status is in. Publish it and schedule the next cycle.
+void QuantumDevice::pollFinished(void)
+{
+    bool bParsed = parseStatusInfo();
+    if(!bParsed)
+        ioMetrics.nMissedSamples++;
+
+    // One round trip got us the command reply and the status
+    if(bPipelinedCycle) {
+        if(bParsed) {
+            mutexBlocker.lock();
+            pipelineStats.nPipelinedCycles++;
+            pipelineStats.nRoundTripsSaved++;
+            mutexBlocker.unlock();
+            bPipelinedCycle = false;
+            }
+        else
+            pipelineFailed(); // The replies didn't split cleanly
+        }
+
+    if(bParsed) {
+        // This GI went out after the wingshift did, so the status has it now. Unless
+        // another one is already waiting.
+        if(bSetpointSent) {
+            mutexBlocker.lock();
+            if(!commandQueue.hasPending(QCMD_SET_WINGSHIFT))
+                bWingshiftRequested = false;
+            mutexBlocker.unlock();
+            bSetpointSent = false;
+            }
+
+        QUANTUM_TRACE_SCOPE("emit statusUpdated");
+        emit statusUpdated();
         }
-        
-    emit statusUpdated();
 
-    // Do this again in a second...
-    QTimer::singleShot(1000, this, &QuantumDevice::updateStatus);
+    QUANTUM_TRACE_ASYNC_END("poll cycle", quintptr(this));
+
+    // Do this again soon, how soon depends on what the filter is up to
+    mutexBlocker.lock();
+    int nInterval = bParsed ? pollScheduler.sampleTaken(_deviceStatus, uptimeTimer.elapsed())
+                            : pollScheduler.getInterval();
+    mutexBlocker.unlock();
+
+    pPollTimer->start(nInterval);
+
+    // If we started from the cache, check one more piece of it while we wait. An
+    // update someone asked for goes right after that.
+    if(sendNextRefresh())
+        return;
+
+    // Someone asked for an update while we were busy, don't make them wait
+    if(bUpdateRequested)
+        updateStatus();
 }
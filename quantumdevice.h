@@ -21,131 +21,418 @@ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
 OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE
 */
-/* Communications with the Quantum filter is done via this thread. Communications
- * on done on a thread so the GUI is never blocked on I/O operations.
+/* Communications with the Quantum filter is done via this object, which lives on one
+ * of the I/O threads of the QuantumDeviceManager. Communications are done on a thread
+ * so the GUI is never blocked on I/O operations. Any number of devices can share one
+ * I/O thread.
  *
+ * All I/O is event driven. A command is written, and the reply is gathered as the
+ * readyRead signals come in. The framer decides when the reply is complete, and
+ * the next step of whatever sequence we are in (startup or polling) is kicked off
+ * from there. Nothing ever sits and waits on the serial port.
 */
 #ifndef QUANTUMDEVICE_H
 #define QUANTUMDEVICE_H
 
-#include <QThread>
+#include <QObject>
 #include <QMutex>
 #include <QQueue>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QSerialPortInfo>
 #include <QSerialPort>
 
-// Size of the return buffer
-#define MAX_COMM_BUFFER_SIZE    1024
+#include "quantumframer.h"
+#include "quantumstatus.h"
+#include "quantumseqlock.h"
+#include "quantumparser.h"
+#include "quantumcommand.h"
+#include "quantumcommandqueue.h"
+#include "quantumpollscheduler.h"
+#include "quantuminfocache.h"
+#include "quantummetrics.h"
+#include "quantumrecorder.h"
+#include "quantumdrift.h"
+#include "quantumpush.h"
+#include "quantumshmwriter.h"
+
+class QuantumPushServer;
 
 // TIMEOUT value in milliseconds (initially 1 second)
 #define QUANTUM_TIMEOUT 1000
 
+// Replies with no terminator and no known shape are done when the line goes quiet
+// for this long (milliseconds). USB serial adapters can hold bytes for 16ms before
+// passing them on, so this has to be a bit longer than that.
+#define QUANTUM_GAP_TIMEOUT 40
+
 /////////////////////////////////////////////////////////////
-/// Device status, updated by device thread.
-///
-struct QuantumStatus {
-    int     nErrorCode;
-    float   centerWavelength;
-    float   wingShift;
-    float   heater1PMW;
-    int     heater1PMWLimit;
-    float   heater1Temprature;
-    float   heater2Temperature;
-    float   inputVoltage;
-    int     calibrationPotPos;
-    float   heater2PMW;
-    int     heater2PMWLimit;
-
-    int32_t nBootCount;
-    int32_t nRunMinutes;
-
-    bool    bOnBand;
-    bool    bDualHeaters;
+/// How the pipelined command + status exchange is doing
+struct QuantumPipelineStats {
+    quint64 nPipelinedCycles;   // Command and GI went out together
+    quint64 nSequentialCycles;  // Command and GI went out one after the other
+    quint64 nRoundTripsSaved;   // Round trips we didn't have to make
+    quint64 nFallbacks;         // Times we had to give up on pipelining
 };
 
 
-class QuantumDevice : public QThread
+class QuantumDevice : public QObject
 {
     Q_OBJECT
 public:
     explicit QuantumDevice(QObject *parent, QSerialPortInfo serialPortInformation);
+    explicit QuantumDevice(QObject *parent, const QString& qsPort);  // Name or full path, for ports
+                                                                    // that aren't enumerated (ptys)
     ~QuantumDevice(void);
 
     const QSerialPortInfo& getSerialPortInfo(void) { return serialPortInfo; }
+    const QString& getPortName(void) { return qsPortName; }
+
+    // Line settings for talking to a Quantum
+    static void configureSerialPort(QSerialPort *pPort);
+
+    // When we connect from the cache, these are checked again in the background, and
+    // can change (once) after connectedToQuantum. staticInfoChanged() says when.
+    QString getSerialNumber(void) { return getStaticInfo().qsSerialNumber; }
+    QString getFirmwareVersion(void) { return getStaticInfo().qsFirmwareVersion; }
+    QString getBandwidthString(void) { return getStaticInfo().qsBandwidthString; }
+    QString getModelString(void) { return getStaticInfo().qsModelString; }
+    QString getWavelengthString(void) { return getStaticInfo().qsDesignWavelength; }
 
-    // Not protected as the thread does not touch these after startup
-    const QString& getSerialNumber(void) { return qsSerialNumber; }
-    const QString& getFirmwareVersion(void) { return qsFirmwareVersion; }
-    const QString& getBandwidthString(void) { return qsBandwidthString; }
-    const QString& getModelString(void) { return qsModelString; }
-    const QString& getWavelengthString(void) { return qsDesignWavelength; }
+    QuantumStaticInfo getStaticInfo(void) {
+        mutexBlocker.lock();
+        QuantumStaticInfo info = staticInfo;
+        mutexBlocker.unlock();
+        return info;
+    }
 
-    // All protected items
+    // Milliseconds from open() to connectedToQuantum, and whether the cache got us there.
+    // Set before connectedToQuantum goes out, and never again.
+    qint64 getConnectTime(void) { return nConnectTime; }
+    bool wasConnectedFromCache(void) { return bFromCache; }
+
+    // Status is published with a sequence lock, not the mutex. Read it as often
+    // as you like, the device thread never waits on a reader.
     void getDeviceStatus(QuantumStatus* pStatus) {
+        QuantumStatusSnapshot snapshot;
+        statusPublisher.read(&snapshot);
+        *pStatus = snapshot.status;
+    }
+
+    // Same, with the sample number and when it was taken
+    void getStatusSnapshot(QuantumStatusSnapshot* pSnapshot) {
+        statusPublisher.read(pSnapshot);
+    }
+
+    // Goes up by one with every new sample
+    quint64 getStatusSequence(void) { return statusPublisher.getVersion(); }
+
+    // Drift rates and when it should be on band, as of the latest sample. Plan
+    // around nOnBandTime rather than polling for bOnBand.
+    void getDrift(QuantumDrift* pDrift) {
+        QuantumStatusSnapshot snapshot;
+        statusPublisher.read(&snapshot);
+        *pDrift = snapshot.drift;
+    }
+
+    // All mutex protected items
+
+    // When a command is sent, the GI goes right behind it, and both replies come
+    // back in one round trip. On by default. If the device can't keep up, this
+    // falls back to one command at a time on its own.
+    void setPipelined(bool bEnable) {
         mutexBlocker.lock();
-        memcpy(pStatus, &deviceStatus, sizeof(QuantumStatus));
+        bPipelined = bEnable;
         mutexBlocker.unlock();
     }
 
-    // This just adds the command to be serviced next cycle.
-    void addCommand(const QString qsCommand) {
+    // Every sample also goes into a ring file on disk, one per filter, so the history
+    // survives a crash or restart. On by default, takes effect at the next connect.
+    // Read it with QuantumRecorder::openReadOnly(), empty until it is open.
+    void setRecordHistory(bool bEnable) {
         mutexBlocker.lock();
-        commandQueue.enqueue(qsCommand);
+        bRecordHistory = bEnable;
+        mutexBlocker.unlock();
+    }
+
+    QString getHistoryFile(void) {
+        mutexBlocker.lock();
+        QString qsFile = qsHistoryFile;
+        mutexBlocker.unlock();
+        return qsFile;
+    }
+
+    // Push every sample to other programs over TCP, and let them send commands, see
+    // quantumpush.h. Loopback only unless told otherwise. Takes effect on the I/O
+    // thread, getPushPort() says where it ended up listening, 0 if it couldn't.
+    void startPushServer(quint16 nPort = QPUSH_DEFAULT_PORT, bool bLoopbackOnly = true) {
+        mutexBlocker.lock();
+        bPushWanted = true;
+        nPushPort = nPort;
+        bPushLoopback = bLoopbackOnly;
+        mutexBlocker.unlock();
+        QMetaObject::invokeMethod(this, "applyPushServer", Qt::QueuedConnection);
+    }
+
+    void stopPushServer(void) {
+        mutexBlocker.lock();
+        bPushWanted = false;
+        mutexBlocker.unlock();
+        QMetaObject::invokeMethod(this, "applyPushServer", Qt::QueuedConnection);
+    }
+
+    quint16 getPushPort(void) {
+        mutexBlocker.lock();
+        quint16 nPort = nPushListening;
+        mutexBlocker.unlock();
+        return nPort;
+    }
+
+    // Write every sample into a POSIX shared memory segment too, for programs on this
+    // machine that want it for every frame, see quantumshm.h. Takes effect on the I/O
+    // thread, isSharingStatus() says whether it worked.
+    void startSharedStatus(const QString& qsName = QSHM_DEFAULT_NAME) {
+        mutexBlocker.lock();
+        bShmWanted = true;
+        qsShmName = qsName;
+        mutexBlocker.unlock();
+        QMetaObject::invokeMethod(this, "applySharedStatus", Qt::QueuedConnection);
+    }
+
+    void stopSharedStatus(void) {
+        mutexBlocker.lock();
+        bShmWanted = false;
+        mutexBlocker.unlock();
+        QMetaObject::invokeMethod(this, "applySharedStatus", Qt::QueuedConnection);
+    }
+
+    bool isSharingStatus(void) {
+        mutexBlocker.lock();
+        bool bSharing = bShmOpen;
+        mutexBlocker.unlock();
+        return bSharing;
+    }
+
+    void getPipelineStats(QuantumPipelineStats* pStats) {
+        mutexBlocker.lock();
+        memcpy(pStats, &pipelineStats, sizeof(QuantumPipelineStats));
+        mutexBlocker.unlock();
+    }
+
+    // Link counters and round trip histograms, per command. See quantummetrics.h.
+    // Up to date as of the last exchange.
+    void getIOMetrics(QuantumIOMetrics* pMetrics) {
+        mutexBlocker.lock();
+        memcpy(pMetrics, &publishedMetrics, sizeof(QuantumIOMetrics));
+        mutexBlocker.unlock();
+    }
+
+    // Start counting again. Takes effect on the I/O thread after the next exchange.
+    void resetIOMetrics(void) {
+        mutexBlocker.lock();
+        bResetMetrics = true;
+        quantumResetMetrics(&publishedMetrics);
+        mutexBlocker.unlock();
+    }
+
+    // How quickly to poll in each state. See quantumpollscheduler.h
+    void setPollSettings(const QuantumPollSettings& settings) {
+        mutexBlocker.lock();
+        pollScheduler.setSettings(settings);
+        mutexBlocker.unlock();
+    }
+
+    QuantumPollSettings getPollSettings(void) {
+        mutexBlocker.lock();
+        QuantumPollSettings settings = pollScheduler.getSettings();
+        mutexBlocker.unlock();
+        return settings;
+    }
+
+    // Status samples per second we are actually getting
+    double getSampleRate(void) {
+        mutexBlocker.lock();
+        double fRate = pollScheduler.getSampleRate();
+        mutexBlocker.unlock();
+        return fRate;
+    }
+
+    // The wingshift we are headed to. This is the last one asked for if it hasn't
+    // shown up in the status yet, so repeated bumps build on each other.
+    float getTargetWingshift(void) {
+        QuantumStatus status;
+        getDeviceStatus(&status);
+
+        mutexBlocker.lock();
+        float fTarget = bWingshiftRequested ? fRequestedWingshift : status.wingShift;
+        mutexBlocker.unlock();
+        return fTarget;
+    }
+
+    // This just adds the command to be serviced as soon as possible. A setting that
+    // is still waiting to go out is replaced by this one. Returns false if the queue
+    // is full.
+    bool addCommand(const QuantumCommand& command) {
+        mutexBlocker.lock();
+        bool bQueued = (commandQueue.enqueue(command) != QuantumCommandQueue::COMMAND_QUEUE_FULL);
+        if(bQueued && command.code == QCMD_SET_WINGSHIFT) {
+            fRequestedWingshift = float(command.nValue) * 0.1f;
+            bWingshiftRequested = true;
+            }
         mutexBlocker.unlock();
 
         // Update the device as soon as possible
         QMetaObject::invokeMethod(this, "updateStatus", Qt::QueuedConnection);
+        return bQueued;
     }
 
 
 
 protected:
-    QQueue<QString>     commandQueue;           // Commands queued up to send to hardware
+    // Where we are in a command sequence. When a reply completes, this says what
+    // to do with it and what to send next.
+    enum DeviceStage {
+        STAGE_IDLE,
+        STAGE_STARTUP_INFO,
+        STAGE_STARTUP_SERIAL,
+        STAGE_STARTUP_BODY,
+        STAGE_STARTUP_WAVELENGTH,
+        STAGE_STARTUP_MODEL,
+        STAGE_STARTUP_BANDWIDTH,
+        STAGE_REFRESH_INFO,
+        STAGE_USER_COMMAND,
+        STAGE_PIPELINED_COMMAND,
+        STAGE_POLL_INFO
+    };
+
+    QuantumCommandQueue commandQueue;           // Commands queued up to send to hardware
     QSerialPort         *pSerialPort = nullptr; // No one outside this thread is to have access to this
     QSerialPortInfo     serialPortInfo;         // Details about the serial connection
+    QString             qsPortName;             // What we open. Null info if given by path
     QMutex              mutexBlocker;           // Protects shared dynamic data
-    char                szReturnBuffer[MAX_COMM_BUFFER_SIZE];   // Global return buffer for this instance
+
+    // I/O engine, only touched by this thread
+    QuantumFramer       framer;                     // Assembles the reply as it arrives, and holds
+                                                    // the last completed reply
+    QTimer              *pReplyTimer = nullptr;     // No reply at all, retry
+    QTimer              *pGapTimer = nullptr;       // Reply has gone quiet, it's done
+    QTimer              *pPollTimer = nullptr;      // Next status poll
+    QElapsedTimer       commandTimer;               // Time since command was written
+    QElapsedTimer       uptimeTimer;                // Clock for the poll scheduler
+    QuantumCommand      pendingCommand;             // Command in flight
+    QuantumCommand      pipelinedCommand;           // Command that went out ahead of a GI
+    char                szTxBuffer[QUANTUM_MAX_COMMAND_SIZE * 2];   // Encoded, kept for retries
+    int                 nTxLength = 0;
+    bool                bPendingIdempotent = true;  // Ok to retry
+    DeviceStage         deviceStage = STAGE_IDLE;
+    int                 nTries = 0;
+    int                 nExpectedFields = 0;        // Shape of the reply we are waiting for
+    int                 nExpectedLastWidth = 0;
+    const char          *szExpectedMarker = nullptr;    // Start of a reply coming right behind
+    int                 nStatusFields = 0;          // Shape of a GI reply, learned at startup
+    int                 nStatusLastWidth = 0;
+    char                szStatusMarker[16] = { 0 }; // Every GI reply starts with this
+    bool                bUpdateRequested = false;   // Someone wanted a poll while we were busy
+    bool                bSetpointSent = false;      // A wingshift went out this cycle
+    bool                bPipelinedCycle = false;    // This cycle's GI went out with a command
+    int                 nPipelinedLength = 0;       // Bytes of szTxBuffer that are the command, not the GI
+    enum { TRACE_REPLY_NONE, TRACE_REPLY_WAITING, TRACE_REPLY_DRAINING };
+    int                 nTraceReply = TRACE_REPLY_NONE; // Which part of the reply the trace is in
+    QuantumIOMetrics    ioMetrics;                  // Kept here, copied out to publishedMetrics
 
     // These are statically set once at thread startup, before the thread can be accessed
     // Thus, no protection is required
-    QString             qsSerialNumber;
-    QString             qsFirmwareVersion;
-    QString             qsBandwidthString;
-    QString             qsModelString;
-    QString             qsDesignWavelength;
-    int                 nBodyStyle = 0;
     bool                bOldFirmware = false;
+    QuantumStatusParser pfnParseStatus = nullptr;   // Picked for this firmware and heaters
+    QElapsedTimer       connectTimer;               // Started by open()
+    qint64              nConnectTime = -1;
+    bool                bFromCache = false;
+
+    // Static info from the cache, being checked against the device a piece at a time
+    QuantumStaticInfo   cachedInfo;
+    bool                bCacheLoaded = false;
+    QuantumStaticInfo   refreshedInfo;
+    int                 nRefreshIndex = 0;          // Next one to check, none left at the end
 
     //////////////////////////////////////////////////////////////////
-    // These are all shared and must be synchronized.
-    QuantumStatus   deviceStatus;
+    // Status is parsed into _deviceStatus by this thread, then published
+    QuantumSeqLock<QuantumStatusSnapshot> statusPublisher;
     QuantumStatus   _deviceStatus;
+    quint64         nSampleCount = 0;
+    QuantumRecorder recorder;                       // Every sample, on disk
+    QuantumDriftEstimator driftEstimator;
+    QString         qsDriftDesign;                  // Design wavelength the target is worked out from
+    float           fDriftDesign = 0.0f;
+    QuantumPushServer *pPushServer = nullptr;       // Lives on this thread too
+    QuantumShmWriter shmWriter;                     // Shared memory segment, if wanted
+
+    //////////////////////////////////////////////////////////////////
+    // These are all shared and must be synchronized.
+    float           fRequestedWingshift = 0.0f;     // Last wingshift asked for
+    bool            bWingshiftRequested = false;    // and it's not in the status yet
+    QuantumStaticInfo staticInfo;                   // Written freely during startup, locked after
+    bool            bPipelined = true;              // Send the GI along with commands
+    bool            bPipelineFailed = false;        // Device couldn't keep up, stopped trying
+    QuantumPipelineStats pipelineStats = { 0, 0, 0, 0 };
+    QuantumIOMetrics publishedMetrics;
+    bool            bResetMetrics = false;
+    QuantumPollScheduler pollScheduler;             // When to poll next
+    bool            bRecordHistory = true;          // Keep every sample on disk
+    QString         qsHistoryFile;                  // Where, once it is open
+    bool            bPushWanted = false;            // Push server settings
+    quint16         nPushPort = 0;
+    bool            bPushLoopback = true;
+    quint16         nPushListening = 0;             // Where it is, 0 for not running
+    bool            bShmWanted = false;             // Shared memory segment settings
+    QString         qsShmName;
+    bool            bShmOpen = false;               // and whether it's being written
 
 
     //////////////////////////////////////
     /// Internal only utility functions
-    bool sendCommand(const char* szCommand);
-
-    bool getStaticInfoFromDevice(void);
-    int  toInteger(const char* szStringField);
-    int  toSignedInteger(const char* szStringField);
-    void parseStatusInfo(void);
+    void sendCommand(const QuantumCommand& command, DeviceStage nextStage);
+    void sendPipelinedCommand(const QuantumCommand& command);
+    void writeCommand(void);
+    void pipelinedCommandFinished(void);
+    void pipelineFailed(void);
+    void finishCommand(bool bSuccess);
+    void publishMetrics(void);
+    void traceReplyEnd(void);
+    void openHistory(void);
+    void commandFinished(DeviceStage finishedStage, bool bSuccess);
+    void pollFinished(void);
+    bool sendNextQueuedCommand(void);
+
+    bool getStaticInfoFromDevice(DeviceStage finishedStage);
+    void storeStaticReply(QuantumCommandCode code, QuantumStaticInfo* pInfo);
+    void startupFinished(void);
+    bool sendNextRefresh(void);
+    void refreshFinished(bool bSuccess);
+    int  toInteger(void);
+    bool parseStatusInfo(void);
 
 
-    // Thread starts here
-    virtual void run();
-
     // All of these need to be queued connections
 public Q_SLOTS:
+    void open(void);                                    // Called on the I/O thread to get started
+    void close(void);                                   // and to shut down
     void updateStatus(void);
 
+protected Q_SLOTS:
+    void serialReadyRead(void);
+    void replyTimedOut(void);
+    void replyWentQuiet(void);
+    void applyPushServer(void);
+    void applySharedStatus(void);
+
 
 signals:
     void connectedToQuantum(QuantumDevice* pDevice);    // Connection was successful
     void couldNotOpen(QuantumDevice* pDevice);          // No connection could be made
 
     void statusUpdated(void);                           // Signals new data is available
+    void staticInfoChanged(void);                       // The cache was out of date
+    void commandCompleted(int nCommandCode, bool bSuccess, qint64 nMicroseconds); // Every command/reply exchange
     void fatalError(int nErrorCode);                    // A communications error has occured
 
 };
@@ -0,0 +1,126 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+
+#include "quantumdevicemanager.h"
+
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Start up the I/O threads. They just run an event loop, the devices do the rest.
+QuantumDeviceManager::QuantumDeviceManager(QObject *parent, int nIOThreads) : QObject(parent)
+{
+    if(nIOThreads < 1)
+        nIOThreads = 1;
+
+    for(int i = 0; i < nIOThreads; i++) {
+        QThread *pThread = new QThread(this);
+        pThread->setObjectName(QString::asprintf("Quantum I/O %d", i));
+        pThread->start();
+        threadList.append(pThread);
+        threadLoad.append(0);
+        }
+}
+
+QuantumDeviceManager::~QuantumDeviceManager(void)
+{
+    shutdown();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+QuantumDevice* QuantumDeviceManager::addDevice(const QSerialPortInfo& portInfo)
+{
+    return startDevice(new QuantumDevice(nullptr, portInfo));
+}
+
+QuantumDevice* QuantumDeviceManager::addDevice(const QString& qsPort)
+{
+    return startDevice(new QuantumDevice(nullptr, qsPort));
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// The device goes on whichever thread has the fewest devices. It is moved there before
+// it is opened, so everything it does from then on happens on that thread.
+QuantumDevice* QuantumDeviceManager::startDevice(QuantumDevice* pDevice)
+{
+    Q_ASSERT(!threadList.isEmpty());
+
+    int iThread = 0;
+    for(int i = 1; i < threadList.size(); i++)
+        if(threadLoad[i] < threadLoad[iThread])
+            iThread = i;
+
+    pDevice->moveToThread(threadList[iThread]);
+
+    connect(pDevice, &QuantumDevice::connectedToQuantum, this, &QuantumDeviceManager::connectedToQuantum, Qt::QueuedConnection);
+    connect(pDevice, &QuantumDevice::couldNotOpen, this, &QuantumDeviceManager::couldNotOpen, Qt::QueuedConnection);
+    connect(pDevice, &QuantumDevice::fatalError, this, [this, pDevice](int nErrorCode) {
+        emit fatalError(pDevice, nErrorCode);
+        }, Qt::QueuedConnection);
+
+    deviceList.append(pDevice);
+    deviceThread.append(iThread);
+    threadLoad[iThread]++;
+
+    QMetaObject::invokeMethod(pDevice, "open", Qt::QueuedConnection);
+    return pDevice;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// The port is closed on the device's own thread, and we wait for that. The device
+// itself is deleted there too, the next time its thread gets around to it.
+void QuantumDeviceManager::removeDevice(QuantumDevice* pDevice)
+{
+    int iDevice = deviceList.indexOf(pDevice);
+    if(iDevice < 0)
+        return;
+
+    int iThread = deviceThread[iDevice];
+    deviceList.removeAt(iDevice);
+    deviceThread.removeAt(iDevice);
+    threadLoad[iThread]--;
+
+    // Nothing more from this one
+    disconnect(pDevice, nullptr, this, nullptr);
+
+    if(threadList[iThread]->isRunning())
+        QMetaObject::invokeMethod(pDevice, "close", Qt::BlockingQueuedConnection);
+
+    pDevice->deleteLater();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Anything still waiting to be deleted goes when its thread finishes
+void QuantumDeviceManager::shutdown(void)
+{
+    while(!deviceList.isEmpty())
+        removeDevice(deviceList.first());
+
+    for(int i = 0; i < threadList.size(); i++) {
+        threadList[i]->quit();
+        threadList[i]->wait();
+        }
+
+    qDeleteAll(threadList);
+    threadList.clear();
+    threadLoad.clear();
+}
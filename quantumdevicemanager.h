@@ -0,0 +1,78 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* Owns the I/O threads that the Quantum devices run on. Every device is event driven
+ * and never blocks, so one thread can service any number of them. The thread's event
+ * loop waits on all of their serial ports at once, and each device keeps its own
+ * state machine and poll schedule. More than one thread can be asked for, and devices
+ * are spread across them.
+ *
+ * Devices are created and destroyed here. Their signals are also forwarded from here,
+ * tagged with the device, so one connection covers every device.
+*/
+#ifndef QUANTUMDEVICEMANAGER_H
+#define QUANTUMDEVICEMANAGER_H
+
+#include <QObject>
+#include <QThread>
+#include <QList>
+#include <QSerialPortInfo>
+
+#include "quantumdevice.h"
+
+class QuantumDeviceManager : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QuantumDeviceManager(QObject *parent, int nIOThreads = 1);
+    ~QuantumDeviceManager(void);
+
+    // Make a device for this port and start connecting to it. Success or failure
+    // comes back through connectedToQuantum or couldNotOpen.
+    QuantumDevice* addDevice(const QSerialPortInfo& portInfo);
+    QuantumDevice* addDevice(const QString& qsPort);   // By name or path
+
+    // Close the port and get rid of the device. Don't touch it after this.
+    void removeDevice(QuantumDevice* pDevice);
+
+    // Close everything and stop the I/O threads
+    void shutdown(void);
+
+    const QList<QuantumDevice*>& getDevices(void) const { return deviceList; }
+    int getThreadCount(void) const { return threadList.size(); }
+
+protected:
+    QList<QThread*>         threadList;
+    QList<int>              threadLoad;         // Number of devices on each thread
+    QList<QuantumDevice*>   deviceList;
+    QList<int>              deviceThread;       // Which thread each device is on
+
+    QuantumDevice* startDevice(QuantumDevice* pDevice);
+
+signals:
+    void connectedToQuantum(QuantumDevice* pDevice);
+    void couldNotOpen(QuantumDevice* pDevice);
+    void fatalError(QuantumDevice* pDevice, int nErrorCode);
+};
+
+#endif // QUANTUMDEVICEMANAGER_H
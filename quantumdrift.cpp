@@ -0,0 +1,168 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+#include "quantumdrift.h"
+
+#include <math.h>
+
+// Off band by at least this much, moving the right way, and the rate counts toward
+// the learned slew rate. Close in, the filter slows down as it settles.
+#define DRIFT_SLEW_DISTANCE     0.15f
+
+// Slower than this toward the target isn't going anywhere, Angstroms per second
+#define DRIFT_MIN_RATE          0.0002f
+
+
+///////////////////////////////////////////////////////////////////////
+void QuantumDriftLine::clear(void)
+{
+    bStarted = false;
+    origin = sumW = sumT = sumY = sumTT = sumTY = 0.0;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Fade what's there by how long it has been, move the origin up to the new
+// sample (which is what the t*t and t*y sums need fixing for), and add it.
+void QuantumDriftLine::add(double time, double value)
+{
+    if(!bStarted) {
+        bStarted = true;
+        origin = time;
+        }
+
+    double dt = time - origin;
+    if(dt < 0.0)
+        dt = 0.0;
+
+    double decay = exp(-dt / QUANTUM_DRIFT_TIME);
+    sumW *= decay;
+    sumT *= decay;
+    sumY *= decay;
+    sumTT *= decay;
+    sumTY *= decay;
+
+    // Every old t becomes t - dt
+    sumTT += dt * dt * sumW - 2.0 * dt * sumT;
+    sumTY -= dt * sumY;
+    sumT -= dt * sumW;
+    origin = time;
+
+    // The new one is at t = 0
+    sumW += 1.0;
+    sumY += value;
+}
+
+///////////////////////////////////////////////////////////////////////
+bool QuantumDriftLine::isValid(void) const
+{
+    if(sumW < QUANTUM_DRIFT_MIN_WEIGHT)
+        return false;
+
+    return (sumW * sumTT - sumT * sumT) > 1.0e-9;
+}
+
+///////////////////////////////////////////////////////////////////////
+double QuantumDriftLine::getRate(void) const
+{
+    if(!isValid())
+        return 0.0;
+
+    return (sumW * sumTY - sumT * sumY) / (sumW * sumTT - sumT * sumT);
+}
+
+///////////////////////////////////////////////////////////////////////
+double QuantumDriftLine::getValue(void) const
+{
+    if(sumW <= 0.0)
+        return 0.0;
+
+    return (sumY - getRate() * sumT) / sumW;
+}
+
+
+///////////////////////////////////////////////////////////////////////
+void QuantumDriftEstimator::clear(void)
+{
+    wavelengthLine.clear();
+    temperatureLine.clear();
+    fLastTarget = 0.0f;
+    slewRates[0] = slewRates[1] = 0.0f;
+}
+
+///////////////////////////////////////////////////////////////////////
+void QuantumDriftEstimator::update(const QuantumStatusSnapshot& snapshot, float fTarget, QuantumDrift* pDrift)
+{
+    const QuantumStatus& status = snapshot.status;
+    double time = double(snapshot.nCaptureTime) / 1.0e9;
+
+    // New target, new regime. Holding still for the last while says nothing
+    // about how fast it's about to move.
+    if(fTarget != fLastTarget) {
+        wavelengthLine.clear();
+        temperatureLine.clear();
+        fLastTarget = fTarget;
+        }
+
+    wavelengthLine.add(time, status.centerWavelength);
+    temperatureLine.add(time, status.heater1Temprature);
+
+    pDrift->bValid = wavelengthLine.isValid();
+    pDrift->fWavelengthRate = float(wavelengthLine.getRate());
+    pDrift->fTemperatureRate = float(temperatureLine.getRate());
+    pDrift->fTarget = fTarget;
+    pDrift->fSecondsToOnBand = -1.0f;
+    pDrift->nOnBandTime = 0;
+
+    if(status.bOnBand) {
+        pDrift->fSecondsToOnBand = 0.0f;
+        pDrift->nOnBandTime = snapshot.nCaptureTime;
+        return;
+        }
+
+    // Which way it has to go, and how fast it's going that way
+    float fDistance = fTarget - float(wavelengthLine.getValue());
+    int nDirection = (fDistance >= 0.0f) ? 0 : 1;
+    float fToward = (nDirection == 0) ? pDrift->fWavelengthRate : -pDrift->fWavelengthRate;
+    float fSlew = slewRates[nDirection];
+
+    // Well on the way and not just settling, learn from it
+    if(pDrift->bValid && fabs(fDistance) > DRIFT_SLEW_DISTANCE && fToward > DRIFT_MIN_RATE) {
+        if(fSlew == 0.0f)
+            slewRates[nDirection] = fToward;
+        else
+            slewRates[nDirection] = float(fSlew + (fToward - fSlew) * QUANTUM_DRIFT_SLEW_WEIGHT);
+        }
+
+    // Going by what it's doing, unless it has only just started doing it
+    float fRate = 0.0f;
+    if(pDrift->bValid && fToward > DRIFT_MIN_RATE && fToward >= fSlew * 0.5f)
+        fRate = fToward;
+    else if(fSlew > DRIFT_MIN_RATE)
+        fRate = fSlew;
+
+    if(fRate == 0.0f)
+        return;
+
+    pDrift->fSecondsToOnBand = float(fabs(fDistance)) / fRate;
+    pDrift->nOnBandTime = snapshot.nCaptureTime + int64_t(double(pDrift->fSecondsToOnBand) * 1.0e9);
+}
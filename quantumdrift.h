@@ -0,0 +1,89 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* Drift rates and time to on band, worked out as the samples come in. Each series
+ * (center wavelength, heater temperature) has an exponentially weighted straight line
+ * fitted to it: five running sums, decayed and added to once per sample, so a sample
+ * costs the same however long it has been running and nothing is kept but the sums.
+ * Older samples fade out with a time constant of QUANTUM_DRIFT_TIME seconds.
+ *
+ * Right after the wingshift changes the filter has barely started to move, so the
+ * fitted rate says little about how long it will take. For that the estimator also
+ * learns how fast this filter usually heats and cools, from the times it was seen
+ * doing it, and uses that until the current rate catches up.
+ *
+ * Plain C++, no Qt, like quantumstatus.h.
+*/
+#ifndef QUANTUMDRIFT_H
+#define QUANTUMDRIFT_H
+
+#include <stdint.h>
+
+#include "quantumstatus.h"
+
+#define QUANTUM_DRIFT_TIME          15.0        // Seconds, how fast old samples fade
+#define QUANTUM_DRIFT_MIN_WEIGHT    3.0         // Don't believe a fit with less than this behind it
+#define QUANTUM_DRIFT_SLEW_WEIGHT   0.1         // How much each sample moves the learned slew rate
+
+/////////////////////////////////////////////////////////////
+/// Straight line through a series, recent samples weighing more. Times are
+/// seconds, and kept relative to the newest sample so the sums stay small.
+class QuantumDriftLine
+{
+public:
+    void clear(void);
+    void add(double time, double value);
+
+    bool isValid(void) const;
+    double getRate(void) const;                 // Units per second
+    double getValue(void) const;                // Fitted, at the newest sample
+
+protected:
+    bool    bStarted = false;
+    double  origin = 0.0;                       // Time of the newest sample
+    double  sumW = 0.0;                         // Weights,
+    double  sumT = 0.0;                         // and weighted t, y, t*t, t*y
+    double  sumY = 0.0;
+    double  sumTT = 0.0;
+    double  sumTY = 0.0;
+};
+
+/////////////////////////////////////////////////////////////
+/// Fed every status sample, on the device thread
+class QuantumDriftEstimator
+{
+public:
+    void clear(void);
+
+    // fTarget is the wavelength it's headed for, design plus wingshift
+    void update(const QuantumStatusSnapshot& snapshot, float fTarget, QuantumDrift* pDrift);
+
+protected:
+    QuantumDriftLine    wavelengthLine;
+    QuantumDriftLine    temperatureLine;
+
+    float   fLastTarget = 0.0f;
+    float   slewRates[2] = { 0.0f, 0.0f };     // Learned, heating then cooling, Angstroms per second
+};
+
+#endif // QUANTUMDRIFT_H
@@ -0,0 +1,109 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+
+#include <string.h>
+
+#include "quantumframer.h"
+
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Get ready for the next response
+void QuantumFramer::begin(int nFields, int nLastWidth, const char* szNextMarker)
+{
+    nLength = 0;
+    nSpaces = 0;
+    nFieldWidth = 0;
+    nExpectedFields = nFields;
+    nExpectedLastWidth = nLastWidth;
+    szMarker = szNextMarker;
+    nMarkerLength = (szNextMarker != nullptr) ? int(strlen(szNextMarker)) : 0;
+    bMarkerSeen = false;
+    frameState = FRAME_IDLE;
+    szBuffer[0] = 0x0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// The docs say \r\n is at the end of response strings, but not all firmware sends it.
+// Terminators that show up before any data are left overs from the last response and
+// are just skipped.
+int QuantumFramer::feed(const char* pData, int nBytes)
+{
+    int i = 0;
+    while(i < nBytes && !isDone()) {
+        char nextChar = pData[i++];
+
+        if(nextChar == 0x0d || nextChar == 0x0a) {
+            if(nLength > 0)
+                frameState = FRAME_COMPLETE;
+            continue;
+            }
+
+        // Leave room for the null
+        if(nLength >= MAX_COMM_BUFFER_SIZE - 1) {
+            frameState = FRAME_OVERFLOW;
+            break;
+            }
+
+        szBuffer[nLength++] = nextChar;
+        szBuffer[nLength] = 0x0;
+        frameState = FRAME_RECEIVING;
+
+        // The next reply has started. Everything before it was ours.
+        if(nMarkerLength > 0 && nLength >= nMarkerLength &&
+                memcmp(szBuffer + nLength - nMarkerLength, szMarker, nMarkerLength) == 0) {
+            nLength -= nMarkerLength;
+            while(nLength > 0 && szBuffer[nLength-1] == ' ')
+                nLength--;
+            szBuffer[nLength] = 0x0;
+            bMarkerSeen = true;
+            frameState = FRAME_COMPLETE;
+            break;
+            }
+
+        if(nextChar == ' ') {
+            nSpaces++;
+            nFieldWidth = 0;
+            continue;
+            }
+
+        nFieldWidth++;
+
+        // Do we know what this response looks like? If so, the last byte ends it
+        if(nExpectedFields > 0 && nExpectedLastWidth > 0)
+            if(nSpaces + 1 == nExpectedFields && nFieldWidth == nExpectedLastWidth)
+                frameState = FRAME_COMPLETE;
+        }
+
+    return i;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// The line has gone quiet. If anything arrived, that is the response.
+QuantumFramer::FrameState QuantumFramer::finish(void)
+{
+    if(frameState == FRAME_RECEIVING)
+        frameState = FRAME_COMPLETE;
+
+    return frameState;
+}
@@ -0,0 +1,87 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* Response framing for the Quantum serial protocol. Bytes are fed in as they arrive
+ * from the serial port, and the framer decides when a complete response is in hand.
+ * A response is complete when a line terminator arrives, or when the expected number
+ * of fields (and width of the last field) has been received. Replies with no
+ * terminator and no known shape are finished by the caller after a short idle gap.
+ *
+ * When two commands go out back to back, the first reply can also be ended by the
+ * start of the second one (a marker, like the firmware version at the front of a GI
+ * reply). The marker is not part of the first reply, the caller passes it on.
+ *
+ * No Qt in here, this is just bytes.
+*/
+#ifndef QUANTUMFRAMER_H
+#define QUANTUMFRAMER_H
+
+// Size of the return buffer
+#define MAX_COMM_BUFFER_SIZE    1024
+
+class QuantumFramer
+{
+public:
+    enum FrameState {
+        FRAME_IDLE,             // Nothing received yet
+        FRAME_RECEIVING,        // Partial response in the buffer
+        FRAME_COMPLETE,         // Response is complete
+        FRAME_OVERFLOW          // Ran out of buffer, response is truncated
+    };
+
+    QuantumFramer(void) { begin(); }
+
+    // Reset for a new response. If the shape of the response is known, pass the
+    // number of fields and the width of the last field so the response can be
+    // completed the moment the last byte arrives.
+    void begin(int nFields = 0, int nLastWidth = 0, const char* szNextMarker = nullptr);
+
+    // Add bytes as they arrive. Returns how many were used, anything after a completed
+    // response is left for the next one.
+    int feed(const char* pData, int nBytes);
+
+    // No terminator is coming, take what we have
+    FrameState finish(void);
+
+    FrameState  getState(void) const            { return frameState; }
+    bool        isDone(void) const              { return frameState == FRAME_COMPLETE || frameState == FRAME_OVERFLOW; }
+    const char* getData(void) const             { return szBuffer; }
+    int         getLength(void) const           { return nLength; }
+    int         getFieldCount(void) const       { return (nLength == 0) ? 0 : nSpaces + 1; }
+    int         getLastFieldWidth(void) const   { return nFieldWidth; }
+    bool        endedAtMarker(void) const       { return bMarkerSeen; }
+
+protected:
+    char        szBuffer[MAX_COMM_BUFFER_SIZE];
+    int         nLength;
+    int         nSpaces;
+    int         nFieldWidth;            // Width of the field being received
+    int         nExpectedFields;
+    int         nExpectedLastWidth;
+    const char* szMarker;               // Start of the next reply, if one is coming
+    int         nMarkerLength;
+    bool        bMarkerSeen;
+    FrameState  frameState;
+};
+
+#endif // QUANTUMFRAMER_H
@@ -23,6 +23,9 @@ SOFTWARE
 */
 #include "quantumgui.h"
 #include "ui_quantumgui.h"
+#include "quantumtrace.h"
+#include <QSettings>
+#include <limits.h>
 
 
 QuantumGui::QuantumGui(QWidget *parent, QuantumDevice *pDevice) :
@@ -40,10 +43,24 @@ QuantumGui::QuantumGui(QWidget *parent, QuantumDevice *pDevice) :
     // This is how we talk to the quantum.
     pQuantumDevice = pDevice;
 
+    // Here before the first status update, and again if the cache was wrong
+    updateDesignWavelength();
+    connect(pQuantumDevice, SIGNAL(staticInfoChanged()), this, SLOT(updateDesignWavelength()), Qt::QueuedConnection);
     connect(pQuantumDevice, SIGNAL(statusUpdated()), this, SLOT(updateStatusDisplay()), Qt::QueuedConnection);
     connect(ui->toolButtonUp, SIGNAL(pressed()), this, SLOT(pressedUp()));
     connect(ui->toolButtonDown, SIGNAL(pressed()), this, SLOT(pressedDown()));
     connect(ui->toolButtonCenter, SIGNAL(pressed()), this, SLOT(pressedCenter()));
+    connect(ui->pushButtonDiagnostics, SIGNAL(clicked()), this, SLOT(pressedDiagnostics()));
+    connect(ui->pushButtonHistory, SIGNAL(clicked()), this, SLOT(pressedHistory()));
+
+    // Smooth graph motion, remembered
+    QSettings settings;
+    ui->checkBoxSmooth->setChecked(settings.value("smoothGraph", true).toBool());
+    pWavelengthGraph->setAnimated(ui->checkBoxSmooth->isChecked());
+    connect(ui->checkBoxSmooth, SIGNAL(toggled(bool)), this, SLOT(toggledSmooth(bool)));
+
+    // Only the top level window hears about being minimized and restored
+    window()->installEventFilter(this);
 }
 
 QuantumGui::~QuantumGui()
@@ -51,6 +68,17 @@ QuantumGui::~QuantumGui()
     delete ui;
 }
 
+///////////////////////////////////////////////////////////////////////
+// Nothing is updated while minimized, so catch up as soon as the window
+// is back rather than at the next poll, which can be seconds away.
+bool QuantumGui::eventFilter(QObject *pWatched, QEvent *event)
+{
+    if(pWatched == window() && event->type() == QEvent::WindowStateChange && !window()->isMinimized())
+        updateStatusDisplay();
+
+    return QDialog::eventFilter(pWatched, event);
+}
+
 void QuantumGui::resizeEvent(QResizeEvent *event)
     {
     //QSize size = ui->graphFrame->frameSize();
@@ -63,140 +91,265 @@ void QuantumGui::resizeEvent(QResizeEvent *event)
 /// Increase wingshift by .1 angstroms
 void QuantumGui::pressedUp(void)
 {
-    QuantumStatus deviceStatus;
-    pQuantumDevice->getDeviceStatus(&deviceStatus);
+    // Start from where we are headed, not where we are. Quick clicks add up.
+    int wingshift = int(lroundf(pQuantumDevice->getTargetWingshift() * 10.0f));
 
     // If wingshift is already maxed out, ignore
-    if(deviceStatus.wingShift >= 1.0)
+    if(wingshift >= 10)
         return;
 
     // Okay, increment it
-    int wingshift = int(deviceStatus.wingShift * 10.0f);
     wingshift += 1;
 
-    char cCmdString[16];
-    sprintf(cCmdString, "SE%d\n", wingshift);
-
-    pQuantumDevice->addCommand(cCmdString);
+    pQuantumDevice->addCommand(QuantumCommand::setWingshift(wingshift));
 }
 
 ////////////////////////////////////////////////////////////////////
 /// Decrease wingshift by .1 angstroms
 void QuantumGui::pressedDown(void)
 {
-    QuantumStatus deviceStatus;
-    pQuantumDevice->getDeviceStatus(&deviceStatus);
+    // Start from where we are headed, not where we are. Quick clicks add up.
+    int wingshift = int(lroundf(pQuantumDevice->getTargetWingshift() * 10.0f));
 
     // If wingshift is already maxed out, ignore
-    if(deviceStatus.wingShift <= -1.0)
+    if(wingshift <= -10)
         return;
 
     // Okay, increment it
-    int wingshift = int(deviceStatus.wingShift * 10.0f);
     wingshift -= 1;
 
-    char cCmdString[16];
-    sprintf(cCmdString, "SE%d\n", wingshift);
-
-    pQuantumDevice->addCommand(cCmdString);
+    pQuantumDevice->addCommand(QuantumCommand::setWingshift(wingshift));
 }
 
 ////////////////////////////////////////////////////////////////////
 /// Set Wingshift to zero
 void QuantumGui::pressedCenter(void)
 {
-    pQuantumDevice->addCommand(QString("SE0\n"));
+    pQuantumDevice->addCommand(QuantumCommand::setWingshift(0));
 }
 
 
 ////////////////////////////////////////////////////////////////////
+/// Link diagnostics, in their own window. Made the first time only.
+void QuantumGui::pressedDiagnostics(void)
+{
+    if(pDiagnostics == nullptr)
+        pDiagnostics = new DlgDiagnostics(this, pQuantumDevice);
+
+    pDiagnostics->show();
+    pDiagnostics->raise();
+    pDiagnostics->activateWindow();
+}
+
+////////////////////////////////////////////////////////////////////
+/// Recorded history, charted. Also made the first time only.
+void QuantumGui::pressedHistory(void)
+{
+    if(pHistory == nullptr)
+        pHistory = new DlgHistory(this, pQuantumDevice);
+
+    pHistory->show();
+    pHistory->raise();
+    pHistory->activateWindow();
+}
+
+
+////////////////////////////////////////////////////////////////////
+void QuantumGui::toggledSmooth(bool bChecked)
+{
+    pWavelengthGraph->setAnimated(bChecked);
+
+    QSettings settings;
+    settings.setValue("smoothGraph", bChecked);
+}
+
+////////////////////////////////////////////////////////////////////
+/// The design wavelength only changes if the cache was out of date, so
+/// parse it once here instead of on every status update.
+void QuantumGui::updateDesignWavelength(void)
+{
+    QString qsDesign = pQuantumDevice->getWavelengthString();
+    if(qsDesign == qsDesignWavelength)
+        return;
+
+    qsDesignWavelength = qsDesign;
+    fDesignWavelength = qsDesign.toFloat();
+    shown.bValid = false;           // The target moves with it
+    updateStatusDisplay();
+}
+
+////////////////////////////////////////////////////////////////////
+/// Labels only get new text when what they would say changes. Values are
+/// compared at the precision they are shown with, so a reading that wobbles
+/// in a digit nobody sees costs a few compares.
 void QuantumGui::updateStatusDisplay(void)
 {
-    QuantumStatus deviceStatus;
-    pQuantumDevice->getDeviceStatus(&deviceStatus);
+    QUANTUM_TRACE_SCOPE("updateStatusDisplay");
+
+    // Nobody is looking. eventFilter() catches up when the window comes back.
+    if(window()->isMinimized())
+        return;
+
+    QuantumStatusSnapshot snapshot;
+    pQuantumDevice->getStatusSnapshot(&snapshot);
+    const QuantumStatus& deviceStatus = snapshot.status;
     QString output;
 
+    bool bAll = !shown.bValid;
+    shown.bValid = true;
+
     // Update error string
-    output = "Error Status: ";
-    switch (deviceStatus.nErrorCode) {
-        case 0:
-            output += "No Errors";
-            break;
-        case 1:
-            output += "Supply voltage too low (less than 8V";
-            break;
-        case 2:
-            output += "Ambient temperature too low. Cannot reach setpoint.";
-            break;
-        case 3:
-            output += "Low power (supply voltage below 10v).";
-            break;
-        case 4:
-            output += "High voltage (supply voltage above 30v)";
-            break;
-        case 5:
-            output += "Ambient temperature too hot. Cannot reach setpoint.";
-            break;
-        case 0x0a:
-            output += "Thermistor connection open (broken wire). Return to Daystar for service.";
-            break;
-        case 0x0b:
-            output += "Thermistor connection shorted. Return to Daystar for service.";
-            break;
-        default:
-            output += QString::asprintf("Unknown error, code %x", deviceStatus.nErrorCode);
+    if(bAll || deviceStatus.nErrorCode != shown.nErrorCode) {
+        shown.nErrorCode = deviceStatus.nErrorCode;
+        output = "Error Status: ";
+        switch (deviceStatus.nErrorCode) {
+            case 0:
+                output += "No Errors";
+                break;
+            case 1:
+                output += "Supply voltage too low (less than 8V";
+                break;
+            case 2:
+                output += "Ambient temperature too low. Cannot reach setpoint.";
+                break;
+            case 3:
+                output += "Low power (supply voltage below 10v).";
+                break;
+            case 4:
+                output += "High voltage (supply voltage above 30v)";
+                break;
+            case 5:
+                output += "Ambient temperature too hot. Cannot reach setpoint.";
+                break;
+            case 0x0a:
+                output += "Thermistor connection open (broken wire). Return to Daystar for service.";
+                break;
+            case 0x0b:
+                output += "Thermistor connection shorted. Return to Daystar for service.";
+                break;
+            default:
+                output += QString::asprintf("Unknown error, code %x", deviceStatus.nErrorCode);
+            }
+
+        ui->labelErrorCode->setText(output);
         }
 
-    ui->labelErrorCode->setText(output);
-    float fTarget = pQuantumDevice->getWavelengthString().toFloat() + deviceStatus.wingShift;
-    fTarget *= 10.0f;
-    fTarget = floor(fTarget);
-    fTarget = fTarget * 0.1f;
+    // Target is the design wavelength plus wingshift, to the tenth below
+    int nTarget = int(floor((fDesignWavelength + deviceStatus.wingShift) * 10.0f));
+    float fTarget = float(nTarget) * 0.1f;
 
     // On or off band
+    int nBand;
     if(deviceStatus.bOnBand)
-        output = "** On Band **";
-    else {
-        if(deviceStatus.centerWavelength < fTarget)
+        nBand = BAND_ON;
+    else if(deviceStatus.centerWavelength < fTarget)
+        nBand = BAND_WARMING;
+    else
+        nBand = BAND_COOLING;
+
+    if(bAll || nBand != shown.nBand) {
+        shown.nBand = nBand;
+        if(nBand == BAND_ON)
+            output = "** On Band **";
+        else if(nBand == BAND_WARMING)
             output = "Warming";
         else
             output = "Cooling";
 
+        ui->labelBandStatus->setText(output);
         }
 
-    ui->labelBandStatus->setText(output);
-
     // Current wavelength
-    output = QString::asprintf("Current Center Wavelength: %.1f", deviceStatus.centerWavelength);
-    output += angstromSymbol;
-    ui->labelWavelength->setText(output);
+    int nWavelength = int(lroundf(deviceStatus.centerWavelength * 10.0f));
+    if(bAll || nWavelength != shown.nWavelength) {
+        shown.nWavelength = nWavelength;
+        output = QString::asprintf("Current Center Wavelength: %.1f", double(nWavelength) * 0.1);
+        output += angstromSymbol;
+        ui->labelWavelength->setText(output);
+        }
 
     // Target wavelength
-    output = QString::asprintf("Target Wavelength: %.1f", fTarget);
-    output += angstromSymbol;
-    ui->labelTarget->setText(output);
+    if(bAll || nTarget != shown.nTarget) {
+        shown.nTarget = nTarget;
+        output = QString::asprintf("Target Wavelength: %.1f", double(nTarget) * 0.1);
+        output += angstromSymbol;
+        ui->labelTarget->setText(output);
+        }
 
     // Current wingshift
-    output = QString::asprintf("Current Wingshift: %0.1f", deviceStatus.wingShift);
-    output += angstromSymbol;
-    ui->labelWingshift->setText(output);
+    int nWingshift = int(lroundf(deviceStatus.wingShift * 10.0f));
+    if(bAll || nWingshift != shown.nWingshift) {
+        shown.nWingshift = nWingshift;
+        output = QString::asprintf("Current Wingshift: %0.1f", double(nWingshift) * 0.1);
+        output += angstromSymbol;
+        ui->labelWingshift->setText(output);
+        }
 
     // Voltage
-    output = QString::asprintf("Current Voltage: %.02fV", deviceStatus.inputVoltage);
-    ui->labelVoltage->setText(output);
+    int nVoltage = int(lroundf(deviceStatus.inputVoltage * 100.0f));
+    if(bAll || nVoltage != shown.nVoltage) {
+        shown.nVoltage = nVoltage;
+        output = QString::asprintf("Current Voltage: %.02fV", double(nVoltage) * 0.01);
+        ui->labelVoltage->setText(output);
+        }
 
     // Temp
-    output = QString::asprintf("Heater temperature: %.1f", deviceStatus.heater1Temprature);
-    output += degreeSymbol;
-    output += " F ";
-    ui->labelTemp->setText(output);
+    int nTemperature = int(lroundf(deviceStatus.heater1Temprature * 10.0f));
+    if(bAll || nTemperature != shown.nTemperature) {
+        shown.nTemperature = nTemperature;
+        output = QString::asprintf("Heater temperature: %.1f", double(nTemperature) * 0.1);
+        output += degreeSymbol;
+        output += " F ";
+        ui->labelTemp->setText(output);
+        }
+
+    // Drift, per minute since that's the scale it moves on. Blank until there's
+    // enough to go on.
+    const QuantumDrift& drift = snapshot.drift;
+    int nWavelengthDrift = drift.bValid ? int(lroundf(drift.fWavelengthRate * 60.0f * 100.0f)) : INT_MIN;
+    int nTemperatureDrift = drift.bValid ? int(lroundf(drift.fTemperatureRate * 60.0f * 10.0f)) : INT_MIN;
+    if(bAll || nWavelengthDrift != shown.nWavelengthDrift || nTemperatureDrift != shown.nTemperatureDrift) {
+        shown.nWavelengthDrift = nWavelengthDrift;
+        shown.nTemperatureDrift = nTemperatureDrift;
+        output = "Drift: ";
+        if(drift.bValid) {
+            output += QString::asprintf("%+.2f", double(nWavelengthDrift) * 0.01);
+            output += angstromSymbol;
+            output += QString::asprintf("/min, %+.1f", double(nTemperatureDrift) * 0.1);
+            output += degreeSymbol;
+            output += " F/min";
+            }
+        ui->labelDrift->setText(output);
+        }
+
+    // Time to on band, to the nearest five seconds. Any finer just flickers.
+    int nOnBandTime = -1;
+    if(drift.fSecondsToOnBand == 0.0f)
+        nOnBandTime = 0;
+    else if(drift.fSecondsToOnBand > 0.0f)
+        nOnBandTime = qMax(5, int(lroundf(drift.fSecondsToOnBand / 5.0f)) * 5);
+    if(bAll || nOnBandTime != shown.nOnBandTime) {
+        shown.nOnBandTime = nOnBandTime;
+        if(nOnBandTime == 0)
+            output = "On band: now";
+        else if(nOnBandTime < 0)
+            output = "On band: working it out";
+        else if(nOnBandTime < 60)
+            output = QString::asprintf("On band: in about %d s", nOnBandTime);
+        else
+            output = QString::asprintf("On band: in about %d min %02d s", nOnBandTime / 60, nOnBandTime % 60);
+        ui->labelOnBandTime->setText(output);
+        }
 
+    // These are plain stores, the graph works out for itself whether to repaint
     pWavelengthGraph->SetOnBand(deviceStatus.bOnBand);
     pWavelengthGraph->SetTargetWavelength(fTarget);
     pWavelengthGraph->SetCurrentWavelength(deviceStatus.centerWavelength);
-    pWavelengthGraph->SetDesignWavelength(pQuantumDevice->getWavelengthString().toFloat());
+    pWavelengthGraph->SetDesignWavelength(fDesignWavelength);
     pWavelengthGraph->SetCurrentWingshift(deviceStatus.wingShift);
-    pWavelengthGraph->update();
+    if(snapshot.nSequence != 0)
+        pWavelengthGraph->AddSample(snapshot.nCaptureTime, deviceStatus.centerWavelength, drift.fWavelengthRate);
+    pWavelengthGraph->refresh();
     }
 
 
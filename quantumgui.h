@@ -31,6 +31,8 @@ SOFTWARE
 
 #include "quantumdevice.h"
 #include "wavelengthgraph.h"
+#include "dlgdiagnostics.h"
+#include "dlghistory.h"
 
 #include <QDialog>
 #include <QResizeEvent>
@@ -59,17 +61,49 @@ public:
 
 protected:
     virtual void resizeEvent(QResizeEvent *event);
+    virtual bool eventFilter(QObject *pWatched, QEvent *event) override;
 
 private:
     Ui::QuantumGui *ui;
     QuantumDevice  *pQuantumDevice = nullptr;
     WavelengthGraph *pWavelengthGraph = nullptr;
+    DlgDiagnostics  *pDiagnostics = nullptr;
+    DlgHistory      *pHistory = nullptr;
+
+    // Parsed from the device's design wavelength string
+    QString         qsDesignWavelength;
+    float           fDesignWavelength = 0.0f;
+
+    enum BandStatus {
+        BAND_ON,
+        BAND_WARMING,
+        BAND_COOLING
+    };
+
+    // What the labels say now, at the precision they say it
+    struct ShownStatus {
+        bool    bValid = false;     // Nothing shown yet, set everything
+        int     nErrorCode = 0;
+        int     nBand = BAND_ON;
+        int     nWavelength = 0;    // Tenths of an Angstrom
+        int     nTarget = 0;
+        int     nWingshift = 0;
+        int     nVoltage = 0;       // Hundredths of a volt
+        int     nTemperature = 0;   // Tenths of a degree
+        int     nWavelengthDrift = 0;   // Hundredths of an Angstrom a minute
+        int     nTemperatureDrift = 0;  // Tenths of a degree a minute
+        int     nOnBandTime = 0;        // Seconds, rounded to five. -1 not known
+    } shown;
 
 public Q_SLOTS:
     void updateStatusDisplay(void);
+    void updateDesignWavelength(void);
     void pressedUp(void);
     void pressedDown(void);
     void pressedCenter(void);
+    void pressedDiagnostics(void);
+    void pressedHistory(void);
+    void toggledSmooth(bool bChecked);
 };
 
 #endif // QUANTUMGUI_H
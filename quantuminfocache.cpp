@@ -0,0 +1,76 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+
+#include <QSettings>
+
+#include "quantuminfocache.h"
+
+// Bump this if what is stored changes, old entries are then ignored
+#define QUANTUM_CACHE_VERSION   1
+
+
+///////////////////////////////////////////////////////////////////////
+// Port names can have slashes in them, which QSettings takes as groups
+static QString cacheGroup(const QString& qsPortName)
+{
+    QString qsKey = qsPortName;
+    qsKey.replace('/', '_');
+    qsKey.replace('\\', '_');
+    return QString("DeviceCache/") + qsKey;
+}
+
+///////////////////////////////////////////////////////////////////////
+bool QuantumInfoCache::load(const QString& qsPortName, QuantumStaticInfo* pInfo)
+{
+    QSettings settings;
+    settings.beginGroup(cacheGroup(qsPortName));
+
+    if(settings.value("version", 0).toInt() != QUANTUM_CACHE_VERSION)
+        return false;
+
+    pInfo->qsSerialNumber = settings.value("serial").toString();
+    pInfo->qsFirmwareVersion = settings.value("firmware").toString();
+    pInfo->qsBandwidthString = settings.value("bandwidth").toString();
+    pInfo->qsModelString = settings.value("model").toString();
+    pInfo->qsDesignWavelength = settings.value("wavelength").toString();
+    pInfo->nBodyStyle = settings.value("body", 0).toInt();
+
+    // Can't check a filter against nothing
+    return !pInfo->qsSerialNumber.isEmpty() && !pInfo->qsFirmwareVersion.isEmpty();
+}
+
+///////////////////////////////////////////////////////////////////////
+void QuantumInfoCache::save(const QString& qsPortName, const QuantumStaticInfo& info)
+{
+    QSettings settings;
+    settings.beginGroup(cacheGroup(qsPortName));
+
+    settings.setValue("version", QUANTUM_CACHE_VERSION);
+    settings.setValue("serial", info.qsSerialNumber);
+    settings.setValue("firmware", info.qsFirmwareVersion);
+    settings.setValue("bandwidth", info.qsBandwidthString);
+    settings.setValue("model", info.qsModelString);
+    settings.setValue("wavelength", info.qsDesignWavelength);
+    settings.setValue("body", info.nBodyStyle);
+}
@@ -0,0 +1,71 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* The things about a Quantum that don't change (serial number, model, design wavelength,
+ * and so on) take six round trips to get at startup. They are kept on disk here, one
+ * entry per serial port, so the next time we connect on the same port only the GI and
+ * GS are needed to make sure it's the same filter. Everything else is checked again
+ * in the background once we are up and running.
+ *
+ * Entries live in the application settings under "DeviceCache". Each I/O thread uses
+ * its own QSettings, so this is safe to call from any of them.
+*/
+#ifndef QUANTUMINFOCACHE_H
+#define QUANTUMINFOCACHE_H
+
+#include <QString>
+
+////////////////////////////////////////////////////////////
+/// Identity of one Quantum
+struct QuantumStaticInfo {
+    QString qsSerialNumber;
+    QString qsFirmwareVersion;
+    QString qsBandwidthString;
+    QString qsModelString;
+    QString qsDesignWavelength;
+    int     nBodyStyle = 0;
+
+    bool operator==(const QuantumStaticInfo& other) const {
+        return qsSerialNumber == other.qsSerialNumber &&
+               qsFirmwareVersion == other.qsFirmwareVersion &&
+               qsBandwidthString == other.qsBandwidthString &&
+               qsModelString == other.qsModelString &&
+               qsDesignWavelength == other.qsDesignWavelength &&
+               nBodyStyle == other.nBodyStyle;
+    }
+
+    bool operator!=(const QuantumStaticInfo& other) const { return !(*this == other); }
+};
+
+
+class QuantumInfoCache
+{
+public:
+    // Last Quantum seen on this port. False if there isn't one.
+    static bool load(const QString& qsPortName, QuantumStaticInfo* pInfo);
+
+    // Remember this one for next time
+    static void save(const QString& qsPortName, const QuantumStaticInfo& info);
+};
+
+#endif // QUANTUMINFOCACHE_H
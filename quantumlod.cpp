@@ -0,0 +1,168 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+#include "quantumlod.h"
+
+///////////////////////////////////////////////////////////////////////
+QuantumLodPyramid::QuantumLodPyramid(int nSeriesCount)
+{
+    Q_ASSERT(nSeriesCount > 0 && nSeriesCount <= QUANTUM_LOD_SERIES);
+    nSeries = nSeriesCount;
+}
+
+void QuantumLodPyramid::clear(void)
+{
+    times.clear();
+    for(int s = 0; s < nSeries; s++) {
+        values[s].clear();
+        for(int l = 1; l < QUANTUM_LOD_LEVELS; l++)
+            levels[s][l].clear();
+        }
+}
+
+///////////////////////////////////////////////////////////////////////
+// Sample n is in entry n >> (2 * level) on each level. Either it starts a new entry
+// or it widens the last one.
+void QuantumLodPyramid::append(int64_t nTime, const float* pValues)
+{
+    int nIndex = times.size();
+    times.append(nTime);
+
+    for(int s = 0; s < nSeries; s++) {
+        float value = pValues[s];
+        values[s].append(value);
+
+        for(int l = 1; l < QUANTUM_LOD_LEVELS; l++) {
+            QVector<MinMax>& level = levels[s][l];
+            if((nIndex >> (2 * l)) == level.size()) {
+                MinMax entry = { value, value };
+                level.append(entry);
+                continue;
+                }
+
+            MinMax& entry = level.last();
+            if(value < entry.min) entry.min = value;
+            if(value > entry.max) entry.max = value;
+            }
+        }
+}
+
+///////////////////////////////////////////////////////////////////////
+// Rare (when the history outgrows what we keep), so just start over
+void QuantumLodPyramid::dropOldest(int nCount)
+{
+    if(nCount <= 0)
+        return;
+
+    if(nCount >= times.size()) {
+        clear();
+        return;
+        }
+
+    QVector<int64_t> oldTimes = times;
+    QVector<float> oldValues[QUANTUM_LOD_SERIES];
+    for(int s = 0; s < nSeries; s++)
+        oldValues[s] = values[s];
+
+    clear();
+
+    float sample[QUANTUM_LOD_SERIES];
+    for(int i = nCount; i < oldTimes.size(); i++) {
+        for(int s = 0; s < nSeries; s++)
+            sample[s] = oldValues[s][i];
+        append(oldTimes[i], sample);
+        }
+}
+
+///////////////////////////////////////////////////////////////////////
+int QuantumLodPyramid::findTime(int64_t nTime) const
+{
+    int nLow = 0, nHigh = times.size();
+    while(nLow < nHigh) {
+        int nMiddle = nLow + (nHigh - nLow) / 2;
+        if(times[nMiddle] < nTime)
+            nLow = nMiddle + 1;
+        else
+            nHigh = nMiddle;
+        }
+
+    return nLow;
+}
+
+///////////////////////////////////////////////////////////////////////
+void QuantumLodPyramid::columnsFor(int64_t nFrom, int64_t nTo, int nColumns, QuantumLodColumn* pColumns) const
+{
+    int64_t nSpan = nTo - nFrom;
+    int nFirst = findTime(nFrom);
+
+    for(int c = 0; c < nColumns; c++) {
+        int64_t nColumnEnd = nFrom + (nSpan * int64_t(c + 1)) / int64_t(nColumns);
+        int nEnd = findTime(nColumnEnd);
+        pColumns[c].nFirst = nFirst;
+        pColumns[c].nEnd = nEnd;
+        nFirst = nEnd;
+        }
+}
+
+///////////////////////////////////////////////////////////////////////
+// Walk from nFirst to nEnd in the biggest steps that fit: up the levels while the next
+// entry is aligned and inside the range, back down as the end gets close.
+QuantumLodRange QuantumLodPyramid::rangeOf(int nSeries, int nFirst, int nEnd) const
+{
+    QuantumLodRange range = { 0.0f, 0.0f, 0 };
+    if(nFirst < 0)
+        nFirst = 0;
+    if(nEnd > times.size())
+        nEnd = times.size();
+    if(nFirst >= nEnd)
+        return range;
+
+    const QVector<float>& samples = values[nSeries];
+    range.min = range.max = samples[nFirst];
+    range.nCount = nEnd - nFirst;
+
+    int nLevel = 0;
+    int nAt = nFirst;
+    while(nAt < nEnd) {
+        while(nLevel + 1 < QUANTUM_LOD_LEVELS && (nAt & ((1 << (2 * (nLevel + 1))) - 1)) == 0
+              && nAt + (1 << (2 * (nLevel + 1))) <= nEnd)
+            nLevel++;
+        while(nLevel > 0 && nAt + (1 << (2 * nLevel)) > nEnd)
+            nLevel--;
+
+        float min, max;
+        if(nLevel == 0)
+            min = max = samples[nAt];
+        else {
+            const MinMax& entry = levels[nSeries][nLevel][nAt >> (2 * nLevel)];
+            min = entry.min;
+            max = entry.max;
+            }
+
+        if(min < range.min) range.min = min;
+        if(max > range.max) range.max = max;
+        nAt += 1 << (2 * nLevel);
+        }
+
+    return range;
+}
@@ -0,0 +1,96 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* Min/max pyramid for plotting long series. Level 0 is the samples themselves, each
+ * level above has the min and max of four entries of the one below. The min and max
+ * over any range of samples comes from a handful of entries, a few from each level,
+ * so drawing a day of history costs the same as drawing a minute: a couple of binary
+ * searches and a few dozen lookups per pixel column, however many samples there are.
+ *
+ * Samples are added one at a time, each touching one entry per level. Several series
+ * share one time line. No Qt widgets in here, it's just the numbers.
+*/
+#ifndef QUANTUMLOD_H
+#define QUANTUMLOD_H
+
+#include <stdint.h>
+
+#include <QVector>
+
+#define QUANTUM_LOD_LEVELS      10      // Level 9 entries cover 4^9 = 262144 samples
+#define QUANTUM_LOD_SERIES      8       // Most series one pyramid can hold
+
+/////////////////////////////////////////////////////////////
+/// Min and max over a span of samples. Empty if nCount is 0.
+struct QuantumLodRange {
+    float       min;
+    float       max;
+    int         nCount;
+};
+
+/////////////////////////////////////////////////////////////
+/// One pixel column of a plot: which samples land in it
+struct QuantumLodColumn {
+    int         nFirst;                 // Sample index
+    int         nEnd;                   // One past the last one
+};
+
+class QuantumLodPyramid
+{
+public:
+    explicit QuantumLodPyramid(int nSeriesCount);
+
+    // Times should not go backwards, queries assume they are in order
+    void append(int64_t nTime, const float* pValues);
+    void clear(void);
+
+    // Throw away the oldest samples, and rebuild what is left
+    void dropOldest(int nCount);
+
+    int size(void) const { return times.size(); }
+    int getSeriesCount(void) const { return nSeries; }
+    int64_t getTime(int nIndex) const { return times[nIndex]; }
+    float getValue(int nSeries, int nIndex) const { return values[nSeries][nIndex]; }
+
+    // First sample at or after nTime
+    int findTime(int64_t nTime) const;
+
+    // Split nFrom..nTo into nColumns equal slices of time, and find the samples in each
+    void columnsFor(int64_t nFrom, int64_t nTo, int nColumns, QuantumLodColumn* pColumns) const;
+
+    // Min and max of samples nFirst up to (not including) nEnd
+    QuantumLodRange rangeOf(int nSeries, int nFirst, int nEnd) const;
+
+protected:
+    struct MinMax {
+        float   min;
+        float   max;
+    };
+
+    int                 nSeries;
+    QVector<int64_t>    times;
+    QVector<float>      values[QUANTUM_LOD_SERIES];
+    QVector<MinMax>     levels[QUANTUM_LOD_SERIES][QUANTUM_LOD_LEVELS];   // [0] isn't used, values are level 0
+};
+
+#endif // QUANTUMLOD_H
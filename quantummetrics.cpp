@@ -0,0 +1,97 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+
+#include <string.h>
+
+#include "quantummetrics.h"
+
+
+////////////////////////////////////////////////////////////////////////////////////////////
+void quantumResetMetrics(QuantumIOMetrics* pMetrics)
+{
+    memset(pMetrics, 0, sizeof(QuantumIOMetrics));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Which power of two bucket this falls in. A shift per bucket, at most, no floating point.
+static int rttBucket(int64_t nMicroseconds)
+{
+    int nBucket = 0;
+    int64_t nEdge = QUANTUM_RTT_FIRST_BUCKET;
+    while(nMicroseconds >= nEdge && nBucket < QUANTUM_RTT_BUCKETS - 1) {
+        nEdge <<= 1;
+        nBucket++;
+        }
+
+    return nBucket;
+}
+
+void quantumRecordRtt(QuantumCommandMetrics* pMetrics, int64_t nMicroseconds)
+{
+    if(nMicroseconds < 0)
+        nMicroseconds = 0;
+
+    pMetrics->nRttTotal += uint64_t(nMicroseconds);
+    if(uint64_t(nMicroseconds) > pMetrics->nRttMax)
+        pMetrics->nRttMax = uint64_t(nMicroseconds);
+
+    pMetrics->rttHistogram[rttBucket(nMicroseconds)]++;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+int64_t quantumRttPercentile(const QuantumCommandMetrics& metrics, double fPercent)
+{
+    uint64_t nTotal = 0;
+    for(int i = 0; i < QUANTUM_RTT_BUCKETS; i++)
+        nTotal += metrics.rttHistogram[i];
+
+    if(nTotal == 0)
+        return 0;
+
+    // Nearest rank
+    uint64_t nRank = uint64_t(fPercent / 100.0 * double(nTotal) + 0.999999);
+    if(nRank < 1)
+        nRank = 1;
+
+    uint64_t nSeen = 0;
+    int64_t nEdge = QUANTUM_RTT_FIRST_BUCKET;
+    for(int i = 0; i < QUANTUM_RTT_BUCKETS - 1; i++) {
+        nSeen += metrics.rttHistogram[i];
+        if(nSeen >= nRank)
+            return nEdge;
+        nEdge <<= 1;
+        }
+
+    // Off the end, the worst we have seen is the best answer
+    return int64_t(metrics.nRttMax);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+int64_t quantumRttAverage(const QuantumCommandMetrics& metrics)
+{
+    if(metrics.nSucceeded == 0)
+        return 0;
+
+    return int64_t(metrics.nRttTotal / metrics.nSucceeded);
+}
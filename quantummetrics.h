@@ -0,0 +1,82 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* Counters and round trip histograms for the serial link, one set per command type.
+ * The I/O thread keeps these as it goes, with no locking, and hands a copy over to
+ * the device's shared data after each exchange. Everyone else reads that copy.
+ *
+ * Round trips go in power of two buckets. Bucket 0 is anything under 128 us, bucket 1
+ * is under 256 us, and so on, and the last one takes everything longer. Percentiles
+ * come from the buckets, so they are the upper edge of the bucket they fall in.
+ *
+ * No Qt in here.
+*/
+#ifndef QUANTUMMETRICS_H
+#define QUANTUMMETRICS_H
+
+#include <stdint.h>
+
+#include "quantumcommand.h"
+
+#define QUANTUM_RTT_BUCKETS         16      // Up to about 4 seconds
+#define QUANTUM_RTT_FIRST_BUCKET    128     // Microseconds
+
+/////////////////////////////////////////////////////////////
+/// Everything we know about how one kind of command is doing
+struct QuantumCommandMetrics {
+    uint64_t    nSent;              // Exchanges started, not counting retries
+    uint64_t    nSucceeded;         // A reply came back
+    uint64_t    nFailed;            // Gave up on it
+    uint64_t    nRetries;           // Sent again after no reply
+    uint64_t    nTimeouts;          // No reply at all within QUANTUM_TIMEOUT
+    uint64_t    nPartialReads;      // Reply stopped short, or overflowed
+    uint64_t    nParseFailures;     // Reply came back but made no sense
+    uint64_t    nBytesOut;
+    uint64_t    nBytesIn;
+    uint64_t    nRttTotal;          // Microseconds, successful exchanges only
+    uint64_t    nRttMax;
+    uint64_t    rttHistogram[QUANTUM_RTT_BUCKETS];
+};
+
+/////////////////////////////////////////////////////////////
+/// The whole link
+struct QuantumIOMetrics {
+    QuantumCommandMetrics   commands[QCMD_COUNT];
+    uint64_t                nSamples;           // Good status samples
+    uint64_t                nMissedSamples;     // Poll cycles that didn't get one
+};
+
+// Clear everything
+void quantumResetMetrics(QuantumIOMetrics* pMetrics);
+
+// A successful round trip
+void quantumRecordRtt(QuantumCommandMetrics* pMetrics, int64_t nMicroseconds);
+
+// Upper edge of the bucket the given percentile (0 to 100) of round trips falls in,
+// in microseconds. 0 if there are none.
+int64_t quantumRttPercentile(const QuantumCommandMetrics& metrics, double fPercent);
+
+// Average successful round trip, microseconds
+int64_t quantumRttAverage(const QuantumCommandMetrics& metrics);
+
+#endif // QUANTUMMETRICS_H
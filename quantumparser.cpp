@@ -0,0 +1,131 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+
+#include "quantumparser.h"
+
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Runs of spaces count as one separator, same as strtok did.
+int quantumSplitFields(const char* pReply, int nLength, QuantumSpan* pFields, int nMaxFields)
+{
+    int nFields = 0;
+    int i = 0;
+
+    while(i < nLength && nFields < nMaxFields) {
+        while(i < nLength && pReply[i] == ' ')
+            i++;
+
+        if(i == nLength)
+            break;
+
+        int iStart = i;
+        while(i < nLength && pReply[i] != ' ')
+            i++;
+
+        pFields[nFields].pData = pReply + iStart;
+        pFields[nFields].nLength = i - iStart;
+        nFields++;
+        }
+
+    return nFields;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Parse the status string. Every variant is its own function, the layout and number
+// format are known at compile time.
+template<bool bHex, bool bDual>
+static bool parseStatus(const char* pReply, int nLength, QuantumStatus* pStatus)
+{
+    typedef QuantumField<bHex> Field;
+    typedef QuantumStatusLayout<bDual> Layout;
+
+    QuantumSpan fields[QUANTUM_MAX_STATUS_FIELDS];
+    int nFields = quantumSplitFields(pReply, nLength, fields, QUANTUM_MAX_STATUS_FIELDS);
+    if(nFields < Layout::nMinFields)
+        return false;
+
+    int32_t nErrorCode, nOnBand, nWavelength, nWingShift;
+    int32_t nPMW, nPMWLimit, nTemp, nVoltage, nCalibration;
+
+    // First field is firmware, we already have that
+    bool bValid = Field::toInteger(fields[Layout::iErrorCode], &nErrorCode)
+               && Field::toInteger(fields[Layout::iOnBand], &nOnBand)
+               && Field::toInteger(fields[Layout::iWavelength], &nWavelength)
+               && Field::toSignedInteger(fields[Layout::iWingshift], &nWingShift)
+               && Field::toInteger(fields[Layout::iHeater1PMW], &nPMW)
+               && Field::toInteger(fields[Layout::iHeater1Limit], &nPMWLimit)
+               && Field::toInteger(fields[Layout::iHeater1Temp], &nTemp)
+               && Field::toInteger(fields[Layout::iVoltage], &nVoltage)
+               && Field::toInteger(fields[Layout::iCalibration], &nCalibration);
+
+    int32_t nTemp2 = 0, nPMW2 = 0, nPMWLimit2 = 0;
+    if(bDual)
+        bValid = bValid
+               && Field::toInteger(fields[Layout::iHeater2Temp], &nTemp2)
+               && Field::toInteger(fields[Layout::iHeater2PMW], &nPMW2)
+               && Field::toInteger(fields[Layout::iHeater2Limit], &nPMWLimit2);
+
+    if(!bValid)
+        return false;
+
+    pStatus->bDualHeaters = bDual;
+    pStatus->nErrorCode = nErrorCode;
+    pStatus->bOnBand = (nOnBand == 1);
+    pStatus->centerWavelength = float(nWavelength) * 0.1f;
+    pStatus->wingShift = float(nWingShift) * 0.1f;
+    pStatus->heater1PMWLimit = nPMWLimit;
+    pStatus->heater1PMW = (nPMWLimit > 0) ? (float(nPMW) * 100.0f) / float(nPMWLimit) : 0.0f;
+    pStatus->heater1Temprature = float(nTemp) * 0.01f;
+    pStatus->heater2Temperature = float(nTemp2) * 0.01f;
+    pStatus->inputVoltage = float(nVoltage) * 0.01f;
+    pStatus->calibrationPotPos = nCalibration;
+    pStatus->heater2PMWLimit = nPMWLimit2;
+    pStatus->heater2PMW = (nPMWLimit2 > 0) ? (float(nPMW2) * 100.0f) / float(nPMWLimit2) : 0.0f;
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Called once at connect time
+QuantumStatusParser quantumSelectStatusParser(bool bOldFirmware, bool bDualHeaters)
+{
+    if(bOldFirmware)
+        return bDualHeaters ? parseStatus<false, true> : parseStatus<false, false>;
+
+    return bDualHeaters ? parseStatus<true, true> : parseStatus<true, false>;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Only used for the handful of single value replies at startup
+bool quantumDecodeInteger(const char* pReply, int nLength, bool bOldFirmware, int32_t* pValue)
+{
+    QuantumSpan field;
+    if(quantumSplitFields(pReply, nLength, &field, 1) != 1)
+        return false;
+
+    if(bOldFirmware)
+        return QuantumField<false>::toInteger(field, pValue);
+
+    return QuantumField<true>::toInteger(field, pValue);
+}
@@ -0,0 +1,175 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* Parser for the GI (Get Info) status reply. The reply is parsed in place, straight
+ * out of the receive buffer, with no copies, no allocations, and no shared state, so
+ * it is safe to call from anywhere.
+ *
+ * The layout of the reply depends on the firmware (decimal fields before 1.26, hex
+ * after) and on the number of heaters. Those don't change once we are connected, so
+ * the right parser is picked once at connect time with quantumSelectStatusParser(),
+ * and each variant is compiled separately with nothing left to check per field.
+ *
+ * No Qt in here either.
+*/
+#ifndef QUANTUMPARSER_H
+#define QUANTUMPARSER_H
+
+#include <stdint.h>
+
+#include "quantumstatus.h"
+
+// Most fields we ever expect to see in a GI reply
+#define QUANTUM_MAX_STATUS_FIELDS   16
+
+// Fewest fields a GI reply can have, any more than this means two heaters
+#define QUANTUM_SINGLE_HEATER_FIELDS    12
+
+/////////////////////////////////////////////////////////////
+/// A piece of a reply. Just a pointer and a length, nothing is copied.
+struct QuantumSpan {
+    const char* pData;
+    int         nLength;
+};
+
+/////////////////////////////////////////////////////////////
+/// Field decoders. Firmware 1.26 and later send hex, before that it is
+/// ascii decimal. Signed hex values are 8 bit two's complement.
+template<bool bHex> struct QuantumField;
+
+template<> struct QuantumField<true> {
+    static inline bool toInteger(QuantumSpan field, int32_t* pValue) {
+        if(field.nLength <= 0 || field.nLength > 8)
+            return false;
+
+        uint32_t value = 0;
+        for(int i = 0; i < field.nLength; i++) {
+            uint32_t c = uint8_t(field.pData[i]);
+            uint32_t digit = c - '0';
+            if(digit > 9) {
+                digit = (c | 0x20) - 'a' + 10;  // Fold to lower case
+                if(digit < 10 || digit > 15)
+                    return false;
+                }
+            value = (value << 4) | digit;
+            }
+
+        *pValue = int32_t(value);
+        return true;
+    }
+
+    static inline bool toSignedInteger(QuantumSpan field, int32_t* pValue) {
+        int32_t value;
+        if(!toInteger(field, &value))
+            return false;
+
+        *pValue = int8_t(value & 0xff);
+        return true;
+    }
+};
+
+template<> struct QuantumField<false> {
+    static inline bool toSignedInteger(QuantumSpan field, int32_t* pValue) {
+        const char* p = field.pData;
+        const char* pEnd = field.pData + field.nLength;
+        bool bNegative = (p < pEnd && *p == '-');
+        if(bNegative)
+            p++;
+
+        if(p == pEnd || pEnd - p > 9)
+            return false;
+
+        int32_t value = 0;
+        for(; p < pEnd; p++) {
+            uint32_t digit = uint8_t(*p) - uint32_t('0');
+            if(digit > 9)
+                return false;
+            value = value * 10 + int32_t(digit);
+            }
+
+        *pValue = bNegative ? -value : value;
+        return true;
+    }
+
+    static inline bool toInteger(QuantumSpan field, int32_t* pValue) {
+        return toSignedInteger(field, pValue);
+    }
+};
+
+/////////////////////////////////////////////////////////////
+/// Where each value lives in the GI reply.
+/// example: v2.00 00 01 0001005C 00 0026 039D 0000289F 00000488 00000000 00002EE0 00ED
+/// The second heater adds its temperature after the first, and its PMW and limit
+/// after the calibration pot position. Fields we don't use are not listed.
+template<bool bDual> struct QuantumStatusLayout;
+
+template<> struct QuantumStatusLayout<false> {
+    enum {
+        nMinFields      = 10,
+        iErrorCode      = 1,
+        iOnBand         = 2,
+        iWavelength     = 3,
+        iWingshift      = 4,
+        iHeater1PMW     = 5,
+        iHeater1Limit   = 6,
+        iHeater1Temp    = 7,
+        iVoltage        = 8,
+        iCalibration    = 9,
+        iHeater2Temp    = 0,    // Not present
+        iHeater2PMW     = 0,
+        iHeater2Limit   = 0
+    };
+};
+
+template<> struct QuantumStatusLayout<true> {
+    enum {
+        nMinFields      = 13,
+        iErrorCode      = 1,
+        iOnBand         = 2,
+        iWavelength     = 3,
+        iWingshift      = 4,
+        iHeater1PMW     = 5,
+        iHeater1Limit   = 6,
+        iHeater1Temp    = 7,
+        iHeater2Temp    = 8,
+        iVoltage        = 9,
+        iCalibration    = 10,
+        iHeater2PMW     = 11,
+        iHeater2Limit   = 12
+    };
+};
+
+// Parse one GI reply into pStatus. Returns false (and leaves pStatus alone) if the reply
+// is short or any field is garbled.
+typedef bool (*QuantumStatusParser)(const char* pReply, int nLength, QuantumStatus* pStatus);
+
+// Pick the parser for this firmware and heater configuration
+QuantumStatusParser quantumSelectStatusParser(bool bOldFirmware, bool bDualHeaters);
+
+// Split a reply on spaces. Returns the number of fields found, up to nMaxFields.
+int quantumSplitFields(const char* pReply, int nLength, QuantumSpan* pFields, int nMaxFields);
+
+// Single value replies (GA, GX, etc.)
+bool quantumDecodeInteger(const char* pReply, int nLength, bool bOldFirmware, int32_t* pValue);
+
+#endif // QUANTUMPARSER_H
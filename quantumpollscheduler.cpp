@@ -0,0 +1,141 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+
+#include "quantumpollscheduler.h"
+
+// How much the interval grows each sample once settled
+#define POLL_BACKOFF_FACTOR     1.5
+
+// Weight of the newest sample in the smoothed sample rate
+#define SAMPLE_RATE_WEIGHT      0.2
+
+
+QuantumPollScheduler::QuantumPollScheduler(void)
+{
+    settings = defaultSettings();
+    nLastCommand = -1;
+    nLastSample = -1;
+    nSettledSince = -1;
+    fLastWavelength = 0.0f;
+    fLastWingshift = 0.0f;
+    nInterval = settings.nActiveInterval;
+    fSampleRate = 0.0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// One second used to be the only rate, so that is what we use on band
+QuantumPollSettings QuantumPollScheduler::defaultSettings(void)
+{
+    QuantumPollSettings defaults;
+    defaults.nActiveInterval = 250;
+    defaults.nOnBandInterval = 1000;
+    defaults.nStableInterval = 5000;
+    defaults.nSettleTime = 60000;
+    defaults.nCommandHoldTime = 5000;
+    defaults.nMinInterval = 100;
+    defaults.nMaxInterval = 10000;
+    return defaults;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+void QuantumPollScheduler::setSettings(const QuantumPollSettings& newSettings)
+{
+    settings = newSettings;
+    if(settings.nMinInterval < 1)
+        settings.nMinInterval = 1;
+    if(settings.nMaxInterval < settings.nMinInterval)
+        settings.nMaxInterval = settings.nMinInterval;
+
+    nInterval = clampInterval(nInterval);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+int QuantumPollScheduler::clampInterval(int nRequested) const
+{
+    if(nRequested < settings.nMinInterval)
+        return settings.nMinInterval;
+
+    if(nRequested > settings.nMaxInterval)
+        return settings.nMaxInterval;
+
+    return nRequested;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// The filter is about to move, pay attention
+void QuantumPollScheduler::commandSent(int64_t nNow)
+{
+    nLastCommand = nNow;
+    nSettledSince = -1;
+    nInterval = clampInterval(settings.nActiveInterval);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Work out the next interval from what the filter is doing now
+int QuantumPollScheduler::sampleTaken(const QuantumStatus& status, int64_t nNow)
+{
+    // Keep track of how often we are really getting samples
+    if(nLastSample >= 0 && nNow > nLastSample) {
+        double fRate = 1000.0 / double(nNow - nLastSample);
+        if(fSampleRate == 0.0)
+            fSampleRate = fRate;
+        else
+            fSampleRate += (fRate - fSampleRate) * SAMPLE_RATE_WEIGHT;
+        }
+    nLastSample = nNow;
+
+    bool bChanged = (status.centerWavelength != fLastWavelength || status.wingShift != fLastWingshift);
+    fLastWavelength = status.centerWavelength;
+    fLastWingshift = status.wingShift;
+
+    bool bRecentCommand = (nLastCommand >= 0 && nNow - nLastCommand < settings.nCommandHoldTime);
+
+    // Warming, cooling, or just told to go somewhere new
+    if(!status.bOnBand || bRecentCommand) {
+        nSettledSince = -1;
+        nInterval = clampInterval(settings.nActiveInterval);
+        return nInterval;
+        }
+
+    // On band, but something moved. Start the clock over.
+    if(bChanged || nSettledSince < 0) {
+        nSettledSince = nNow;
+        nInterval = clampInterval(settings.nOnBandInterval);
+        return nInterval;
+        }
+
+    // On band and nothing is happening. Back off a little at a time.
+    if(nNow - nSettledSince >= settings.nSettleTime) {
+        int nLonger = int(double(nInterval) * POLL_BACKOFF_FACTOR);
+        if(nLonger > settings.nStableInterval)
+            nLonger = settings.nStableInterval;
+        if(nLonger < nInterval)     // Stable is faster than on band? Take it as is
+            nLonger = settings.nStableInterval;
+        nInterval = clampInterval(nLonger);
+        }
+    else
+        nInterval = clampInterval(settings.nOnBandInterval);
+
+    return nInterval;
+}
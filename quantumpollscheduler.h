@@ -0,0 +1,83 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* Decides how long to wait before the next status poll. While the filter is warming,
+ * cooling, or has just been given a new setpoint, we poll quickly so on band shows up
+ * as soon as it happens. Once it has been on band and unchanged for a while, polling
+ * backs off a little at a time until it reaches the stable rate. Any change, or a
+ * command, puts it right back to the quick rate.
+ *
+ * Times are in milliseconds from any monotonic clock. No Qt in here.
+*/
+#ifndef QUANTUMPOLLSCHEDULER_H
+#define QUANTUMPOLLSCHEDULER_H
+
+#include <stdint.h>
+
+#include "quantumstatus.h"
+
+/////////////////////////////////////////////////////////////
+/// All intervals are in milliseconds
+struct QuantumPollSettings {
+    int nActiveInterval;        // Warming, cooling, or just got a new setpoint
+    int nOnBandInterval;        // On band, but not settled yet
+    int nStableInterval;        // On band and settled, slowest we go
+    int nSettleTime;            // On band and unchanged this long is settled
+    int nCommandHoldTime;       // Keep polling quickly this long after a command
+    int nMinInterval;           // Never poll faster than this
+    int nMaxInterval;           // or slower than this
+};
+
+class QuantumPollScheduler
+{
+public:
+    QuantumPollScheduler(void);
+
+    static QuantumPollSettings defaultSettings(void);
+
+    void setSettings(const QuantumPollSettings& newSettings);
+    const QuantumPollSettings& getSettings(void) const { return settings; }
+
+    // A command just went out
+    void commandSent(int64_t nNow);
+
+    // New status is in. Returns how long to wait before the next poll.
+    int sampleTaken(const QuantumStatus& status, int64_t nNow);
+
+    int     getInterval(void) const     { return nInterval; }
+    double  getSampleRate(void) const   { return fSampleRate; }     // Samples per second, smoothed
+
+protected:
+    QuantumPollSettings settings;
+    int64_t nLastCommand;               // When the last command went out
+    int64_t nLastSample;                // When the last sample came in
+    int64_t nSettledSince;              // On band and unchanged since, -1 if not
+    float   fLastWavelength;
+    float   fLastWingshift;
+    int     nInterval;
+    double  fSampleRate;
+
+    int clampInterval(int nRequested) const;
+};
+
+#endif // QUANTUMPOLLSCHEDULER_H
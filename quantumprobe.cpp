@@ -0,0 +1,178 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+
+#include "quantumprobe.h"
+#include "quantumdevice.h"
+#include "quantumparser.h"
+
+
+QuantumProbe::QuantumProbe(QObject *parent, const QSerialPortInfo& portInfo, int nPortIndex) : QObject(parent)
+{
+    serialPortInfo = portInfo;
+    nIndex = nPortIndex;
+
+    replyTimer.setSingleShot(true);
+    gapTimer.setSingleShot(true);
+    connect(&replyTimer, &QTimer::timeout, this, &QuantumProbe::replyTimedOut);
+    connect(&gapTimer, &QTimer::timeout, this, &QuantumProbe::replyWentQuiet);
+}
+
+QuantumProbe::~QuantumProbe(void)
+{
+    // The port is our child and goes with us, just make sure it's closed
+    if(pSerialPort)
+        pSerialPort->close();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Open the port and ask for status. If it won't open, we are done already.
+void QuantumProbe::start(void)
+{
+    pSerialPort = new QSerialPort(serialPortInfo, this);
+    QuantumDevice::configureSerialPort(pSerialPort);
+    connect(pSerialPort, &QSerialPort::readyRead, this, &QuantumProbe::serialReadyRead);
+
+    if(!pSerialPort->open(QIODevice::ReadWrite)) {
+        finish(false);
+        return;
+        }
+
+    sendCommand(QCMD_GET_INFO, PROBE_INFO);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Out of time, whatever we know is all we are going to know
+void QuantumProbe::abort(void)
+{
+    if(probeStage != PROBE_DONE)
+        finish(false);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+void QuantumProbe::sendCommand(QuantumCommandCode code, ProbeStage nextStage)
+{
+    char szCommand[QUANTUM_MAX_COMMAND_SIZE];
+    int nLength = QuantumCommand(code).encode(szCommand, sizeof(szCommand));
+
+    probeStage = nextStage;
+    framer.begin();
+    pSerialPort->write(szCommand, nLength);
+    replyTimer.start(QUANTUM_PROBE_TIMEOUT);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+void QuantumProbe::serialReadyRead(void)
+{
+    char chunk[MAX_COMM_BUFFER_SIZE];
+
+    while(pSerialPort->bytesAvailable() > 0) {
+        qint64 nRead = pSerialPort->read(chunk, sizeof(chunk));
+        if(nRead <= 0)
+            break;
+
+        if(probeStage == PROBE_DONE || probeStage == PROBE_IDLE)
+            continue;
+
+        framer.feed(chunk, int(nRead));
+        if(framer.isDone()) {
+            replyReceived();
+            return;
+            }
+        }
+
+    if(framer.getState() == QuantumFramer::FRAME_RECEIVING) {
+        replyTimer.stop();
+        gapTimer.start(QUANTUM_GAP_TIMEOUT);
+        }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// No answer. If it never answered the GI, it isn't a Quantum (or not one we can use).
+// If it did, we still count it even if the serial number or model didn't come back.
+void QuantumProbe::replyTimedOut(void)
+{
+    finish(probeStage != PROBE_INFO);
+}
+
+void QuantumProbe::replyWentQuiet(void)
+{
+    framer.finish();
+    replyReceived();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// A GI reply has to start with the firmware version and have at least as many fields as
+// a single heater Quantum sends
+void QuantumProbe::replyReceived(void)
+{
+    replyTimer.stop();
+    gapTimer.stop();
+
+    switch(probeStage) {
+        case PROBE_INFO: {
+            QuantumSpan fields[QUANTUM_MAX_STATUS_FIELDS];
+            int nFields = quantumSplitFields(framer.getData(), framer.getLength(), fields, QUANTUM_MAX_STATUS_FIELDS);
+            if(nFields < QuantumStatusLayout<false>::nMinFields || fields[0].pData[0] != 'v') {
+                finish(false);
+                return;
+                }
+
+            qsFirmwareVersion = QString::fromUtf8(fields[0].pData, fields[0].nLength);
+            sendCommand(QCMD_GET_SERIAL_NUMBER, PROBE_SERIAL);
+            break;
+            }
+
+        case PROBE_SERIAL:
+            qsSerialNumber = QString::fromUtf8(framer.getData(), framer.getLength());
+            sendCommand(QCMD_GET_MODEL_NAME, PROBE_MODEL);
+            break;
+
+        case PROBE_MODEL:
+            qsModelString = QString::fromUtf8(framer.getData(), framer.getLength());
+            finish(true);
+            break;
+
+        default:
+            break;
+        }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+// Let go of the port so it can be used for a real connection
+void QuantumProbe::finish(bool bQuantum)
+{
+    replyTimer.stop();
+    gapTimer.stop();
+
+    bFound = bQuantum;
+    probeStage = PROBE_DONE;
+
+    if(pSerialPort) {
+        pSerialPort->close();
+        pSerialPort->deleteLater();
+        pSerialPort = nullptr;
+        }
+
+    emit finished(this);
+}
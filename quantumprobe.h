@@ -0,0 +1,100 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* A quick check to see if there is a Quantum on a serial port. It sends a GI, and if
+ * what comes back looks like a Quantum status line, it asks for the serial number and
+ * model name so the user can tell them apart. Everything is event driven, so every
+ * port can be probed at the same time.
+ *
+ * This only looks, it doesn't connect. The port is closed when the probe is done.
+*/
+#ifndef QUANTUMPROBE_H
+#define QUANTUMPROBE_H
+
+#include <QObject>
+#include <QTimer>
+#include <QSerialPort>
+#include <QSerialPortInfo>
+
+#include "quantumframer.h"
+#include "quantumcommand.h"
+
+// How long to wait for each reply during a probe (milliseconds). Much shorter than a
+// normal connection, a Quantum answers quickly and anything else we don't care about.
+#define QUANTUM_PROBE_TIMEOUT   750
+
+class QuantumProbe : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QuantumProbe(QObject *parent, const QSerialPortInfo& portInfo, int nPortIndex);
+    ~QuantumProbe(void);
+
+    void start(void);
+    void abort(void);
+
+    const QSerialPortInfo& getSerialPortInfo(void) const { return serialPortInfo; }
+    int  getPortIndex(void) const                   { return nIndex; }
+    bool isFinished(void) const                     { return probeStage == PROBE_DONE; }
+    bool isQuantum(void) const                      { return bFound; }
+
+    const QString& getFirmwareVersion(void) const   { return qsFirmwareVersion; }
+    const QString& getSerialNumber(void) const      { return qsSerialNumber; }
+    const QString& getModelString(void) const       { return qsModelString; }
+
+protected:
+    enum ProbeStage {
+        PROBE_IDLE,
+        PROBE_INFO,
+        PROBE_SERIAL,
+        PROBE_MODEL,
+        PROBE_DONE
+    };
+
+    QSerialPortInfo     serialPortInfo;
+    QSerialPort         *pSerialPort = nullptr;
+    QTimer              replyTimer;
+    QTimer              gapTimer;
+    QuantumFramer       framer;
+    ProbeStage          probeStage = PROBE_IDLE;
+    int                 nIndex;
+    bool                bFound = false;
+
+    QString             qsFirmwareVersion;
+    QString             qsSerialNumber;
+    QString             qsModelString;
+
+    void sendCommand(QuantumCommandCode code, ProbeStage nextStage);
+    void replyReceived(void);
+    void finish(bool bQuantum);
+
+protected Q_SLOTS:
+    void serialReadyRead(void);
+    void replyTimedOut(void);
+    void replyWentQuiet(void);
+
+signals:
+    void finished(QuantumProbe *pProbe);
+};
+
+#endif // QUANTUMPROBE_H
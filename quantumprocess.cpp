@@ -0,0 +1,128 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+#include "quantumprocess.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <sys/resource.h>
+#else
+#include <sys/resource.h>
+#endif
+
+static std::chrono::steady_clock::time_point processStart = std::chrono::steady_clock::now();
+
+void quantumProcessStarted(void)
+{
+    processStart = std::chrono::steady_clock::now();
+}
+
+double quantumMsSinceStart(void)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - processStart).count();
+}
+
+#if defined(__linux__)
+///////////////////////////////////////////////////////////////////////
+// One "VmRSS:    1234 kB" line out of /proc/self/status
+static int64_t procStatusBytes(const char* szField)
+{
+    FILE* pFile = fopen("/proc/self/status", "r");
+    if(pFile == nullptr)
+        return 0;
+
+    char szLine[256];
+    size_t nField = strlen(szField);
+    long long nKB = 0;
+    while(fgets(szLine, sizeof(szLine), pFile) != nullptr)
+        if(strncmp(szLine, szField, nField) == 0) {
+            sscanf(szLine + nField, "%lld", &nKB);
+            break;
+            }
+
+    fclose(pFile);
+    return int64_t(nKB) * 1024;
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////
+int64_t quantumResidentBytes(void)
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return int64_t(counters.WorkingSetSize);
+    return 0;
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t nCount = MACH_TASK_BASIC_INFO_COUNT;
+    if(task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &nCount) == KERN_SUCCESS)
+        return int64_t(info.resident_size);
+    return 0;
+#elif defined(__linux__)
+    return procStatusBytes("VmRSS:");
+#else
+    return 0;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////
+int64_t quantumPeakResidentBytes(void)
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return int64_t(counters.PeakWorkingSetSize);
+    return 0;
+#elif defined(__APPLE__)
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) == 0)
+        return int64_t(usage.ru_maxrss);                // Bytes on macOS
+    return 0;
+#elif defined(__linux__)
+    // The high water mark is only brought up to date now and then
+    int64_t nPeak = procStatusBytes("VmHWM:");
+    int64_t nNow = procStatusBytes("VmRSS:");
+    return (nNow > nPeak) ? nNow : nPeak;
+#else
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) == 0)
+        return int64_t(usage.ru_maxrss) * 1024;         // Kilobytes most places
+    return 0;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////
+void quantumPrintStartupStats(const char* szWhat)
+{
+    fprintf(stderr, "startup: %s after %.0f ms, resident %.1f MB, peak %.1f MB\n", szWhat, quantumMsSinceStart(),
+            double(quantumResidentBytes()) / (1024.0 * 1024.0), double(quantumPeakResidentBytes()) / (1024.0 * 1024.0));
+    fflush(stderr);
+}
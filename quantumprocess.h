@@ -0,0 +1,48 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* How long since the process started, and how much memory it is holding. For
+ * comparing the GUI and the command line controller, so it's the same
+ * measurement in both. Set QUANTUM_STARTUP_STATS and either one prints a line
+ * on stderr once it is connected and has status.
+ *
+ * No Qt in here.
+*/
+#ifndef QUANTUMPROCESS_H
+#define QUANTUMPROCESS_H
+
+#include <stdint.h>
+
+// First thing in main(), everything is timed from here
+void quantumProcessStarted(void);
+
+double quantumMsSinceStart(void);
+
+// Resident set, now and at its highest. 0 if the platform won't say.
+int64_t quantumResidentBytes(void);
+int64_t quantumPeakResidentBytes(void);
+
+// "startup: <szWhat> after 123 ms, resident 12.3 MB, peak 14.5 MB" on stderr
+void quantumPrintStartupStats(const char* szWhat);
+
+#endif // QUANTUMPROCESS_H
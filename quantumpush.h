@@ -0,0 +1,181 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* The status push protocol, for other programs on the same machine that want the
+ * Quantum's status while Quantum Control owns the serial port. Connect to the port
+ * it listens on (loopback only unless asked otherwise) and every new sample comes
+ * to you the moment it has been read, no polling.
+ *
+ * Everything is frames, both ways. A frame is a four byte header and then the
+ * payload. All numbers are little endian, floats are IEEE single precision.
+ *
+ *   uint16 nLength          Payload bytes after the header
+ *   uint8  nType            QPUSH_*
+ *   uint8  nReserved        0
+ *
+ * Server to client:
+ *   QPUSH_HELLO     First thing after connecting. uint16 protocol version, float design
+ *                   wavelength, then the serial number as text to the end of the payload.
+ *   QPUSH_STATUS    One sample, QPUSH_STATUS_SIZE bytes, laid out as QuantumPushStatus
+ *                   (see quantumPushDecodeStatus() for the offsets).
+ *   QPUSH_REPLY     uint8 request type, uint8 QPUSH_RESULT_*
+ *   QPUSH_CONTROL   uint8 1 if you now have control, 0 if you lost it, uint8 the
+ *                   priority of whoever has it now (0 if nobody)
+ *
+ * Client to server:
+ *   QPUSH_CLAIM     uint8 priority. Granted if nobody has control or your priority is
+ *                   higher than theirs, in which case they are told they lost it.
+ *   QPUSH_RELEASE   Give it up. Disconnecting does the same.
+ *   QPUSH_SET_WINGSHIFT  int8 tenths of an Angstrom, -10 to 10. Only from whoever
+ *                   has control. Quantum Control's own buttons always work.
+ *
+ * Every request gets a QPUSH_REPLY. A client that can't keep up doesn't slow anyone
+ * else down: the server keeps only a few frames queued for it, and while it's behind,
+ * newer samples replace the one waiting to go. It gets the latest, not all of them.
+ *
+ * Plain C++, no Qt, so a client can use it as is.
+*/
+#ifndef QUANTUMPUSH_H
+#define QUANTUMPUSH_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include "quantumstatus.h"
+
+#define QPUSH_PROTOCOL_VERSION  1
+#define QPUSH_DEFAULT_PORT      5280
+#define QPUSH_HEADER_SIZE       4
+#define QPUSH_STATUS_SIZE       68
+#define QPUSH_MAX_PAYLOAD       256         // Anything bigger from a client is a broken client
+
+enum QuantumPushType {
+    QPUSH_HELLO = 1,
+    QPUSH_STATUS = 2,
+    QPUSH_REPLY = 3,
+    QPUSH_CONTROL = 4,
+
+    QPUSH_CLAIM = 16,
+    QPUSH_RELEASE = 17,
+    QPUSH_SET_WINGSHIFT = 18
+};
+
+enum QuantumPushResult {
+    QPUSH_RESULT_OK = 0,
+    QPUSH_RESULT_NOT_OWNER,                 // Claim control first
+    QPUSH_RESULT_OUTRANKED,                 // Someone with a higher (or equal) priority has it
+    QPUSH_RESULT_BAD_REQUEST,               // Unknown type, wrong length, or out of range
+    QPUSH_RESULT_BUSY                       // Command queue is full, try again
+};
+
+/////////////////////////////////////////////////////////////
+/// What a QPUSH_STATUS frame carries
+struct QuantumPushStatus {
+    uint64_t    nSequence;
+    int64_t     nCaptureTime;               // Server's steady clock, nanoseconds
+    int64_t     nWallTime;                  // Milliseconds since the epoch, UTC
+    float       fWavelength;
+    float       fWingshift;
+    float       fTarget;
+    float       fHeater1Temperature;
+    float       fHeater2Temperature;
+    float       fHeater1PWM;
+    float       fHeater2PWM;
+    float       fInputVoltage;
+    float       fWavelengthRate;            // Angstroms per second
+    float       fSecondsToOnBand;           // 0 on band, less than 0 not known
+    int16_t     nErrorCode;
+    uint8_t     nFlags;                     // QPUSH_FLAG_*
+};
+
+#define QPUSH_FLAG_ON_BAND          1
+#define QPUSH_FLAG_DUAL_HEATERS     2
+
+///////////////////////////////////////////////////////////////////////
+// Little endian, whatever the host is
+inline void quantumPushPut16(uint8_t* p, uint16_t n) { p[0] = uint8_t(n); p[1] = uint8_t(n >> 8); }
+inline void quantumPushPut32(uint8_t* p, uint32_t n) { quantumPushPut16(p, uint16_t(n)); quantumPushPut16(p + 2, uint16_t(n >> 16)); }
+inline void quantumPushPut64(uint8_t* p, uint64_t n) { quantumPushPut32(p, uint32_t(n)); quantumPushPut32(p + 4, uint32_t(n >> 32)); }
+inline void quantumPushPutFloat(uint8_t* p, float f) { uint32_t n; memcpy(&n, &f, 4); quantumPushPut32(p, n); }
+
+inline uint16_t quantumPushGet16(const uint8_t* p) { return uint16_t(p[0] | (p[1] << 8)); }
+inline uint32_t quantumPushGet32(const uint8_t* p) { return uint32_t(quantumPushGet16(p)) | (uint32_t(quantumPushGet16(p + 2)) << 16); }
+inline uint64_t quantumPushGet64(const uint8_t* p) { return uint64_t(quantumPushGet32(p)) | (uint64_t(quantumPushGet32(p + 4)) << 32); }
+inline float quantumPushGetFloat(const uint8_t* p) { uint32_t n = quantumPushGet32(p); float f; memcpy(&f, &n, 4); return f; }
+
+inline void quantumPushHeader(uint8_t* p, int nType, int nLength)
+{
+    quantumPushPut16(p, uint16_t(nLength));
+    p[2] = uint8_t(nType);
+    p[3] = 0;
+}
+
+///////////////////////////////////////////////////////////////////////
+// A whole QPUSH_STATUS frame, header and all, into pFrame
+// (QPUSH_HEADER_SIZE + QPUSH_STATUS_SIZE bytes)
+inline void quantumPushEncodeStatus(const QuantumStatusSnapshot& snapshot, uint8_t* pFrame)
+{
+    const QuantumStatus& status = snapshot.status;
+    uint8_t* p = pFrame + QPUSH_HEADER_SIZE;
+
+    quantumPushHeader(pFrame, QPUSH_STATUS, QPUSH_STATUS_SIZE);
+    quantumPushPut64(p + 0, snapshot.nSequence);
+    quantumPushPut64(p + 8, uint64_t(snapshot.nCaptureTime));
+    quantumPushPut64(p + 16, uint64_t(snapshot.nWallTime));
+    quantumPushPutFloat(p + 24, status.centerWavelength);
+    quantumPushPutFloat(p + 28, status.wingShift);
+    quantumPushPutFloat(p + 32, snapshot.drift.fTarget);
+    quantumPushPutFloat(p + 36, status.heater1Temprature);
+    quantumPushPutFloat(p + 40, status.heater2Temperature);
+    quantumPushPutFloat(p + 44, status.heater1PMW);
+    quantumPushPutFloat(p + 48, status.heater2PMW);
+    quantumPushPutFloat(p + 52, status.inputVoltage);
+    quantumPushPutFloat(p + 56, snapshot.drift.fWavelengthRate);
+    quantumPushPutFloat(p + 60, snapshot.drift.fSecondsToOnBand);
+    quantumPushPut16(p + 64, uint16_t(int16_t(status.nErrorCode)));
+    p[66] = uint8_t((status.bOnBand ? QPUSH_FLAG_ON_BAND : 0) | (status.bDualHeaters ? QPUSH_FLAG_DUAL_HEATERS : 0));
+    p[67] = 0;
+}
+
+///////////////////////////////////////////////////////////////////////
+// The payload of a QPUSH_STATUS frame, after the header
+inline void quantumPushDecodeStatus(const uint8_t* p, QuantumPushStatus* pStatus)
+{
+    pStatus->nSequence = quantumPushGet64(p + 0);
+    pStatus->nCaptureTime = int64_t(quantumPushGet64(p + 8));
+    pStatus->nWallTime = int64_t(quantumPushGet64(p + 16));
+    pStatus->fWavelength = quantumPushGetFloat(p + 24);
+    pStatus->fWingshift = quantumPushGetFloat(p + 28);
+    pStatus->fTarget = quantumPushGetFloat(p + 32);
+    pStatus->fHeater1Temperature = quantumPushGetFloat(p + 36);
+    pStatus->fHeater2Temperature = quantumPushGetFloat(p + 40);
+    pStatus->fHeater1PWM = quantumPushGetFloat(p + 44);
+    pStatus->fHeater2PWM = quantumPushGetFloat(p + 48);
+    pStatus->fInputVoltage = quantumPushGetFloat(p + 52);
+    pStatus->fWavelengthRate = quantumPushGetFloat(p + 56);
+    pStatus->fSecondsToOnBand = quantumPushGetFloat(p + 60);
+    pStatus->nErrorCode = int16_t(quantumPushGet16(p + 64));
+    pStatus->nFlags = p[66];
+}
+
+#endif // QUANTUMPUSH_H
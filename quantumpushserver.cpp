@@ -0,0 +1,268 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+#include "quantumpushserver.h"
+#include "quantumdevice.h"
+#include "quantumtrace.h"
+
+#include <QHostAddress>
+
+
+///////////////////////////////////////////////////////////////////////
+QuantumPushServer::QuantumPushServer(QuantumDevice *pQuantumDevice)
+{
+    pDevice = pQuantumDevice;
+    connect(&server, &QTcpServer::newConnection, this, &QuantumPushServer::newConnection);
+}
+
+QuantumPushServer::~QuantumPushServer(void)
+{
+    server.close();
+    for(int i = 0; i < clientList.size(); i++) {
+        clientList[i]->pSocket->disconnect(this);
+        clientList[i]->pSocket->abort();
+        delete clientList[i]->pSocket;
+        }
+    qDeleteAll(clientList);
+}
+
+///////////////////////////////////////////////////////////////////////
+bool QuantumPushServer::listen(quint16 nPort, bool bLoopbackOnly)
+{
+    return server.listen(bLoopbackOnly ? QHostAddress(QHostAddress::LocalHost) : QHostAddress(QHostAddress::Any), nPort);
+}
+
+///////////////////////////////////////////////////////////////////////
+QuantumPushServer::PushClient* QuantumPushServer::findClient(QObject *pSocket)
+{
+    for(int i = 0; i < clientList.size(); i++)
+        if(clientList[i]->pSocket == pSocket)
+            return clientList[i];
+
+    return nullptr;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Say hello, and give them the latest sample so they don't have to wait for one
+void QuantumPushServer::newConnection(void)
+{
+    while(server.hasPendingConnections()) {
+        QTcpSocket *pSocket = server.nextPendingConnection();
+        pSocket->setParent(nullptr);
+        pSocket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+        // Otherwise the kernel takes megabytes for a client that has stopped reading,
+        // and it gets samples from minutes ago, not the latest
+        pSocket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, int(sizeof(latestFrame)) * QPUSH_CLIENT_QUEUE);
+
+        PushClient *pClient = new PushClient;
+        pClient->pSocket = pSocket;
+        clientList.append(pClient);
+
+        connect(pSocket, &QTcpSocket::readyRead, this, &QuantumPushServer::clientReadyRead);
+        connect(pSocket, &QTcpSocket::bytesWritten, this, &QuantumPushServer::clientBytesWritten);
+        connect(pSocket, &QTcpSocket::disconnected, this, &QuantumPushServer::clientDisconnected);
+
+        QuantumStaticInfo info = pDevice->getStaticInfo();
+        QByteArray serial = info.qsSerialNumber.toUtf8().left(QPUSH_MAX_PAYLOAD - 6);
+        uint8_t hello[QPUSH_MAX_PAYLOAD];
+        quantumPushPut16(hello, QPUSH_PROTOCOL_VERSION);
+        quantumPushPutFloat(hello + 2, info.qsDesignWavelength.toFloat());
+        memcpy(hello + 6, serial.constData(), size_t(serial.size()));
+        sendFrame(pClient, QPUSH_HELLO, hello, 6 + serial.size());
+
+        if(bHaveFrame)
+            sendStatus(pClient);
+        }
+}
+
+///////////////////////////////////////////////////////////////////////
+void QuantumPushServer::sendFrame(PushClient *pClient, int nType, const uint8_t *pPayload, int nLength)
+{
+    uint8_t header[QPUSH_HEADER_SIZE];
+    quantumPushHeader(header, nType, nLength);
+
+    QByteArray frame(reinterpret_cast<const char*>(header), QPUSH_HEADER_SIZE);
+    frame.append(reinterpret_cast<const char*>(pPayload), nLength);
+    pClient->pSocket->write(frame);
+}
+
+void QuantumPushServer::sendReply(PushClient *pClient, int nRequest, int nResult)
+{
+    uint8_t reply[2] = { uint8_t(nRequest), uint8_t(nResult) };
+    sendFrame(pClient, QPUSH_REPLY, reply, 2);
+}
+
+void QuantumPushServer::sendControl(PushClient *pClient, bool bHasControl)
+{
+    uint8_t control[2] = { uint8_t(bHasControl ? 1 : 0), uint8_t(pOwner ? pOwner->nPriority : 0) };
+    sendFrame(pClient, QPUSH_CONTROL, control, 2);
+}
+
+///////////////////////////////////////////////////////////////////////
+// If it's too far behind, don't queue more. Note that the latest is owed to
+// it, and it goes when there is room, by which time it may have been replaced
+// by a newer one.
+void QuantumPushServer::sendStatus(PushClient *pClient)
+{
+    if(pClient->pSocket->bytesToWrite() + qint64(sizeof(latestFrame)) > qint64(sizeof(latestFrame)) * QPUSH_CLIENT_QUEUE) {
+        if(pClient->bPending)
+            pClient->nDropped++;
+        pClient->bPending = true;
+        return;
+        }
+
+    pClient->bPending = false;
+    pClient->pSocket->write(reinterpret_cast<const char*>(latestFrame), sizeof(latestFrame));
+}
+
+///////////////////////////////////////////////////////////////////////
+void QuantumPushServer::publish(const QuantumStatusSnapshot& snapshot)
+{
+    QUANTUM_TRACE_SCOPE("publish push");
+
+    quantumPushEncodeStatus(snapshot, latestFrame);
+    bHaveFrame = true;
+
+    for(int i = 0; i < clientList.size(); i++)
+        sendStatus(clientList[i]);
+}
+
+///////////////////////////////////////////////////////////////////////
+void QuantumPushServer::clientBytesWritten(qint64 nBytes)
+{
+    (void)nBytes;
+
+    PushClient *pClient = findClient(sender());
+    if(pClient != nullptr && pClient->bPending)
+        sendStatus(pClient);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Whole frames only. Anything claiming to be huge is not one of ours.
+void QuantumPushServer::clientReadyRead(void)
+{
+    PushClient *pClient = findClient(sender());
+    if(pClient == nullptr)
+        return;
+
+    pClient->received.append(pClient->pSocket->readAll());
+
+    int nUsed = 0;
+    while(pClient->received.size() - nUsed >= QPUSH_HEADER_SIZE) {
+        const uint8_t *pFrame = reinterpret_cast<const uint8_t*>(pClient->received.constData()) + nUsed;
+        int nLength = quantumPushGet16(pFrame);
+        if(nLength > QPUSH_MAX_PAYLOAD) {
+            pClient->pSocket->abort();
+            return;
+            }
+
+        if(pClient->received.size() - nUsed < QPUSH_HEADER_SIZE + nLength)
+            break;
+
+        handleFrame(pClient, pFrame[2], pFrame + QPUSH_HEADER_SIZE, nLength);
+        nUsed += QPUSH_HEADER_SIZE + nLength;
+        }
+
+    pClient->received.remove(0, nUsed);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Control goes to whoever asks if nobody has it, or to a higher priority
+void QuantumPushServer::handleFrame(PushClient *pClient, int nType, const uint8_t *pPayload, int nLength)
+{
+    switch(nType) {
+        case QPUSH_CLAIM: {
+            if(nLength != 1)
+                break;
+
+            int nPriority = pPayload[0];
+            if(pOwner != nullptr && pOwner != pClient && nPriority <= pOwner->nPriority) {
+                sendReply(pClient, nType, QPUSH_RESULT_OUTRANKED);
+                return;
+                }
+
+            PushClient *pLoser = (pOwner != pClient) ? pOwner : nullptr;
+            pOwner = pClient;
+            pOwner->nPriority = nPriority;
+
+            sendReply(pClient, nType, QPUSH_RESULT_OK);
+            sendControl(pClient, true);
+            if(pLoser != nullptr)
+                sendControl(pLoser, false);
+            return;
+            }
+
+        case QPUSH_RELEASE:
+            if(nLength != 0)
+                break;
+
+            if(pOwner != pClient) {
+                sendReply(pClient, nType, QPUSH_RESULT_NOT_OWNER);
+                return;
+                }
+
+            pOwner = nullptr;
+            sendReply(pClient, nType, QPUSH_RESULT_OK);
+            sendControl(pClient, false);
+            return;
+
+        case QPUSH_SET_WINGSHIFT: {
+            if(nLength != 1)
+                break;
+
+            int nTenths = int8_t(pPayload[0]);
+            if(nTenths < -10 || nTenths > 10)
+                break;
+
+            if(pOwner != pClient) {
+                sendReply(pClient, nType, QPUSH_RESULT_NOT_OWNER);
+                return;
+                }
+
+            bool bQueued = pDevice->addCommand(QuantumCommand::setWingshift(nTenths));
+            sendReply(pClient, nType, bQueued ? QPUSH_RESULT_OK : QPUSH_RESULT_BUSY);
+            return;
+            }
+
+        default:
+            break;
+        }
+
+    sendReply(pClient, nType, QPUSH_RESULT_BAD_REQUEST);
+}
+
+///////////////////////////////////////////////////////////////////////
+void QuantumPushServer::clientDisconnected(void)
+{
+    PushClient *pClient = findClient(sender());
+    if(pClient == nullptr)
+        return;
+
+    if(pOwner == pClient)
+        pOwner = nullptr;
+
+    clientList.removeOne(pClient);
+    pClient->pSocket->deleteLater();
+    delete pClient;
+}
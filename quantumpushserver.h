@@ -0,0 +1,89 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* Pushes each status sample to programs on this machine over TCP, and takes
+ * commands back from whichever one has control. The protocol is in quantumpush.h.
+ *
+ * Lives on the device's I/O thread, so a sample goes out to every client as soon
+ * as it has been parsed, with no hop to another thread first. Each sample is encoded
+ * once and the same bytes are written to everyone.
+*/
+#ifndef QUANTUMPUSHSERVER_H
+#define QUANTUMPUSHSERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QList>
+#include <QByteArray>
+
+#include "quantumpush.h"
+
+#define QPUSH_CLIENT_QUEUE      4       // Status frames a client can be behind before samples are dropped
+
+class QuantumDevice;
+
+class QuantumPushServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit QuantumPushServer(QuantumDevice *pQuantumDevice);
+    ~QuantumPushServer(void);
+
+    bool listen(quint16 nPort, bool bLoopbackOnly);
+    quint16 getPort(void) const { return server.serverPort(); }
+
+    // From the I/O thread, right after the sample is published
+    void publish(const QuantumStatusSnapshot& snapshot);
+
+protected:
+    struct PushClient {
+        QTcpSocket  *pSocket = nullptr;
+        QByteArray  received;                   // Partial frames
+        int         nPriority = 0;              // While it has control
+        bool        bPending = false;           // The latest sample is still to go to it
+        quint64     nDropped = 0;               // Samples it never got, being too slow
+    };
+
+    QuantumDevice   *pDevice = nullptr;
+    QTcpServer      server;
+    QList<PushClient*> clientList;
+    PushClient      *pOwner = nullptr;          // Has control, if anybody
+    uint8_t         latestFrame[QPUSH_HEADER_SIZE + QPUSH_STATUS_SIZE];
+    bool            bHaveFrame = false;
+
+    PushClient* findClient(QObject *pSocket);
+    void sendFrame(PushClient *pClient, int nType, const uint8_t *pPayload, int nLength);
+    void sendStatus(PushClient *pClient);
+    void sendReply(PushClient *pClient, int nRequest, int nResult);
+    void sendControl(PushClient *pClient, bool bHasControl);
+    void handleFrame(PushClient *pClient, int nType, const uint8_t *pPayload, int nLength);
+
+protected Q_SLOTS:
+    void newConnection(void);
+    void clientReadyRead(void);
+    void clientBytesWritten(qint64 nBytes);
+    void clientDisconnected(void);
+};
+
+#endif // QUANTUMPUSHSERVER_H
@@ -0,0 +1,347 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+#include <string.h>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+
+#include "quantumrecorder.h"
+
+#define QUANTUM_RECORDER_MAGIC      "QSFRING"
+#define QUANTUM_RECORDER_VERSION    1
+
+/////////////////////////////////////////////////////////////
+/// The front of the file. nNextSequence is only ever written
+/// by the recording thread, after the slot it points past.
+struct QuantumRecorder::FileHeader {
+    char                    szMagic[8];
+    uint32_t                nVersion;
+    uint32_t                nRecordSize;
+    uint32_t                nCapacity;
+    uint32_t                nReserved;
+    std::atomic<uint64_t>   nNextSequence;
+    int64_t                 nCreated;       // Milliseconds since the epoch, UTC
+    uint8_t                 reserved[24];
+};
+
+/////////////////////////////////////////////////////////////
+/// One slot in the ring. nSequence is 0 while the record is
+/// being written, and the sample number once it is done.
+struct QuantumRecorder::Slot {
+    std::atomic<uint64_t>   nSequence;
+    std::atomic<uint32_t>   words[sizeof(QuantumRecord) / sizeof(uint32_t)];
+};
+
+static_assert(sizeof(QuantumRecord) == 56, "QuantumRecord is part of the file format");
+static_assert(sizeof(QuantumRecord) % sizeof(uint32_t) == 0, "QuantumRecord must be whole words");
+
+enum { nRecordWords = sizeof(QuantumRecord) / sizeof(uint32_t) };
+
+
+///////////////////////////////////////////////////////////////////////
+void quantumRecordFromSnapshot(const QuantumStatusSnapshot& snapshot, QuantumRecord* pRecord)
+{
+    const QuantumStatus& status = snapshot.status;
+
+    memset(pRecord, 0, sizeof(QuantumRecord));
+    pRecord->nCaptureTime = snapshot.nCaptureTime;
+    pRecord->nWallTime = snapshot.nWallTime;
+    pRecord->centerWavelength = status.centerWavelength;
+    pRecord->wingShift = status.wingShift;
+    pRecord->heater1Temperature = status.heater1Temprature;
+    pRecord->heater2Temperature = status.heater2Temperature;
+    pRecord->heater1PWM = status.heater1PMW;
+    pRecord->heater2PWM = status.heater2PMW;
+    pRecord->inputVoltage = status.inputVoltage;
+    pRecord->nErrorCode = int16_t(status.nErrorCode);
+    pRecord->nHeater1PWMLimit = int16_t(status.heater1PMWLimit);
+    pRecord->nHeater2PWMLimit = int16_t(status.heater2PMWLimit);
+    pRecord->nCalibrationPotPos = int16_t(status.calibrationPotPos);
+
+    if(status.bOnBand)
+        pRecord->nFlags |= QUANTUM_RECORD_ON_BAND;
+    if(status.bDualHeaters)
+        pRecord->nFlags |= QUANTUM_RECORD_DUAL_HEATERS;
+}
+
+///////////////////////////////////////////////////////////////////////
+QuantumRecorder::QuantumRecorder(void)
+{
+    static_assert(sizeof(FileHeader) == 64, "The header is part of the file format");
+    static_assert(sizeof(Slot) == 64, "Slots must stay on 64 byte boundaries");
+}
+
+QuantumRecorder::~QuantumRecorder(void)
+{
+    close();
+}
+
+///////////////////////////////////////////////////////////////////////
+// Serial numbers come from the device, keep them out of the path
+QString QuantumRecorder::fileForSerial(const QString& qsSerialNumber)
+{
+    QString qsName = qsSerialNumber.isEmpty() ? QString("unknown") : qsSerialNumber;
+    qsName.replace('/', '_');
+    qsName.replace('\\', '_');
+    qsName.replace(':', '_');
+
+    QString qsFolder = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(qsFolder);
+    return qsFolder + QString("/history-") + qsName + QString(".qsr");
+}
+
+///////////////////////////////////////////////////////////////////////
+bool QuantumRecorder::mapFile(QIODevice::OpenMode mode)
+{
+    if(!file.open(mode))
+        return false;
+
+    if(file.size() < qint64(sizeof(FileHeader)))
+        return true;    // Nothing to map yet, the caller decides
+
+    pMapped = file.map(0, file.size());
+    if(pMapped == nullptr) {
+        file.close();
+        return false;
+        }
+
+    pHeader = reinterpret_cast<FileHeader*>(pMapped);
+    pSlots = reinterpret_cast<Slot*>(pMapped + sizeof(FileHeader));
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Is this a ring of ours, and the right size?
+bool QuantumRecorder::headerMatches(uint32_t nCapacity) const
+{
+    if(pHeader == nullptr)
+        return false;
+
+    if(memcmp(pHeader->szMagic, QUANTUM_RECORDER_MAGIC, sizeof(pHeader->szMagic)) != 0)
+        return false;
+
+    if(pHeader->nVersion != QUANTUM_RECORDER_VERSION || pHeader->nRecordSize != sizeof(Slot))
+        return false;
+
+    if(pHeader->nCapacity == 0 || (nCapacity != 0 && pHeader->nCapacity != nCapacity))
+        return false;
+
+    return file.size() == qint64(sizeof(FileHeader)) + qint64(pHeader->nCapacity) * qint64(sizeof(Slot));
+}
+
+///////////////////////////////////////////////////////////////////////
+// Throw away whatever is there and make an empty ring
+void QuantumRecorder::startOver(uint32_t nCapacity)
+{
+    if(pMapped != nullptr)
+        file.unmap(pMapped);
+    pMapped = nullptr;
+    pHeader = nullptr;
+    pSlots = nullptr;
+
+    // Truncating first means every slot comes back zeroed, which is empty
+    qint64 nSize = qint64(sizeof(FileHeader)) + qint64(nCapacity) * qint64(sizeof(Slot));
+    if(!file.resize(0) || !file.resize(nSize))
+        return;
+
+    pMapped = file.map(0, nSize);
+    if(pMapped == nullptr)
+        return;
+
+    pHeader = reinterpret_cast<FileHeader*>(pMapped);
+    pSlots = reinterpret_cast<Slot*>(pMapped + sizeof(FileHeader));
+
+    memcpy(pHeader->szMagic, QUANTUM_RECORDER_MAGIC, sizeof(pHeader->szMagic));
+    pHeader->nVersion = QUANTUM_RECORDER_VERSION;
+    pHeader->nRecordSize = sizeof(Slot);
+    pHeader->nCapacity = nCapacity;
+    pHeader->nCreated = QDateTime::currentMSecsSinceEpoch();
+    pHeader->nNextSequence.store(1, std::memory_order_release);
+}
+
+///////////////////////////////////////////////////////////////////////
+// The header is written after the slot, so a crash in between leaves it one behind
+void QuantumRecorder::recoverHead(void)
+{
+    uint64_t nNext = pHeader->nNextSequence.load(std::memory_order_relaxed);
+    if(nNext == 0)
+        nNext = 1;
+
+    while(pSlots[(nNext - 1) % nSlots].nSequence.load(std::memory_order_relaxed) == nNext)
+        nNext++;
+
+    pHeader->nNextSequence.store(nNext, std::memory_order_release);
+}
+
+///////////////////////////////////////////////////////////////////////
+bool QuantumRecorder::open(const QString& qsFileName, uint32_t nCapacity)
+{
+    close();
+
+    if(nCapacity == 0)
+        return false;
+
+    file.setFileName(qsFileName);
+    if(!mapFile(QIODevice::ReadWrite))
+        return false;
+
+    if(!headerMatches(nCapacity))
+        startOver(nCapacity);
+
+    if(pHeader == nullptr) {
+        close();
+        return false;
+        }
+
+    nSlots = pHeader->nCapacity;
+    bWritable = true;
+    recoverHead();
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////
+bool QuantumRecorder::openReadOnly(const QString& qsFileName)
+{
+    close();
+
+    file.setFileName(qsFileName);
+    if(!mapFile(QIODevice::ReadOnly))
+        return false;
+
+    if(!headerMatches(0)) {
+        close();
+        return false;
+        }
+
+    nSlots = pHeader->nCapacity;
+    bWritable = false;
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////
+void QuantumRecorder::close(void)
+{
+    if(pMapped != nullptr)
+        file.unmap(pMapped);
+
+    pMapped = nullptr;
+    pHeader = nullptr;
+    pSlots = nullptr;
+    nSlots = 0;
+    bWritable = false;
+
+    if(file.isOpen())
+        file.close();
+}
+
+///////////////////////////////////////////////////////////////////////
+// Same dance as QuantumSeqLock, with one lock per slot. The slot reads as empty
+// until the last store.
+void QuantumRecorder::append(const QuantumStatusSnapshot& snapshot)
+{
+    if(!bWritable)
+        return;
+
+    QuantumRecord record;
+    quantumRecordFromSnapshot(snapshot, &record);
+
+    uint32_t words[nRecordWords];
+    memcpy(words, &record, sizeof(record));
+
+    uint64_t nSequence = pHeader->nNextSequence.load(std::memory_order_relaxed);
+    Slot& slot = pSlots[(nSequence - 1) % nSlots];
+
+    slot.nSequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for(int i = 0; i < nRecordWords; i++)
+        slot.words[i].store(words[i], std::memory_order_relaxed);
+
+    slot.nSequence.store(nSequence, std::memory_order_release);
+    pHeader->nNextSequence.store(nSequence + 1, std::memory_order_release);
+}
+
+///////////////////////////////////////////////////////////////////////
+uint64_t QuantumRecorder::getNextSequence(void) const
+{
+    if(pHeader == nullptr)
+        return 1;
+
+    return pHeader->nNextSequence.load(std::memory_order_acquire);
+}
+
+uint64_t QuantumRecorder::getFirstSequence(void) const
+{
+    uint64_t nNext = getNextSequence();
+    if(nNext > nSlots)
+        return nNext - nSlots;
+
+    return 1;
+}
+
+///////////////////////////////////////////////////////////////////////
+bool QuantumRecorder::read(uint64_t nSequence, QuantumRecord* pRecord) const
+{
+    if(pHeader == nullptr || nSequence == 0)
+        return false;
+
+    const Slot& slot = pSlots[(nSequence - 1) % nSlots];
+    if(slot.nSequence.load(std::memory_order_acquire) != nSequence)
+        return false;
+
+    uint32_t words[nRecordWords];
+    for(int i = 0; i < nRecordWords; i++)
+        words[i] = slot.words[i].load(std::memory_order_relaxed);
+
+    // Overwritten while we were copying it
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(slot.nSequence.load(std::memory_order_relaxed) != nSequence)
+        return false;
+
+    memcpy(pRecord, words, sizeof(QuantumRecord));
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////
+int QuantumRecorder::readRange(uint64_t nFrom, QuantumRecord* pRecords, int nMaxRecords, uint64_t* pNext) const
+{
+    uint64_t nFirst = getFirstSequence();
+    uint64_t nEnd = getNextSequence();
+    if(nFrom < nFirst)
+        nFrom = nFirst;
+
+    int nCount = 0;
+    while(nFrom < nEnd && nCount < nMaxRecords) {
+        if(read(nFrom, &pRecords[nCount]))
+            nCount++;
+        nFrom++;
+        }
+
+    if(pNext != nullptr)
+        *pNext = nFrom;
+
+    return nCount;
+}
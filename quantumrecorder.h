@@ -0,0 +1,134 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* Every status sample, kept on disk in a fixed size ring. The file is mapped, so
+ * recording a sample is a few stores into memory and nothing else: no allocation,
+ * no system call, and no waiting on the disk. The OS writes the pages back when it
+ * likes, and since they belong to the file and not to us, a crash loses nothing that
+ * was already recorded. Once the ring is full the oldest samples are overwritten.
+ *
+ * One thread records (the device thread). Any number of readers, in this process or
+ * another, can map the same file and read while it is being written. Each slot has
+ * its own sequence number, stored last, so a reader can tell a finished record from
+ * one that is being overwritten, and after a crash a half written record just reads
+ * as empty.
+ *
+ * Records are 64 bytes and 64 byte aligned, so one never straddles a disk sector.
+*/
+#ifndef QUANTUMRECORDER_H
+#define QUANTUMRECORDER_H
+
+#include <stdint.h>
+#include <atomic>
+
+#include <QString>
+#include <QFile>
+
+#include "quantumstatus.h"
+
+// Room for a long day at the fastest poll rate, 16MB
+#define QUANTUM_RECORDER_CAPACITY       262144
+
+/////////////////////////////////////////////////////////////
+/// One recorded sample. Just what is worth plotting, in as
+/// little room as it fits.
+struct QuantumRecord {
+    int64_t     nCaptureTime;           // Steady clock, nanoseconds. Only comparable within one run
+    int64_t     nWallTime;              // Milliseconds since the epoch, UTC
+    float       centerWavelength;
+    float       wingShift;
+    float       heater1Temperature;
+    float       heater2Temperature;
+    float       heater1PWM;
+    float       heater2PWM;
+    float       inputVoltage;
+    int16_t     nErrorCode;
+    int16_t     nHeater1PWMLimit;
+    int16_t     nHeater2PWMLimit;
+    int16_t     nCalibrationPotPos;
+    uint8_t     nFlags;                 // QUANTUM_RECORD_ON_BAND etc.
+    uint8_t     reserved[3];
+};
+
+#define QUANTUM_RECORD_ON_BAND          0x01
+#define QUANTUM_RECORD_DUAL_HEATERS     0x02
+
+void quantumRecordFromSnapshot(const QuantumStatusSnapshot& snapshot, QuantumRecord* pRecord);
+
+
+/////////////////////////////////////////////////////////////
+/// The ring file, for writing or reading
+class QuantumRecorder
+{
+public:
+    QuantumRecorder(void);
+    ~QuantumRecorder(void);
+
+    // Open for recording, picking up where the last run left off. A file that isn't
+    // ours, or has a different capacity, is started over.
+    bool open(const QString& qsFileName, uint32_t nCapacity = QUANTUM_RECORDER_CAPACITY);
+
+    // Open somebody else's recording, to read while they write
+    bool openReadOnly(const QString& qsFileName);
+
+    void close(void);
+    bool isOpen(void) const { return pHeader != nullptr; }
+
+    // Recording thread only
+    void append(const QuantumStatusSnapshot& snapshot);
+
+    // Samples are numbered from 1, and the last nCapacity of them are kept. The
+    // oldest can be overwritten while you are reading it, read() says so.
+    uint64_t getFirstSequence(void) const;
+    uint64_t getNextSequence(void) const;
+    uint32_t getCapacity(void) const { return nSlots; }
+
+    // False if that sample is gone (or not there yet)
+    bool read(uint64_t nSequence, QuantumRecord* pRecord) const;
+
+    // Oldest first, from nFrom on. Returns how many were copied, and where to pick up
+    // next time. Samples overwritten along the way are skipped.
+    int readRange(uint64_t nFrom, QuantumRecord* pRecords, int nMaxRecords, uint64_t* pNext) const;
+
+    // Where the recording for a filter lives, next to the settings. One file per
+    // serial number, so the history follows the filter from port to port.
+    static QString fileForSerial(const QString& qsSerialNumber);
+
+protected:
+    struct FileHeader;
+    struct Slot;
+
+    bool mapFile(QIODevice::OpenMode mode);
+    bool headerMatches(uint32_t nCapacity) const;
+    void startOver(uint32_t nCapacity);
+    void recoverHead(void);
+
+    QFile           file;
+    uchar           *pMapped = nullptr;
+    FileHeader      *pHeader = nullptr;
+    Slot            *pSlots = nullptr;
+    uint32_t        nSlots = 0;
+    bool            bWritable = false;
+};
+
+#endif // QUANTUMRECORDER_H
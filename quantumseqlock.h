@@ -0,0 +1,100 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* A sequence lock for publishing small plain data from one writer to any number of
+ * readers. The writer never waits on anybody. Readers never block the writer, they
+ * just try again if they happened to read while a write was going on, which is a
+ * handful of stores long.
+ *
+ * The data is kept as an array of atomic words, so nothing here is a data race even
+ * while a reader is looking at a half written value (it just gets thrown away).
+ * T has to be trivially copyable.
+*/
+#ifndef QUANTUMSEQLOCK_H
+#define QUANTUMSEQLOCK_H
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+template<class T>
+class QuantumSeqLock
+{
+public:
+    QuantumSeqLock(void) : nSequence(0) {
+        for(int i = 0; i < nWords; i++)
+            dataWords[i].store(0, std::memory_order_relaxed);
+    }
+
+    // Only ever call this from one thread
+    void write(const T& value) {
+        uint32_t words[nWords] = { 0 };
+        memcpy(words, &value, sizeof(T));
+
+        uint64_t nStart = nSequence.load(std::memory_order_relaxed);
+        nSequence.store(nStart + 1, std::memory_order_relaxed);    // Odd, write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for(int i = 0; i < nWords; i++)
+            dataWords[i].store(words[i], std::memory_order_relaxed);
+
+        nSequence.store(nStart + 2, std::memory_order_release);    // Even, all done
+    }
+
+    // Returns false if a write got in the way, pValue is left alone then
+    bool tryRead(T* pValue) const {
+        uint64_t nBefore = nSequence.load(std::memory_order_acquire);
+        if(nBefore & 1)
+            return false;
+
+        uint32_t words[nWords];
+        for(int i = 0; i < nWords; i++)
+            words[i] = dataWords[i].load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(nSequence.load(std::memory_order_relaxed) != nBefore)
+            return false;
+
+        memcpy(pValue, words, sizeof(T));
+        return true;
+    }
+
+    // Keep trying until we get a clean copy. The writer is never inside for long.
+    void read(T* pValue) const {
+        while(!tryRead(pValue))
+            ;
+    }
+
+    // Number of writes so far. Cheap way to see if anything is new.
+    uint64_t getVersion(void) const {
+        return nSequence.load(std::memory_order_acquire) / 2;
+    }
+
+protected:
+    enum { nWords = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t) };
+
+    std::atomic<uint64_t>   nSequence;
+    std::atomic<uint32_t>   dataWords[nWords];
+};
+
+#endif // QUANTUMSEQLOCK_H
@@ -0,0 +1,233 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* The shared memory status segment, for programs on the same machine that want the
+ * Quantum's status for every frame they take. Quantum Control writes each sample
+ * into a small POSIX shared memory segment, and a reader maps it and copies the
+ * latest out with a handful of loads. No socket, no system call per read.
+ *
+ * Layout, version 1. All numbers are native endian, floats IEEE single precision.
+ *
+ *   Header, offset 0
+ *     0  uint32 nMagic          QSHM_MAGIC once the segment is set up, 0 before
+ *     4  uint16 nVersion        QSHM_VERSION
+ *     6  uint16 nStatusOffset   Where the status starts, 64
+ *     8  uint32 nStatusSize     Bytes of status, 64
+ *    12  uint32 nWriterPid      Process that last wrote it
+ *    16  uint32 nState          1 while the writer has the Quantum, 0 when it has let go
+ *    20  ...                    Reserved, 0
+ *    60  uint32 nSequence       Odd while a sample is being written
+ *
+ *   Status, offset 64, laid out as QuantumShmStatus
+ *     0  uint64 nSample         Goes up by one every sample, starts at 1
+ *     8  int64  nCaptureTime    std::chrono::steady_clock, nanoseconds (CLOCK_MONOTONIC on Linux)
+ *    16  int64  nWallTime       Milliseconds since the epoch, UTC
+ *    24  float  fCenterWavelength
+ *    28  float  fWingshift
+ *    32  float  fTarget         Design wavelength plus wingshift, to the tenth below
+ *    36  float  fHeater1Temperature   Degrees F
+ *    40  float  fHeater2Temperature
+ *    44  float  fInputVoltage
+ *    48  float  fWavelengthRate Angstroms per second
+ *    52  float  fSecondsToOnBand  0 when on band, less than 0 when there's no telling
+ *    56  int32  nErrorCode
+ *    60  uint8  bOnBand
+ *    61  uint8  bDriftValid     The two drift fields mean something yet
+ *    62  uint16 nReserved
+ *
+ * nSequence is a sequence lock, the same as quantumseqlock.h. The writer makes it odd,
+ * writes the status, then makes it even. A reader reads it, copies the status, and
+ * reads it again. If it was odd or it changed, the copy is no good and it tries again.
+ * The writer never waits on readers.
+ *
+ * The segment outlives the writer, so a reader can stay mapped across Quantum Control
+ * restarting, it picks up where it left off. nState says whether anything is writing.
+ * A new version means a different layout, check it before trusting anything else.
+ *
+ * This file is the reader, and needs nothing else:
+ *
+ *     QuantumShmReader reader;
+ *     if(reader.open()) {
+ *         QuantumShmStatus status;
+ *         if(reader.read(&status) && status.bOnBand)
+ *             ...
+ *         }
+ *
+ * Link with -lrt on older Linux. POSIX only, there is no Windows version.
+*/
+#ifndef QUANTUMSHM_H
+#define QUANTUMSHM_H
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define QSHM_MAGIC              0x4D485351      // "QSHM"
+#define QSHM_VERSION            1
+#define QSHM_DEFAULT_NAME       "/quantumcontrol"
+#define QSHM_STATUS_OFFSET      64
+#define QSHM_STATUS_SIZE        64
+#define QSHM_SEGMENT_SIZE       (QSHM_STATUS_OFFSET + QSHM_STATUS_SIZE)
+#define QSHM_READ_TRIES         1000            // The writer is only ever inside for a few stores
+
+#define QSHM_STATE_CLOSED       0
+#define QSHM_STATE_LIVE         1
+
+/////////////////////////////////////////////////////////////
+/// One sample, as copied out of the segment
+struct QuantumShmStatus {
+    uint64_t    nSample;
+    int64_t     nCaptureTime;
+    int64_t     nWallTime;
+    float       fCenterWavelength;
+    float       fWingshift;
+    float       fTarget;
+    float       fHeater1Temperature;
+    float       fHeater2Temperature;
+    float       fInputVoltage;
+    float       fWavelengthRate;
+    float       fSecondsToOnBand;
+    int32_t     nErrorCode;
+    uint8_t     bOnBand;
+    uint8_t     bDriftValid;
+    uint16_t    nReserved;
+};
+
+/////////////////////////////////////////////////////////////
+/// The whole segment. The status is kept as atomic words so a reader
+/// looking at a half written sample is not a data race, it just throws
+/// the copy away.
+struct QuantumShmSegment {
+    uint32_t                nMagic;
+    uint16_t                nVersion;
+    uint16_t                nStatusOffset;
+    uint32_t                nStatusSize;
+    uint32_t                nWriterPid;
+    std::atomic<uint32_t>   nState;
+    uint32_t                reserved[10];
+    std::atomic<uint32_t>   nSequence;
+    std::atomic<uint32_t>   statusWords[QSHM_STATUS_SIZE / 4];
+};
+
+static_assert(sizeof(QuantumShmStatus) == QSHM_STATUS_SIZE, "QuantumShmStatus layout");
+static_assert(sizeof(QuantumShmSegment) == QSHM_SEGMENT_SIZE, "QuantumShmSegment layout");
+static_assert(sizeof(std::atomic<uint32_t>) == 4, "Atomics have to be plain words to share them");
+
+/////////////////////////////////////////////////////////////
+/// Copy out the latest status. False if a write got in the way.
+inline bool quantumShmTryRead(const QuantumShmSegment *pSegment, QuantumShmStatus *pStatus)
+{
+    uint32_t nBefore = pSegment->nSequence.load(std::memory_order_acquire);
+    if(nBefore & 1)
+        return false;
+
+    uint32_t words[QSHM_STATUS_SIZE / 4];
+    for(int i = 0; i < QSHM_STATUS_SIZE / 4; i++)
+        words[i] = pSegment->statusWords[i].load(std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(pSegment->nSequence.load(std::memory_order_relaxed) != nBefore)
+        return false;
+
+    memcpy(pStatus, words, sizeof(QuantumShmStatus));
+    return true;
+}
+
+#if !defined(_WIN32)
+
+/////////////////////////////////////////////////////////////
+/// Maps a segment read only. Open it once and read it as often
+/// as you like, reading is just loads.
+class QuantumShmReader
+{
+public:
+    QuantumShmReader(void) {}
+    ~QuantumShmReader(void) { close(); }
+
+    // False if there's no such segment, or it's not a layout we know
+    bool open(const char *szName = QSHM_DEFAULT_NAME) {
+        close();
+
+        int hFile = shm_open(szName, O_RDONLY, 0);
+        if(hFile < 0)
+            return false;
+
+        void *pMap = mmap(nullptr, QSHM_SEGMENT_SIZE, PROT_READ, MAP_SHARED, hFile, 0);
+        ::close(hFile);
+        if(pMap == MAP_FAILED)
+            return false;
+
+        pSegment = static_cast<const QuantumShmSegment*>(pMap);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(pSegment->nMagic != QSHM_MAGIC || pSegment->nVersion != QSHM_VERSION ||
+           pSegment->nStatusOffset != QSHM_STATUS_OFFSET || pSegment->nStatusSize != QSHM_STATUS_SIZE) {
+            close();
+            return false;
+            }
+
+        return true;
+    }
+
+    void close(void) {
+        if(pSegment != nullptr)
+            munmap(const_cast<QuantumShmSegment*>(pSegment), QSHM_SEGMENT_SIZE);
+        pSegment = nullptr;
+    }
+
+    bool isOpen(void) const { return pSegment != nullptr; }
+
+    // Somebody is writing it
+    bool isLive(void) const {
+        return pSegment != nullptr && pSegment->nState.load(std::memory_order_acquire) == QSHM_STATE_LIVE;
+    }
+
+    // Cheap way to see if there's a new sample since the last look
+    uint32_t getSequence(void) const {
+        return pSegment ? pSegment->nSequence.load(std::memory_order_acquire) : 0;
+    }
+
+    // False if it's not open, or nothing has been written yet
+    bool read(QuantumShmStatus *pStatus) const {
+        if(pSegment == nullptr)
+            return false;
+
+        for(int i = 0; i < QSHM_READ_TRIES; i++)
+            if(quantumShmTryRead(pSegment, pStatus))
+                return pStatus->nSample != 0;
+
+        return false;
+    }
+
+protected:
+    const QuantumShmSegment *pSegment = nullptr;
+};
+
+#endif // !_WIN32
+
+#endif // QUANTUMSHM_H
@@ -0,0 +1,124 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+#include "quantumshmwriter.h"
+
+#if !defined(_WIN32)
+#include <sys/stat.h>
+#endif
+
+
+///////////////////////////////////////////////////////////////////////
+// The magic goes in last, so a reader never takes a half set up segment
+// for a good one. A sequence left odd by a writer that died mid sample is
+// made even again, and it keeps counting from there so readers who were
+// watching it see the next sample as new.
+bool QuantumShmWriter::open(const char *szName)
+{
+    close();
+
+#if defined(_WIN32)
+    (void)szName;
+    return false;
+#else
+    int hFile = shm_open(szName, O_CREAT | O_RDWR, 0644);
+    if(hFile < 0)
+        return false;
+
+    if(ftruncate(hFile, QSHM_SEGMENT_SIZE) != 0) {
+        ::close(hFile);
+        return false;
+        }
+
+    void *pMap = mmap(nullptr, QSHM_SEGMENT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, hFile, 0);
+    ::close(hFile);
+    if(pMap == MAP_FAILED)
+        return false;
+
+    pSegment = static_cast<QuantumShmSegment*>(pMap);
+    pSegment->nMagic = 0;
+    pSegment->nVersion = QSHM_VERSION;
+    pSegment->nStatusOffset = QSHM_STATUS_OFFSET;
+    pSegment->nStatusSize = QSHM_STATUS_SIZE;
+    pSegment->nWriterPid = uint32_t(getpid());
+    memset(pSegment->reserved, 0, sizeof(pSegment->reserved));
+
+    uint32_t nSequence = pSegment->nSequence.load(std::memory_order_relaxed);
+    if(nSequence & 1)
+        pSegment->nSequence.store(nSequence + 1, std::memory_order_release);
+
+    pSegment->nState.store(QSHM_STATE_LIVE, std::memory_order_release);
+    pSegment->nMagic = QSHM_MAGIC;
+    return true;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////
+void QuantumShmWriter::close(void)
+{
+#if !defined(_WIN32)
+    if(pSegment == nullptr)
+        return;
+
+    pSegment->nState.store(QSHM_STATE_CLOSED, std::memory_order_release);
+    munmap(pSegment, QSHM_SEGMENT_SIZE);
+    pSegment = nullptr;
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////
+// Same as QuantumSeqLock::write(), into the segment
+void QuantumShmWriter::publish(const QuantumStatusSnapshot& snapshot)
+{
+    if(pSegment == nullptr)
+        return;
+
+    QuantumShmStatus status;
+    memset(&status, 0, sizeof(status));
+    status.nSample = snapshot.nSequence;
+    status.nCaptureTime = snapshot.nCaptureTime;
+    status.nWallTime = snapshot.nWallTime;
+    status.fCenterWavelength = snapshot.status.centerWavelength;
+    status.fWingshift = snapshot.status.wingShift;
+    status.fTarget = snapshot.drift.fTarget;
+    status.fHeater1Temperature = snapshot.status.heater1Temprature;
+    status.fHeater2Temperature = snapshot.status.heater2Temperature;
+    status.fInputVoltage = snapshot.status.inputVoltage;
+    status.fWavelengthRate = snapshot.drift.fWavelengthRate;
+    status.fSecondsToOnBand = snapshot.drift.fSecondsToOnBand;
+    status.nErrorCode = snapshot.status.nErrorCode;
+    status.bOnBand = snapshot.status.bOnBand ? 1 : 0;
+    status.bDriftValid = snapshot.drift.bValid ? 1 : 0;
+
+    uint32_t words[QSHM_STATUS_SIZE / 4];
+    memcpy(words, &status, sizeof(status));
+
+    uint32_t nStart = pSegment->nSequence.load(std::memory_order_relaxed);
+    pSegment->nSequence.store(nStart + 1, std::memory_order_relaxed);   // Odd, write in progress
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for(int i = 0; i < QSHM_STATUS_SIZE / 4; i++)
+        pSegment->statusWords[i].store(words[i], std::memory_order_relaxed);
+
+    pSegment->nSequence.store(nStart + 2, std::memory_order_release);   // Even, all done
+}
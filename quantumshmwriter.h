@@ -0,0 +1,58 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* Writes each status sample into the shared memory segment described in quantumshm.h.
+ * Owned by the device, and only touched on its I/O thread. A sample is a few dozen
+ * stores into mapped memory, no system call.
+ *
+ * The segment is left behind on close, marked as closed, so readers that have it
+ * mapped carry on seamlessly when Quantum Control starts again with the same name.
+*/
+#ifndef QUANTUMSHMWRITER_H
+#define QUANTUMSHMWRITER_H
+
+#include "quantumshm.h"
+#include "quantumstatus.h"
+
+class QuantumShmWriter
+{
+public:
+    QuantumShmWriter(void) {}
+    ~QuantumShmWriter(void) { close(); }
+
+    // Creates it, or takes over the one that's there. False where there is no POSIX
+    // shared memory, or it couldn't be made.
+    bool open(const char *szName);
+    void close(void);
+    bool isOpen(void) const { return pSegment != nullptr; }
+
+    void publish(const QuantumStatusSnapshot& snapshot);
+
+protected:
+    QuantumShmSegment   *pSegment = nullptr;
+
+    QuantumShmWriter(const QuantumShmWriter&) = delete;
+    QuantumShmWriter& operator=(const QuantumShmWriter&) = delete;
+};
+
+#endif // QUANTUMSHMWRITER_H
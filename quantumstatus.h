@@ -0,0 +1,80 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* The dynamic status of the Quantum, as reported by the GI (Get Info) command.
+ * This is plain data so it can be copied around freely, and has no Qt dependencies.
+ * Each sample is published as a snapshot, with when it was taken and the drift
+ * worked out from it.
+*/
+#ifndef QUANTUMSTATUS_H
+#define QUANTUMSTATUS_H
+
+#include <stdint.h>
+
+/////////////////////////////////////////////////////////////
+/// Device status, updated by device thread.
+///
+struct QuantumStatus {
+    int     nErrorCode;
+    float   centerWavelength;
+    float   wingShift;
+    float   heater1PMW;
+    int     heater1PMWLimit;
+    float   heater1Temprature;
+    float   heater2Temperature;
+    float   inputVoltage;
+    int     calibrationPotPos;
+    float   heater2PMW;
+    int     heater2PMWLimit;
+
+    int32_t nBootCount;
+    int32_t nRunMinutes;
+
+    bool    bOnBand;
+    bool    bDualHeaters;
+};
+
+/////////////////////////////////////////////////////////////
+/// How fast things are moving, and when it should be on band. Worked out
+/// on the device thread from every sample, see quantumdrift.h.
+struct QuantumDrift {
+    float   fWavelengthRate;    // Angstroms per second
+    float   fTemperatureRate;   // Degrees (heater 1) per second
+    float   fTarget;            // Wavelength it's heading for
+    float   fSecondsToOnBand;   // 0 when on band, less than 0 when there's no telling
+    int64_t nOnBandTime;        // Same clock as nCaptureTime, 0 when there's no telling
+    bool    bValid;             // Enough samples to go on yet
+};
+
+/////////////////////////////////////////////////////////////
+/// One published sample. The sequence number goes up by one with every
+/// sample, so a reader can tell if it has seen this one already.
+struct QuantumStatusSnapshot {
+    QuantumStatus   status;
+    uint64_t        nSequence;          // Sample number, starts at 1
+    int64_t         nCaptureTime;       // Steady (monotonic) clock, nanoseconds
+    int64_t         nWallTime;          // Milliseconds since the epoch, UTC
+    QuantumDrift    drift;              // As of this sample
+};
+
+#endif // QUANTUMSTATUS_H
@@ -0,0 +1,192 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "quantumtrace.h"
+
+/////////////////////////////////////////////////////////////
+/// One recorded event, written out as JSON at the end
+struct QuantumTraceEvent {
+    const char* szName;
+    char        cPhase;         // X complete, b/e async begin/end
+    int         nThread;
+    int64_t     nStart;         // Nanoseconds, steady clock
+    int64_t     nDuration;
+    uint64_t    nId;            // Async spans only
+};
+
+std::atomic<bool> quantumTraceOn(false);
+
+static std::mutex                           traceMutex;
+static std::vector<QuantumTraceEvent>       traceEvents;
+static std::vector<std::pair<int, std::string>> threadNames;
+static std::string                          traceFileName;
+static size_t                               nTraceLimit = 0;
+static uint64_t                             nTraceDropped = 0;
+static int64_t                              nTraceOrigin = 0;
+static std::atomic<int>                     nNextThread(1);
+static thread_local int                     nThisThread = 0;
+
+
+///////////////////////////////////////////////////////////////////////
+int64_t quantumTraceNow(void)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Small numbers read better than real thread ids in a trace viewer
+static int traceThread(void)
+{
+    if(nThisThread == 0)
+        nThisThread = nNextThread.fetch_add(1);
+
+    return nThisThread;
+}
+
+///////////////////////////////////////////////////////////////////////
+bool quantumTraceStart(const char* szFileName, size_t nMaxEvents)
+{
+    std::lock_guard<std::mutex> lock(traceMutex);
+    if(quantumTraceOn.load())
+        return false;
+
+    traceFileName = szFileName;
+    traceEvents.clear();
+    traceEvents.reserve(nMaxEvents < 65536 ? nMaxEvents : 65536);
+    nTraceLimit = nMaxEvents;
+    nTraceDropped = 0;
+    nTraceOrigin = quantumTraceNow();
+    quantumTraceOn.store(true);
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////
+void quantumTraceThreadName(const char* szName)
+{
+    int nThread = traceThread();
+
+    std::lock_guard<std::mutex> lock(traceMutex);
+    for(size_t i = 0; i < threadNames.size(); i++)
+        if(threadNames[i].first == nThread) {
+            threadNames[i].second = szName;
+            return;
+            }
+
+    threadNames.push_back(std::make_pair(nThread, std::string(szName)));
+}
+
+///////////////////////////////////////////////////////////////////////
+static void recordEvent(const QuantumTraceEvent& event)
+{
+    std::lock_guard<std::mutex> lock(traceMutex);
+    if(!quantumTraceOn.load(std::memory_order_relaxed))
+        return;
+
+    if(traceEvents.size() >= nTraceLimit) {
+        nTraceDropped++;
+        return;
+        }
+
+    traceEvents.push_back(event);
+}
+
+void quantumTraceComplete(const char* szName, int64_t nStart, int64_t nEnd)
+{
+    QuantumTraceEvent event = { szName, 'X', traceThread(), nStart, nEnd - nStart, 0 };
+    recordEvent(event);
+}
+
+void quantumTraceAsync(const char* szName, char cPhase, uint64_t nId)
+{
+    QuantumTraceEvent event = { szName, cPhase, traceThread(), quantumTraceNow(), 0, nId };
+    recordEvent(event);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Names are ours, and plain, but a quote or backslash would break the file
+static void writeJsonString(FILE* pFile, const char* szText)
+{
+    fputc('"', pFile);
+    for(const char* p = szText; *p; p++) {
+        if(*p == '"' || *p == '\\')
+            fputc('\\', pFile);
+        if(uint8_t(*p) >= 0x20)
+            fputc(*p, pFile);
+        }
+    fputc('"', pFile);
+}
+
+bool quantumTraceStop(void)
+{
+    std::lock_guard<std::mutex> lock(traceMutex);
+    if(!quantumTraceOn.load())
+        return false;
+
+    quantumTraceOn.store(false);
+
+    FILE* pFile = fopen(traceFileName.c_str(), "w");
+    if(pFile == nullptr)
+        return false;
+
+    fprintf(pFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(pFile, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Quantum Control\"}}");
+
+    for(size_t i = 0; i < threadNames.size(); i++) {
+        fprintf(pFile, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", threadNames[i].first);
+        writeJsonString(pFile, threadNames[i].second.c_str());
+        fprintf(pFile, "}}");
+        }
+
+    // Timestamps are in microseconds, from when tracing started
+    for(size_t i = 0; i < traceEvents.size(); i++) {
+        const QuantumTraceEvent& event = traceEvents[i];
+        fprintf(pFile, ",\n{\"name\":");
+        writeJsonString(pFile, event.szName);
+        fprintf(pFile, ",\"cat\":\"quantum\",\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%.3f",
+                event.cPhase, event.nThread, double(event.nStart - nTraceOrigin) / 1000.0);
+
+        if(event.cPhase == 'X')
+            fprintf(pFile, ",\"dur\":%.3f", double(event.nDuration) / 1000.0);
+        else
+            fprintf(pFile, ",\"id\":\"0x%llx\"", (unsigned long long)event.nId);
+
+        fprintf(pFile, "}");
+        }
+
+    fprintf(pFile, "\n],\"otherData\":{\"droppedEvents\":\"%llu\"}}\n", (unsigned long long)nTraceDropped);
+
+    bool bOk = (ferror(pFile) == 0);
+    fclose(pFile);
+
+    traceEvents.clear();
+    traceEvents.shrink_to_fit();
+    return bOk;
+}
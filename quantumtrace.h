@@ -0,0 +1,111 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* Trace event output, for looking at where the time goes in chrome://tracing or
+ * ui.perfetto.dev. Set QUANTUM_TRACE=<file.json> in the environment and every span
+ * below is recorded until the program exits, then written out in the trace event
+ * JSON format.
+ *
+ *   QUANTUM_TRACE_SCOPE("parse");                  A span for the rest of this scope
+ *   QUANTUM_TRACE_ASYNC_BEGIN("GI", id);           A span that ends somewhere else,
+ *   QUANTUM_TRACE_ASYNC_END("GI", id);             like waiting on a reply
+ *
+ * Names must be string literals (or anything else that lives forever), they are not
+ * copied. When tracing is off, each of these is one relaxed atomic load and a branch.
+ * Build with QUANTUM_NO_TRACE defined and they are gone completely.
+ *
+ * No Qt in here.
+*/
+#ifndef QUANTUMTRACE_H
+#define QUANTUMTRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Stop recording after this many events, so a forgotten trace can't eat all the memory
+#define QUANTUM_TRACE_MAX_EVENTS    (1 << 20)
+
+// Start recording, the file is written by quantumTraceStop(). False if already going.
+bool quantumTraceStart(const char* szFileName, size_t nMaxEvents = QUANTUM_TRACE_MAX_EVENTS);
+
+// Stop, and write out everything recorded. False if the file can't be written.
+bool quantumTraceStop(void);
+
+// Name the calling thread in the trace. Cheap, and fine to call more than once.
+void quantumTraceThreadName(const char* szName);
+
+#ifndef QUANTUM_NO_TRACE
+
+extern std::atomic<bool> quantumTraceOn;
+
+inline bool quantumTraceEnabled(void) { return quantumTraceOn.load(std::memory_order_relaxed); }
+
+// Steady clock, nanoseconds
+int64_t quantumTraceNow(void);
+
+// Record one event. Use the macros instead.
+void quantumTraceComplete(const char* szName, int64_t nStart, int64_t nEnd);
+void quantumTraceAsync(const char* szName, char cPhase, uint64_t nId);
+
+/////////////////////////////////////////////////////////////
+/// Span from here to the end of the scope
+class QuantumTraceScope
+{
+public:
+    explicit QuantumTraceScope(const char* szSpanName)
+        : szName(szSpanName), nStart(quantumTraceEnabled() ? quantumTraceNow() : -1) {}
+
+    ~QuantumTraceScope(void) {
+        if(nStart >= 0)
+            quantumTraceComplete(szName, nStart, quantumTraceNow());
+    }
+
+private:
+    const char* szName;
+    int64_t     nStart;
+};
+
+#define QUANTUM_TRACE_JOIN2(a, b)   a##b
+#define QUANTUM_TRACE_JOIN(a, b)    QUANTUM_TRACE_JOIN2(a, b)
+
+#define QUANTUM_TRACE_SCOPE(szName) \
+    QuantumTraceScope QUANTUM_TRACE_JOIN(quantumTraceScope, __LINE__)(szName)
+
+#define QUANTUM_TRACE_ASYNC_BEGIN(szName, nId) \
+    do { if(quantumTraceEnabled()) quantumTraceAsync(szName, 'b', uint64_t(nId)); } while(0)
+
+#define QUANTUM_TRACE_ASYNC_END(szName, nId) \
+    do { if(quantumTraceEnabled()) quantumTraceAsync(szName, 'e', uint64_t(nId)); } while(0)
+
+#else
+
+inline bool quantumTraceEnabled(void) { return false; }
+
+#define QUANTUM_TRACE_SCOPE(szName)             do { } while(0)
+#define QUANTUM_TRACE_ASYNC_BEGIN(szName, nId)  do { } while(0)
+#define QUANTUM_TRACE_ASYNC_END(szName, nId)    do { } while(0)
+
+#endif // QUANTUM_NO_TRACE
+
+#endif // QUANTUMTRACE_H
@@ -25,25 +25,33 @@ SOFTWARE
 #include <QTreeWidget>
 #include <QStringList>
 #include <QMessageBox>
+#include <QApplication>
 
 #include "dlgabout.h"
 #include "serialchooser.h"
 #include "ui_serialchooser.h"
 
 
-SerialChooser::SerialChooser(QWidget *parent) :
+SerialChooser::SerialChooser(QWidget *parent, QuantumDeviceManager *pManager) :
     QDialog(parent),
     ui(new Ui::SerialChooser)
 {
+    pDeviceManager = pManager;
+
     ui->setupUi(this);
     setWindowFlags(Qt::Widget);
-    ui->pushButtonFind->hide();
+
+    discoveryTimer.setSingleShot(true);
+    connect(&discoveryTimer, SIGNAL(timeout()), this, SLOT(discoveryTimedOut()));
 
     connect(ui->pushButtonAbout, SIGNAL(pressed()), this, SLOT(pressedAbout()));
     connect(ui->treeWidget, SIGNAL(itemSelectionChanged()), this, SLOT(itemSelected()));
     connect(ui->treeWidget, SIGNAL(itemDoubleClicked(QTreeWidgetItem*, int)), this, SLOT(itemDoubleClicked(QTreeWidgetItem*, int)));
     connect(ui->pushButtonRefresh, SIGNAL(pressed()), this, SLOT(refreshPortList()));
     connect(ui->pushButtonUseSelected, SIGNAL(pressed()), this, SLOT(attemptOneConnection()));
+    connect(ui->pushButtonFind, SIGNAL(pressed()), this, SLOT(pressedFind()));
+    connect(pDeviceManager, SIGNAL(connectedToQuantum(QuantumDevice*)), this, SLOT(gotConnected(QuantumDevice*)));
+    connect(pDeviceManager, SIGNAL(couldNotOpen(QuantumDevice*)), this, SLOT(failedConnection(QuantumDevice*)));
 
     refreshPortList();
 
@@ -52,6 +60,7 @@ SerialChooser::SerialChooser(QWidget *parent) :
 
 SerialChooser::~SerialChooser()
 {
+    qDeleteAll(probeList);
     delete ui;
 }
 
@@ -74,8 +83,8 @@ void SerialChooser::refreshPortList(void)
     listOfPorts = QSerialPortInfo::availablePorts();
 
     ui->treeWidget->clear();
-    ui->treeWidget->setColumnCount(3);
-    QStringList headers = { "Port Name", "Description", "Manufacturer" };
+    ui->treeWidget->setColumnCount(4);
+    QStringList headers = { "Port Name", "Description", "Manufacturer", "Quantum" };
     ui->treeWidget->setHeaderLabels(headers);
 
     for(int i = 0; i < listOfPorts.size(); i++) {
@@ -111,6 +120,125 @@ void SerialChooser::refreshPortList(void)
     ui->pushButtonUseSelected->setEnabled(false);
     }
 
+///////////////////////////////////////////////////////////////////////
+// Check every port that isn't busy, all at the same time. Each one gets a quick GI,
+// and the whole search has a time limit, so a port that never answers can only
+// cost us that much.
+void SerialChooser::pressedFind(void)
+{
+    if(!probeList.isEmpty())
+        return;
+
+    refreshPortList();
+
+    for(int i = 0; i < listOfPorts.size(); i++) {
+        if(listOfPorts[i].isBusy())
+            continue;
+
+        QuantumProbe *pProbe = new QuantumProbe(nullptr, listOfPorts[i], i);
+        connect(pProbe, SIGNAL(finished(QuantumProbe*)), this, SLOT(probeFinished(QuantumProbe*)), Qt::QueuedConnection);
+        probeList.append(pProbe);
+        ui->treeWidget->topLevelItem(i)->setText(3, tr("Checking..."));
+        }
+
+    if(probeList.isEmpty()) {
+        QMessageBox msgBox;
+        msgBox.setText(tr("There are no free serial ports to check"));
+        msgBox.exec();
+        return;
+        }
+
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    ui->pushButtonFind->setEnabled(false);
+    ui->pushButtonRefresh->setEnabled(false);
+    ui->pushButtonUseSelected->setEnabled(false);
+
+    for(int i = 0; i < probeList.size(); i++)
+        probeList[i]->start();
+
+    discoveryTimer.start(QUANTUM_DISCOVERY_BUDGET);
+}
+
+///////////////////////////////////////////////////////////////////////
+// One port has had its say. When they all have, we're done. The signal is
+// queued, so it can arrive after the search already timed out, or from an
+// earlier search, and then it has nothing to do with us.
+void SerialChooser::probeFinished(QuantumProbe *pProbe)
+{
+    if(!probeList.contains(pProbe))
+        return;
+
+    for(int i = 0; i < probeList.size(); i++)
+        if(!probeList[i]->isFinished())
+            return;
+
+    discoveryFinished();
+}
+
+///////////////////////////////////////////////////////////////////////
+void SerialChooser::discoveryTimedOut(void)
+{
+    if(probeList.isEmpty())
+        return;
+
+    for(int i = 0; i < probeList.size(); i++)
+        probeList[i]->abort();
+
+    discoveryFinished();
+}
+
+///////////////////////////////////////////////////////////////////////
+// Show what we found. If there is exactly one, and the user wants it,
+// go ahead and connect to it.
+void SerialChooser::discoveryFinished(void)
+{
+    discoveryTimer.stop();
+    QApplication::restoreOverrideCursor();
+    ui->pushButtonFind->setEnabled(true);
+    ui->pushButtonRefresh->setEnabled(true);
+
+    QTreeWidgetItem *pFoundItem = nullptr;
+    int nFound = 0;
+    for(int i = 0; i < probeList.size(); i++) {
+        QuantumProbe *pProbe = probeList[i];
+        QTreeWidgetItem *pItem = ui->treeWidget->topLevelItem(pProbe->getPortIndex());
+
+        if(!pProbe->isQuantum()) {
+            pItem->setText(3, QString());
+            continue;
+            }
+
+        QString found = pProbe->getModelString();
+        found += " SN:";
+        found += pProbe->getSerialNumber();
+        found += " ";
+        found += pProbe->getFirmwareVersion();
+        pItem->setText(3, found);
+
+        pFoundItem = pItem;
+        nFound++;
+        }
+
+    // They may still be getting events, let them finish first
+    for(int i = 0; i < probeList.size(); i++)
+        probeList[i]->deleteLater();
+    probeList.clear();
+
+    ui->treeWidget->resizeColumnToContents(3);
+
+    if(nFound == 0) {
+        QMessageBox msgBox;
+        msgBox.setText(tr("No Quantum was found on any serial port"));
+        msgBox.exec();
+        return;
+        }
+
+    ui->treeWidget->setCurrentItem(pFoundItem);
+
+    if(nFound == 1 && ui->checkBoxAutoConnect->isChecked())
+        attemptOneConnection();
+}
+
 ///////////////////////////////////////////////////////////////////////
 // Go try a connection with the selected device
 void SerialChooser::attemptOneConnection(void)
@@ -121,14 +249,20 @@ void SerialChooser::attemptOneConnection(void)
     Q_ASSERT(iItem >= 0);
 
     QApplication::setOverrideCursor(Qt::WaitCursor);
-    QuantumDevice *pConnect = new QuantumDevice(nullptr, listOfPorts[iItem]);
 
-    connect(pConnect, SIGNAL(connectedToQuantum(QuantumDevice*)), this, SLOT(gotConnected(QuantumDevice*)), Qt::QueuedConnection);
-    connect(pConnect, SIGNAL(couldNotOpen(QuantumDevice*)), this, SLOT(failedConnection(QuantumDevice*)), Qt::QueuedConnection);
-    pConnect->start();
+    // The manager tells us how it goes
+    pDeviceManager->addDevice(listOfPorts[iItem]);
 
 }
 
+///////////////////////////////////////////////////////////////////////
+// Port given on the command line. Same as picking it, without the list.
+void SerialChooser::connectToPort(const QString& qsPort)
+{
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    pDeviceManager->addDevice(qsPort);
+}
+
 void SerialChooser::itemDoubleClicked(QTreeWidgetItem *item, int column)
 { 
     (void)item;
@@ -153,14 +287,10 @@ void SerialChooser::failedConnection(QuantumDevice* pDevice)
 {
     QApplication::restoreOverrideCursor();
 
-    // Tell the threads event loop to quit
-    pDevice->quit();
+    // Done with it
+    pDeviceManager->removeDevice(pDevice);
 
     QMessageBox msgBox;
     msgBox.setText(tr("Could not connect to a Quantum on the selected serial port"));
     msgBox.exec();
-
-    // Delete it, but make sure event loop has stopped
-    pDevice->wait();
-    delete pDevice;
 }
@@ -35,8 +35,14 @@ SOFTWARE
 #include <QSerialPortInfo>
 #include <QSerialPort>
 #include <QTreeWidgetItem>
+#include <QTimer>
 
 #include "quantumdevice.h"
+#include "quantumdevicemanager.h"
+#include "quantumprobe.h"
+
+// Longest we will spend looking for a Quantum on all ports (milliseconds)
+#define QUANTUM_DISCOVERY_BUDGET    3000
 
 namespace Ui {
 class SerialChooser;
@@ -47,19 +53,30 @@ class SerialChooser : public QDialog
     Q_OBJECT
 
 public:
-    explicit SerialChooser(QWidget *parent);
+    explicit SerialChooser(QWidget *parent, QuantumDeviceManager *pManager);
     ~SerialChooser();
 
+    // Skip the list, connect to this port (name or path) straight away
+    void connectToPort(const QString& qsPort);
+
 private:
     Ui::SerialChooser   *ui;
+    QuantumDeviceManager *pDeviceManager = nullptr;
 
     QList<QSerialPortInfo> listOfPorts;
+    QList<QuantumProbe*>   probeList;          // Ports being checked right now
+    QTimer                 discoveryTimer;     // Time's up for all of them
+
+    void discoveryFinished(void);
 
 public Q_SLOTS:
     void pressedAbout(void);
     void itemSelected(void);
     void refreshPortList(void);
     void attemptOneConnection(void);
+    void pressedFind(void);
+    void probeFinished(QuantumProbe *pProbe);
+    void discoveryTimedOut(void);
     void itemDoubleClicked(QTreeWidgetItem *item, int column);
 
     void gotConnected(QuantumDevice* pDevice);
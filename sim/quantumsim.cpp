@@ -0,0 +1,153 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* Quantum simulator on a pseudo terminal. Point QuantumControl (or anything else that
+ * talks to a Quantum) at the pty this prints, and it will think there is a filter there.
+ * Linux and macOS only, there are no ptys on Windows.
+ *
+ * usage: quantumsim [options]
+ *   --old              Old firmware (v1.25, decimal). Default is v2.00, hex.
+ *   --dual             Two heaters
+ *   --latency <ms>     Wait this long before starting a reply (default 5)
+ *   --jitter <ms>      Plus up to this much more, at random (default 0)
+ *   --baud <rate>      Send replies no faster than this (default 9600, 0 for no limit)
+ *   --drop <p>         Lose each byte with this probability (default 0)
+ *   --drop-reply <p>   Lose whole replies with this probability (default 0)
+ *   --no-terminator    Leave the \r\n off replies, like some firmware does
+ *   --speed <x>        Run the thermal model this many times faster than real time
+ *   --warm             Start at operating temperature, not ambient
+ *   --ambient <C>      Air temperature (default 20)
+ *   --serial <text>    Serial number to report
+ *   --seed <n>         Random seed, so drops and jitter can be repeated
+ *   --link <path>      Also make a symlink to the pty here (e.g. /tmp/ttyQuantum)
+ *   --verbose          Print every command and reply
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "quantumsimulator.h"
+#include "quantumsimpty.h"
+
+static volatile sig_atomic_t bQuit = 0;
+
+static void onSignal(int)
+{
+    bQuit = 1;
+}
+
+int main(int argc, char *argv[])
+{
+    QuantumSimSettings settings;
+    QuantumSimLink link;
+    bool bTerminator = true;
+    bool bWarm = false;
+    const char* szLink = nullptr;
+
+    for(int i = 1; i < argc; i++) {
+        const char* szArg = argv[i];
+        const char* szValue = (i + 1 < argc) ? argv[i+1] : nullptr;
+
+        if(strcmp(szArg, "--old") == 0)
+            settings.bOldFirmware = true;
+        else if(strcmp(szArg, "--dual") == 0)
+            settings.bDualHeaters = true;
+        else if(strcmp(szArg, "--no-terminator") == 0)
+            bTerminator = false;
+        else if(strcmp(szArg, "--warm") == 0)
+            bWarm = true;
+        else if(strcmp(szArg, "--verbose") == 0)
+            link.bVerbose = true;
+        else if(szValue == nullptr) {
+            fprintf(stderr, "Unknown option, or missing value: %s\n", szArg);
+            return 1;
+            }
+        else {
+            i++;
+            if(strcmp(szArg, "--latency") == 0)
+                link.fLatency = atof(szValue);
+            else if(strcmp(szArg, "--jitter") == 0)
+                link.fJitter = atof(szValue);
+            else if(strcmp(szArg, "--baud") == 0)
+                link.nBaudRate = atoi(szValue);
+            else if(strcmp(szArg, "--drop") == 0)
+                link.fDropRate = atof(szValue);
+            else if(strcmp(szArg, "--drop-reply") == 0)
+                link.fReplyDropRate = atof(szValue);
+            else if(strcmp(szArg, "--speed") == 0)
+                link.fSpeed = atof(szValue);
+            else if(strcmp(szArg, "--ambient") == 0)
+                settings.fAmbient = settings.fStartTemp = atof(szValue);
+            else if(strcmp(szArg, "--serial") == 0)
+                settings.szSerialNumber = szValue;
+            else if(strcmp(szArg, "--seed") == 0)
+                link.nSeed = uint32_t(strtoul(szValue, nullptr, 10));
+            else if(strcmp(szArg, "--link") == 0)
+                szLink = szValue;
+            else {
+                fprintf(stderr, "Unknown option: %s\n", szArg);
+                return 1;
+                }
+            }
+        }
+
+    if(bWarm)
+        settings.fStartTemp = QUANTUM_SIM_DESIGN_TEMP;
+
+    QuantumSimulator simulator(settings);
+    simulator.setTerminator(bTerminator);
+
+    QuantumSimPty pty(simulator, link);
+    if(!pty.open())
+        return 1;
+
+    if(szLink != nullptr) {
+        unlink(szLink);
+        if(symlink(pty.getSlaveName(), szLink) != 0) {
+            perror(szLink);
+            return 1;
+            }
+        }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    printf("%s\n", pty.getSlaveName());
+    fflush(stdout);
+    fprintf(stderr, "Simulating a Quantum, firmware %s, %s heater%s, on %s\n",
+            settings.bOldFirmware ? "v1.25" : "v2.00", settings.bDualHeaters ? "two" : "one",
+            settings.bDualHeaters ? "s" : "", pty.getSlaveName());
+
+    while(!bQuit)
+        pty.service();
+
+    if(szLink != nullptr)
+        unlink(szLink);
+
+    fprintf(stderr, "%ld commands, %ld replies, %ld bytes dropped\n",
+            pty.getCommandCount(), pty.getReplyCount(), pty.getDroppedCount());
+    return 0;
+}
@@ -0,0 +1,15 @@
+# Quantum simulator on a pseudo terminal (Linux and macOS). No Qt needed.
+# ./quantumsim --link /tmp/ttyQuantum, then connect to /tmp/ttyQuantum.
+
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= qt app_bundle
+
+SOURCES += \
+    quantumsim.cpp \
+    quantumsimpty.cpp \
+    quantumsimulator.cpp
+
+HEADERS += \
+    quantumsimpty.h \
+    quantumsimulator.h
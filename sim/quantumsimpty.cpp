@@ -0,0 +1,222 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <chrono>
+
+#include "quantumsimpty.h"
+
+
+///////////////////////////////////////////////////////////////////////
+static double secondsNow(void)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+///////////////////////////////////////////////////////////////////////
+QuantumSimPty::QuantumSimPty(QuantumSimulator& quantumSimulator, const QuantumSimLink& simLink)
+    : simulator(quantumSimulator), link(simLink)
+{
+    nRandom = (link.nSeed != 0) ? link.nSeed : 1;
+}
+
+QuantumSimPty::~QuantumSimPty(void)
+{
+    if(nSlave >= 0)
+        close(nSlave);
+
+    if(nMaster >= 0)
+        close(nMaster);
+}
+
+///////////////////////////////////////////////////////////////////////
+bool QuantumSimPty::open(void)
+{
+    nMaster = posix_openpt(O_RDWR | O_NOCTTY);
+    if(nMaster < 0 || grantpt(nMaster) != 0 || unlockpt(nMaster) != 0) {
+        perror("posix_openpt");
+        return false;
+        }
+
+    const char* szSlave = ptsname(nMaster);
+    if(szSlave == nullptr) {
+        perror("ptsname");
+        return false;
+        }
+    snprintf(szSlaveName, sizeof(szSlaveName), "%s", szSlave);
+
+    // Hold the other end open ourselves, or every client that closes it takes the pty
+    // down with it. Raw, so nothing gets echoed or translated before a client sets it up.
+    nSlave = ::open(szSlaveName, O_RDWR | O_NOCTTY);
+    if(nSlave < 0) {
+        perror(szSlaveName);
+        return false;
+        }
+
+    struct termios tio;
+    tcgetattr(nSlave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(nSlave, TCSANOW, &tio);
+
+    fcntl(nMaster, F_SETFL, fcntl(nMaster, F_GETFL) | O_NONBLOCK);
+
+    tLast = secondsNow();
+    return true;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Small and repeatable. xorshift32, returns 0 to 1.
+double QuantumSimPty::nextRandom(void)
+{
+    nRandom ^= nRandom << 13;
+    nRandom ^= nRandom >> 17;
+    nRandom ^= nRandom << 5;
+    return double(nRandom) / 4294967296.0;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Line up a reply. Each byte is due one character time after the one before it,
+// and the first one is due after the latency. Dropped bytes never get in line.
+void QuantumSimPty::queueReply(const char* pReply, int nLength, double tNow)
+{
+    if(link.fReplyDropRate > 0.0 && nextRandom() < link.fReplyDropRate) {
+        nDropped += nLength;
+        return;
+        }
+
+    double tStart = tNow + (link.fLatency + link.fJitter * nextRandom()) / 1000.0;
+    double tByte = (link.nBaudRate > 0) ? 10.0 / double(link.nBaudRate) : 0.0;
+
+    // Don't start before the last reply is out
+    double tDue = tStart;
+    if(!output.empty() && output.back().tDue > tDue)
+        tDue = output.back().tDue;
+
+    for(int i = 0; i < nLength; i++) {
+        tDue += tByte;
+        if(link.fDropRate > 0.0 && nextRandom() < link.fDropRate) {
+            nDropped++;
+            continue;
+            }
+
+        PendingByte outByte = { tDue, pReply[i] };
+        output.push_back(outByte);
+        }
+}
+
+///////////////////////////////////////////////////////////////////////
+// A whole command line is in szLine
+void QuantumSimPty::commandReceived(double tNow)
+{
+    szLine[nLine] = 0x0;
+    nLine = 0;
+    nCommands++;
+
+    if(pfnCommandHook != nullptr)
+        pfnCommandHook(pHookContext, szLine, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now().time_since_epoch()).count());
+
+    char szReply[QUANTUM_SIM_MAX_REPLY];
+    int nLength = simulator.handleCommand(szLine, szReply, sizeof(szReply));
+
+    if(link.bVerbose) {
+        int nText = nLength;
+        while(nText > 0 && (szReply[nText-1] == '\r' || szReply[nText-1] == '\n'))
+            nText--;
+
+        if(nLength < 0)
+            fprintf(stderr, "%s -> (no reply)\n", szLine);
+        else
+            fprintf(stderr, "%s -> %.*s\n", szLine, nText, szReply);
+        }
+
+    if(nLength > 0) {
+        nReplies++;
+        queueReply(szReply, nLength, tNow);
+        }
+}
+
+///////////////////////////////////////////////////////////////////////
+void QuantumSimPty::service(int nMaxWait)
+{
+    double tNow = secondsNow();
+
+    // How long until something has to happen
+    int nWait = nMaxWait;
+    if(!output.empty()) {
+        double fUntil = (output.front().tDue - tNow) * 1000.0;
+        nWait = (fUntil <= 0.0) ? 0 : (fUntil < nWait ? int(fUntil) + 1 : nWait);
+        }
+
+    struct pollfd pfd = { nMaster, POLLIN, 0 };
+    if(poll(&pfd, 1, nWait) < 0 && errno != EINTR)
+        perror("poll");
+
+    tNow = secondsNow();
+    simulator.advance((tNow - tLast) * link.fSpeed);
+    tLast = tNow;
+
+    // Commands in
+    char chunk[256];
+    ssize_t nRead;
+    while((nRead = read(nMaster, chunk, sizeof(chunk))) > 0)
+        for(ssize_t i = 0; i < nRead; i++) {
+            char c = chunk[i];
+            if(c != '\n' && c != '\r') {
+                if(nLine < int(sizeof(szLine)) - 1)
+                    szLine[nLine++] = c;
+                continue;
+                }
+
+            if(nLine > 0)
+                commandReceived(tNow);
+            }
+
+    // Replies out, as they come due
+    char szOut[256];
+    int nOut = 0;
+    while(!output.empty() && output.front().tDue <= tNow && nOut < int(sizeof(szOut))) {
+        szOut[nOut++] = output.front().cByte;
+        output.pop_front();
+        }
+
+    if(nOut > 0) {
+        ssize_t nWritten = write(nMaster, szOut, size_t(nOut));
+        if(nWritten < 0)
+            nWritten = 0;
+
+        // Didn't all fit, put the rest back in line
+        for(int i = nOut - 1; i >= int(nWritten); i--) {
+            PendingByte outByte = { tNow, szOut[i] };
+            output.push_front(outByte);
+            }
+        }
+}
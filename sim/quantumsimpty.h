@@ -0,0 +1,114 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* The serial line side of the simulator. A pseudo terminal with a QuantumSimulator
+ * behind it. Commands are read as they come in, and replies go back out after the
+ * latency, paced to the baud rate, with bytes or whole replies lost if asked for.
+ *
+ * Nothing here runs on its own, call service() in a loop from whatever thread owns
+ * it. The simulator itself is only touched from there. Linux and macOS only.
+*/
+#ifndef QUANTUMSIMPTY_H
+#define QUANTUMSIMPTY_H
+
+#include <stdint.h>
+#include <deque>
+
+#include "quantumsimulator.h"
+
+// Model and housekeeping tick when nothing else is going on (milliseconds)
+#define QUANTUM_SIM_TICK        50
+
+/////////////////////////////////////////////////////////////
+/// How the line behaves
+struct QuantumSimLink {
+    double  fLatency = 5.0;         // Milliseconds before a reply starts
+    double  fJitter = 0.0;          // Plus up to this much
+    int     nBaudRate = 9600;       // 0 is as fast as we can
+    double  fDropRate = 0.0;        // Per byte
+    double  fReplyDropRate = 0.0;   // Per reply
+    double  fSpeed = 1.0;           // Model time per real time
+    uint32_t nSeed = 1;
+    bool    bVerbose = false;       // Every command and reply to stderr
+};
+
+// Called for every command as it arrives. The time is the steady clock in nanoseconds,
+// same as QuantumStatusSnapshot::nCaptureTime.
+typedef void (*QuantumSimCommandHook)(void* pContext, const char* szCommand, int64_t nArrivalTime);
+
+
+class QuantumSimPty
+{
+public:
+    QuantumSimPty(QuantumSimulator& simulator, const QuantumSimLink& link);
+    ~QuantumSimPty(void);
+
+    // Make the pty. False (and perror) if it can't be done.
+    bool open(void);
+
+    // Where clients connect. Good after open().
+    const char* getSlaveName(void) const { return szSlaveName; }
+
+    // Wait up to nMaxWait milliseconds for something to do, then do it
+    void service(int nMaxWait = QUANTUM_SIM_TICK);
+
+    // Not thread safe. Set it before service() runs on another thread, clear it after.
+    void setCommandHook(QuantumSimCommandHook pfnHook, void* pContext) {
+        pfnCommandHook = pfnHook;
+        pHookContext = pContext;
+    }
+
+    long getCommandCount(void) const { return nCommands; }
+    long getReplyCount(void) const { return nReplies; }
+    long getDroppedCount(void) const { return nDropped; }
+
+protected:
+    // A byte and when it is supposed to go out
+    struct PendingByte {
+        double  tDue;
+        char    cByte;
+    };
+
+    QuantumSimulator&       simulator;
+    QuantumSimLink          link;
+    int                     nMaster = -1;
+    int                     nSlave = -1;
+    char                    szSlaveName[128] = { 0 };
+    std::deque<PendingByte> output;
+    char                    szLine[64];
+    int                     nLine = 0;
+    uint32_t                nRandom = 1;
+    double                  tLast = 0.0;
+    long                    nCommands = 0;
+    long                    nReplies = 0;
+    long                    nDropped = 0;
+
+    QuantumSimCommandHook   pfnCommandHook = nullptr;
+    void                    *pHookContext = nullptr;
+
+    double nextRandom(void);
+    void   commandReceived(double tNow);
+    void   queueReply(const char* pReply, int nLength, double tNow);
+};
+
+#endif // QUANTUMSIMPTY_H
@@ -0,0 +1,230 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "quantumsimulator.h"
+
+// The second heater keeps the housing a little cooler than the etalon
+#define QUANTUM_SIM_HEATER2_OFFSET  -0.5
+
+// Integration steps are never longer than this (seconds)
+#define QUANTUM_SIM_MAX_STEP        0.05
+
+
+/////////////////////////////////////////////////////////////////////////////////////////
+QuantumSimulator::QuantumSimulator(const QuantumSimSettings& simSettings)
+{
+    settings = simSettings;
+
+    for(int i = 0; i < 2; i++) {
+        heaters[i].fTemperature = settings.fStartTemp;
+        heaters[i].fPower = 0.0;
+        }
+
+    heaters[0].fSetPoint = QUANTUM_SIM_DESIGN_TEMP;
+    heaters[1].fSetPoint = QUANTUM_SIM_DESIGN_TEMP + QUANTUM_SIM_HEATER2_OFFSET;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Feed forward (the power it takes to sit at the set point) plus a proportional term,
+// then let the lump respond: C dT/dt = P - (T - ambient)/R, with R*C the time constant
+// and P*R the rise at full power.
+void QuantumSimulator::stepHeater(QuantumSimHeater& heater, double fSeconds)
+{
+    double fHold = (heater.fSetPoint - settings.fAmbient) / QUANTUM_SIM_MAX_RISE;
+    double fPower = fHold + QUANTUM_SIM_GAIN * (heater.fSetPoint - heater.fTemperature);
+    if(fPower < 0.0) fPower = 0.0;
+    if(fPower > 1.0) fPower = 1.0;
+    heater.fPower = fPower;
+
+    double fEquilibrium = settings.fAmbient + fPower * QUANTUM_SIM_MAX_RISE;
+    heater.fTemperature += (fEquilibrium - heater.fTemperature) * (fSeconds / QUANTUM_SIM_TIME_CONSTANT);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+void QuantumSimulator::advance(double fSeconds)
+{
+    while(fSeconds > 0.0) {
+        double fStep = (fSeconds > QUANTUM_SIM_MAX_STEP) ? QUANTUM_SIM_MAX_STEP : fSeconds;
+        stepHeater(heaters[0], fStep);
+        if(settings.bDualHeaters)
+            stepHeater(heaters[1], fStep);
+        fSeconds -= fStep;
+        }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+double QuantumSimulator::getCenterWavelength(void) const
+{
+    return double(settings.nDesignWavelength) * 0.1 +
+            (heaters[0].fTemperature - QUANTUM_SIM_DESIGN_TEMP) * QUANTUM_SIM_TUNING;
+}
+
+double QuantumSimulator::getTargetWavelength(void) const
+{
+    return double(settings.nDesignWavelength + nWingshift) * 0.1;
+}
+
+bool QuantumSimulator::isOnBand(void) const
+{
+    return fabs(getCenterWavelength() - getTargetWavelength()) <= QUANTUM_SIM_ON_BAND;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Commands are two letters, maybe followed by a decimal value. Anything we don't know
+// gets an E, same as an SE that is out of range. GY (run time) never answers on a real
+// filter, so it doesn't here either.
+int QuantumSimulator::handleCommand(const char* szCommand, char* pReply, int nSize)
+{
+    if(strlen(szCommand) < 2)
+        return textReply("E", pReply, nSize);
+
+    char szMnemonic[3] = { szCommand[0], szCommand[1], 0x0 };
+    const char* szValue = szCommand + 2;
+
+    if(strcmp(szMnemonic, "GI") == 0)
+        return statusReply(pReply, nSize);
+
+    if(strcmp(szMnemonic, "GS") == 0)
+        return textReply(settings.szSerialNumber, pReply, nSize);
+
+    if(strcmp(szMnemonic, "GA") == 0)
+        return integerReply(settings.nBodyStyle, 2, pReply, nSize);
+
+    if(strcmp(szMnemonic, "GB") == 0)
+        return textReply(settings.szBandwidth, pReply, nSize);
+
+    if(strcmp(szMnemonic, "GN") == 0)
+        return textReply(settings.szModelName, pReply, nSize);
+
+    if(strcmp(szMnemonic, "GX") == 0)
+        return integerReply(settings.nDesignWavelength, 8, pReply, nSize);
+
+    if(strcmp(szMnemonic, "GY") == 0)
+        return -1;
+
+    if(strcmp(szMnemonic, "SE") == 0) {
+        char *pEnd = nullptr;
+        long nValue = strtol(szValue, &pEnd, 10);
+
+        // Has to fit in the signed byte the hex firmware reports it in
+        if(pEnd == szValue || *pEnd != 0x0 || nValue < -128 || nValue > 127)
+            return textReply("E", pReply, nSize);
+
+        nWingshift = int(nValue);
+        heaters[0].fSetPoint = QUANTUM_SIM_DESIGN_TEMP + double(nWingshift) * 0.1 / QUANTUM_SIM_TUNING;
+        heaters[1].fSetPoint = heaters[0].fSetPoint + QUANTUM_SIM_HEATER2_OFFSET;
+        return textReply("OK", pReply, nSize);
+        }
+
+    return textReply("E", pReply, nSize);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Same layout the parser expects, see quantumparser.h.
+// v2.00 00 01 0001005C 00 0026 039D 0000289F 00000488 00000000 00002EE0 00ED
+int QuantumSimulator::statusReply(char* pReply, int nSize)
+{
+    int32_t nWavelength = int32_t(lround(getCenterWavelength() * 10.0));
+    int32_t nPWM1 = int32_t(lround(heaters[0].fPower * QUANTUM_SIM_PWM_LIMIT));
+    int32_t nTemp1 = int32_t(lround(heaters[0].fTemperature * 100.0));
+    int32_t nPWM2 = int32_t(lround(heaters[1].fPower * QUANTUM_SIM_PWM_LIMIT));
+    int32_t nTemp2 = int32_t(lround(heaters[1].fTemperature * 100.0));
+
+    // The supply sags a little under load
+    double fLoad = heaters[0].fPower + (settings.bDualHeaters ? heaters[1].fPower : 0.0);
+    int32_t nVoltage = int32_t(lround((settings.fVoltage - 0.3 * fLoad) * 100.0));
+
+    int32_t nErrorCode = 0;
+    int32_t nOnBand = isOnBand() ? 1 : 0;
+    const int32_t nCalibration = 0;
+    const int32_t nUnknown1 = 12000;    // Always seen with these values, not used
+    const int32_t nUnknown2 = 237;
+
+    int nLength;
+    if(settings.bOldFirmware) {
+        if(settings.bDualHeaters)
+            nLength = snprintf(pReply, size_t(nSize), "v1.25 %d %d %d %d %d %d %d %d %d %d %d %d %d %d",
+                           nErrorCode, nOnBand, nWavelength, nWingshift, nPWM1, QUANTUM_SIM_PWM_LIMIT,
+                           nTemp1, nTemp2, nVoltage, nCalibration, nPWM2, QUANTUM_SIM_PWM_LIMIT,
+                           nUnknown1, nUnknown2);
+        else
+            nLength = snprintf(pReply, size_t(nSize), "v1.25 %d %d %d %d %d %d %d %d %d %d %d",
+                           nErrorCode, nOnBand, nWavelength, nWingshift, nPWM1, QUANTUM_SIM_PWM_LIMIT,
+                           nTemp1, nVoltage, nCalibration, nUnknown1, nUnknown2);
+        }
+    else {
+        // Wingshift goes out as a signed byte
+        unsigned int nShift = unsigned(nWingshift) & 0xff;
+        if(settings.bDualHeaters)
+            nLength = snprintf(pReply, size_t(nSize), "v2.00 %02X %02X %08X %02X %04X %04X %08X %08X %08X %08X %04X %04X %08X %04X",
+                           nErrorCode, nOnBand, nWavelength, nShift, nPWM1, QUANTUM_SIM_PWM_LIMIT,
+                           nTemp1, nTemp2, nVoltage, nCalibration, nPWM2, QUANTUM_SIM_PWM_LIMIT,
+                           nUnknown1, nUnknown2);
+        else
+            nLength = snprintf(pReply, size_t(nSize), "v2.00 %02X %02X %08X %02X %04X %04X %08X %08X %08X %08X %04X",
+                           nErrorCode, nOnBand, nWavelength, nShift, nPWM1, QUANTUM_SIM_PWM_LIMIT,
+                           nTemp1, nVoltage, nCalibration, nUnknown1, nUnknown2);
+        }
+
+    return finishReply(nLength, pReply, nSize);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+// Decimal on old firmware, fixed width hex on new
+int QuantumSimulator::integerReply(int32_t nValue, int nHexWidth, char* pReply, int nSize)
+{
+    int nLength;
+    if(settings.bOldFirmware)
+        nLength = snprintf(pReply, size_t(nSize), "%d", nValue);
+    else
+        nLength = snprintf(pReply, size_t(nSize), "%0*X", nHexWidth, unsigned(nValue));
+
+    return finishReply(nLength, pReply, nSize);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+int QuantumSimulator::textReply(const char* szText, char* pReply, int nSize)
+{
+    return finishReply(snprintf(pReply, size_t(nSize), "%s", szText), pReply, nSize);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+int QuantumSimulator::finishReply(int nLength, char* pReply, int nSize)
+{
+    if(nLength < 0 || nLength + 2 >= nSize)
+        return -1;
+
+    if(bTerminator) {
+        pReply[nLength++] = '\r';
+        pReply[nLength++] = '\n';
+        pReply[nLength] = 0x0;
+        }
+
+    return nLength;
+}
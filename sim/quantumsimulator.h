@@ -0,0 +1,115 @@
+/*MIT License
+
+Copyright (c) 2021 Starstone Software Systems, Inc.
+Copyright (c) 2021 Richard S. Wright Jr.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE
+*/
+/* A pretend Quantum. This speaks the same serial protocol as the real filter (GI, GS, GA,
+ * GB, GN, GX and SE), for either the old decimal firmware or the newer hex firmware, with
+ * one or two heaters. Behind it is a simple thermal model, so the heater warms up, the
+ * center wavelength drifts toward whatever SE asked for, and the filter goes on band
+ * when it gets there, just like the real thing (only as fast as you like).
+ *
+ * The model:
+ *   The etalon tunes at QUANTUM_SIM_TUNING Angstroms per degree C, and sits on its design
+ *   wavelength at QUANTUM_SIM_DESIGN_TEMP. A wingshift moves the heater set point by
+ *   wingshift / tuning degrees.
+ *   Each heater is a lump with a heat capacity, losing heat to the air through a thermal
+ *   resistance. Full power holds it QUANTUM_SIM_MAX_RISE degrees above ambient, and it
+ *   gets 63% of the way there in QUANTUM_SIM_TIME_CONSTANT seconds.
+ *   The firmware drives the heater with the power it needs at the set point, plus a
+ *   proportional term, limited to the PWM limit.
+ *
+ * This has nothing to do with the serial port, see quantumsim.cpp for that. No Qt either.
+*/
+#ifndef QUANTUMSIMULATOR_H
+#define QUANTUMSIMULATOR_H
+
+#include <stdint.h>
+
+#define QUANTUM_SIM_TUNING          0.1     // Angstroms per degree C
+#define QUANTUM_SIM_DESIGN_TEMP     104.0   // Degrees C, on the design wavelength
+#define QUANTUM_SIM_MAX_RISE        130.0   // Degrees C above ambient at full power
+#define QUANTUM_SIM_TIME_CONSTANT   240.0   // Seconds
+#define QUANTUM_SIM_GAIN            0.25    // Proportional gain, power fraction per degree C
+#define QUANTUM_SIM_ON_BAND         0.05    // Within this many Angstroms is on band
+#define QUANTUM_SIM_PWM_LIMIT       925     // Same as a real filter reports
+#define QUANTUM_SIM_MAX_REPLY       128
+
+/////////////////////////////////////////////////////////////
+/// What kind of Quantum to be
+struct QuantumSimSettings {
+    bool    bOldFirmware = false;       // v1.25, decimal fields. Otherwise v2.00, hex.
+    bool    bDualHeaters = false;
+    double  fAmbient = 20.0;            // Degrees C
+    double  fStartTemp = 20.0;          // Heater temperature at power up
+    double  fVoltage = 11.60;           // Supply voltage, no load
+    int     nDesignWavelength = 65628;  // Tenths of an Angstrom (H-alpha)
+    const char* szSerialNumber = "Q1E12345";
+    const char* szModelName = "SolarQuantum";
+    const char* szBandwidth = "0.5";
+    int     nBodyStyle = 1;
+};
+
+/////////////////////////////////////////////////////////////
+/// One heater and what it is heating
+struct QuantumSimHeater {
+    double  fTemperature;       // Degrees C
+    double  fSetPoint;          // Where the firmware wants it
+    double  fPower;             // 0 to 1 of full power
+};
+
+
+class QuantumSimulator
+{
+public:
+    explicit QuantumSimulator(const QuantumSimSettings& settings);
+
+    // Let this much time go by (seconds)
+    void advance(double fSeconds);
+
+    // One command line, without the newline. The reply (with terminator) goes in pReply.
+    // Returns its length, or -1 if the command gets no reply at all.
+    int handleCommand(const char* szCommand, char* pReply, int nSize);
+
+    // For the curious (tests and such)
+    double getCenterWavelength(void) const;     // Angstroms
+    double getTargetWavelength(void) const;     // Angstroms
+    bool   isOnBand(void) const;
+    int    getWingshift(void) const { return nWingshift; }
+    const QuantumSimHeater& getHeater(int nHeater) const { return heaters[nHeater]; }
+
+    // Drop the terminator from replies, like some firmware does
+    void setTerminator(bool bTerminate) { bTerminator = bTerminate; }
+
+protected:
+    QuantumSimSettings  settings;
+    QuantumSimHeater    heaters[2];
+    int                 nWingshift = 0;         // Tenths of an Angstrom
+    bool                bTerminator = true;
+
+    void stepHeater(QuantumSimHeater& heater, double fSeconds);
+    int  statusReply(char* pReply, int nSize);
+    int  integerReply(int32_t nValue, int nHexWidth, char* pReply, int nSize);
+    int  textReply(const char* szText, char* pReply, int nSize);
+    int  finishReply(int nLength, char* pReply, int nSize);
+};
+
+#endif // QUANTUMSIMULATOR_H
@@ -24,88 +24,307 @@ SOFTWARE
 
 
 #include "wavelengthgraph.h"
+#include "quantumtrace.h"
 #include <QPainter>
 #include <QPen>
 #include <QColor>
 #include <QFont>
 #include <QFontMetrics>
+#include <QGuiApplication>
+#include <QScreen>
+#include <chrono>
 
+// Room past the right edge of the strip for the last label
+#define STRIP_LABEL_ROOM    32
 
-WavelengthGraph::WavelengthGraph(QWidget *parent) : QWidget(parent)
+
+WavelengthGraph::WavelengthGraph(QWidget *parent) : QWidget(parent),
+    fontGraph("Helvetica", 16), fontGraphBold("Helvetica", 18, QFont::Black)
 {
+    bandBrushes[0] = QBrush(QColor(32, 198, 32, 255));     // On band
+    bandBrushes[1] = QBrush(QColor(198, 32,32, 255));      // Warming
+    bandBrushes[2] = QBrush(QColor(32, 32, 198, 255));     // Cooling
 
+    animationTimer.setTimerType(Qt::PreciseTimer);
+    connect(&animationTimer, SIGNAL(timeout()), this, SLOT(animationStep()));
 }
 
+// Same clock as the status capture times
+static int64_t graphNow(void)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
-void WavelengthGraph::paintEvent(QPaintEvent *event)
+////////////////////////////////////////////////////////////////////
+/// A frame each time the screen refreshes, while there is motion
+void WavelengthGraph::setAnimated(bool bAnimate)
 {
-    event->accept();
+    bAnimated = bAnimate;
+
+    if(!bAnimated) {
+        animationTimer.stop();
+        refresh();                          // Back onto whole ticks
+        return;
+        }
 
-    QBrush redBrush(QColor(198, 32,32, 255));
-    QBrush greenBrush(QColor(32, 198, 32, 255));
-    QBrush blueBrush(QColor(32, 32, 198, 255));
+    qreal rate = 60.0;
+    QScreen *pScreen = QGuiApplication::primaryScreen();
+    if(pScreen != nullptr && pScreen->refreshRate() > 1.0)
+        rate = pScreen->refreshRate();
+    animationTimer.setInterval(qMax(4, int(1000.0 / rate)));
 
-    QPainter painter(this);
+    if(isVisible())
+        animationTimer.start();
+}
+
+////////////////////////////////////////////////////////////////////
+/// A new sample. Whatever is on screen now becomes the start of an ease
+/// onto where the new sample says to be.
+void WavelengthGraph::AddSample(int64_t nCaptureTime, float fWavelength, float fRate)
+{
+    if(nCaptureTime <= nSampleTime)
+        return;
+
+    int64_t nNow = graphNow();
+    float fShown = shownWavelength(nNow);
+    bool bHadSample = (nSampleTime != 0);
+
+    nSampleTime = nCaptureTime;
+    fSampleWavelength = fWavelength;
+    fDriftRate = bOnBand ? 0.0f : fRate;        // Holding, whatever the noise says
+
+    // A big jump is a jump, not something to slide across
+    fCorrection = 0.0f;
+    nCorrectionTime = nNow;
+    if(bHadSample) {
+        float fOffset = fShown - shownWavelength(nNow);
+        if(fabs(fOffset) < GRAPH_DRIFT_REACH)
+            fCorrection = fOffset;
+        }
+
+    if(bAnimated && isVisible() && !animationTimer.isActive())
+        animationTimer.start();
+}
+
+////////////////////////////////////////////////////////////////////
+/// Where the filter probably is now: the last sample run on at the drift
+/// rate, not past the target, not too far or for too long, plus what's left
+/// of the ease from where it was shown before.
+float WavelengthGraph::shownWavelength(int64_t nNow, bool *pMoving) const
+{
+    if(nSampleTime == 0) {
+        if(pMoving) *pMoving = false;
+        return fCurrentWavelength;
+        }
+
+    bool bMoving = false;
+    double dt = double(nNow - nSampleTime) / 1.0e9;
+    if(dt < 0.0)
+        dt = 0.0;
+    if(dt < GRAPH_DRIFT_HORIZON && fDriftRate != 0.0f)
+        bMoving = true;
+    else
+        dt = qMin(dt, GRAPH_DRIFT_HORIZON);
+
+    float fRun = float(fDriftRate * dt);
+    if(fRun > GRAPH_DRIFT_REACH) {
+        fRun = GRAPH_DRIFT_REACH;
+        bMoving = false;
+        }
+    else if(fRun < -GRAPH_DRIFT_REACH) {
+        fRun = -GRAPH_DRIFT_REACH;
+        bMoving = false;
+        }
+
+    float fWavelength = fSampleWavelength + fRun;
+
+    // Heading for the target, stop there
+    if(fDriftRate > 0.0f && fSampleWavelength <= fTargetWavelength && fWavelength > fTargetWavelength) {
+        fWavelength = fTargetWavelength;
+        bMoving = false;
+        }
+    else if(fDriftRate < 0.0f && fSampleWavelength >= fTargetWavelength && fWavelength < fTargetWavelength) {
+        fWavelength = fTargetWavelength;
+        bMoving = false;
+        }
+
+    double easeTime = double(nNow - nCorrectionTime) / 1.0e9;
+    if(fCorrection != 0.0f && easeTime < GRAPH_EASE_TIME * 5.0) {
+        fWavelength += float(fCorrection * exp(-qMax(0.0, easeTime) / GRAPH_EASE_TIME));
+        bMoving = true;
+        }
+
+    if(pMoving) *pMoving = bMoving;
+    return fWavelength;
+}
+
+////////////////////////////////////////////////////////////////////
+/// One frame. Paints only if the strip lands on a different pixel, and
+/// stops once nothing is moving. The next sample starts it again.
+void WavelengthGraph::animationStep(void)
+{
+    if(!isVisible() || window()->isMinimized()) {
+        animationTimer.stop();
+        return;
+        }
+
+    bool bMoving;
+    shownWavelength(graphNow(), &bMoving);
+    refresh();
+
+    if(!bMoving)
+        animationTimer.stop();
+}
+
+void WavelengthGraph::showEvent(QShowEvent *event)
+{
+    if(bAnimated)
+        animationTimer.start();
+    QWidget::showEvent(event);
+}
+
+void WavelengthGraph::hideEvent(QHideEvent *event)
+{
+    animationTimer.stop();
+    QWidget::hideEvent(event);
+}
+
+////////////////////////////////////////////////////////////////////
+// Boil the inputs down to what actually shows. Without animation the wavelength only
+// moves the ticks in whole tenths, with it down to the device pixel. The wingshift
+// isn't drawn at all.
+WavelengthGraph::GraphState WavelengthGraph::currentState(qreal ratio) const
+{
+    GraphState state;
+    state.nWidth = width();
+    state.nHeight = height();
+    state.fDesign = fDesignWavelength;
+    state.nTargetTick = -1;
 
-    painter.setPen(QPen(QColor(198,198,198,255)));
-    
-    QFont fontGraph("Helvetica", 16);
-    QFont fontGraphBold("Helvetica", 18, QFont::Black);
-    
-    painter.setFont(fontGraph);
-    
     if(bOnBand)
-        painter.setBrush(greenBrush);
+        state.nBrush = 0;
+    else if(fTargetWavelength > fCurrentWavelength)  // Backwards physics, but matches buttons
+        state.nBrush = 1;                            // on the Quantum
     else
-        {
-        if(fTargetWavelength > fCurrentWavelength) // Backwards physics, but matches buttons
-                                                   // on the Quantum
-            painter.setBrush(redBrush);
-        else
-            painter.setBrush(blueBrush);
+        state.nBrush = 2;
+
+    int nMargins = 10;
+    int nDivisions = (state.nWidth - (nMargins * 2)) / 20;
+
+    if(bAnimated) {
+        double ticks = double(shownWavelength(graphNow()) - fDesignWavelength) * -10.0;
+        state.nOffset = int(lround(ticks * nDivisions * ratio));
         }
+    else
+        state.nOffset = int(lround(int((fCurrentWavelength - fDesignWavelength) * -10.0) * nDivisions * ratio));
 
-    QRect rect = geometry();
-    painter.drawRect(rect);
+    // Same walk as buildStrip(), so the same label comes out bold
+    if(nDivisions > 0) {
+        float fStart = fDesignWavelength - 1.0f;
+        int nTick = 0;
+        for(int i = nMargins+5; i < state.nWidth; i += nDivisions, nTick++) {
+            if(fabs(fStart - fTargetWavelength) < 0.01) {
+                state.nTargetTick = nTick;
+                break;
+                }
+            fStart += 0.1f;
+            }
+        }
+
+    return state;
+}
+
+////////////////////////////////////////////////////////////////////
+void WavelengthGraph::refresh(void)
+{
+    if(currentState(devicePixelRatioF()) != paintedState)
+        update();
+}
+
+////////////////////////////////////////////////////////////////////
+// Tick marks and labels, unshifted, on a transparent pixmap at the screen's density
+void WavelengthGraph::buildStrip(const GraphState& state, qreal ratio)
+{
+    QUANTUM_TRACE_SCOPE("WavelengthGraph::buildStrip");
+
+    stripPixmap = QPixmap(int((state.nWidth + STRIP_LABEL_ROOM) * ratio), int(state.nHeight * ratio));
+    stripPixmap.setDevicePixelRatio(ratio);
+    stripPixmap.fill(Qt::transparent);
+    stripState = state;
+    stripRatio = ratio;
+
+    QPainter painter(&stripPixmap);
+    painter.setPen(QPen(QColor(198,198,198,255)));
+    painter.setFont(fontGraph);
 
-    int nWidth = width();
-    int nHeight = height();
     int nMargins = 10;
-    int nDivisions = (nWidth - (nMargins * 2)) / 20;
+    int nDivisions = (state.nWidth - (nMargins * 2)) / 20;
+    if(nDivisions <= 0)
+        return;
 
-    // Draw tick marks
-//    float fTarget = (onBand) ? fTargetWavelength : fCurrentWavelength;
-    int nTickSpace = int((fCurrentWavelength - fDesignWavelength) * -10.0) * nDivisions;
     float fStart = fDesignWavelength - 1.0f;
-    for(int i= nMargins+5; i < nWidth; i+= nDivisions) {
-        painter.drawLine(i + nTickSpace, 10, i + nTickSpace, 30);
+    int nTick = 0;
+    for(int i= nMargins+5; i < state.nWidth; i+= nDivisions, nTick++) {
+        painter.drawLine(i, 10, i, 30);
 
         QTransform t;
-        t.translate(i + nTickSpace, 25);
+        t.translate(i, 25);
         t.rotate(90.0f);
         painter.save();
         painter.setTransform(t);
         QString out = QString::asprintf("%.1f", fStart);
         out += angstromSymbol;
-        
-        if(fabs(fStart - fTargetWavelength) < 0.01) {
+
+        if(nTick == state.nTargetTick) {
             painter.setPen(QPen(QColor(255,255,255,255)));
-            painter.setFont(fontGraphBold);            
+            painter.setFont(fontGraphBold);
             painter.drawText(-10, -2, out);
             painter.setFont(fontGraph);
             painter.setPen(QPen(QColor(198,198,198,255)));
-
             }
-        else 
+        else
             painter.drawText(-5, -2, out);
-        
+
         fStart += 0.1f;
         painter.restore();
     }
+}
+
+
+void WavelengthGraph::paintEvent(QPaintEvent *event)
+{
+    QUANTUM_TRACE_SCOPE("WavelengthGraph::paintEvent");
+
+    event->accept();
+
+    QPainter painter(this);
+    draw(painter, painter.device()->devicePixelRatioF());
+}
+
+////////////////////////////////////////////////////////////////////
+// Background, the strip slid to where the filter is, and the center line
+void WavelengthGraph::draw(QPainter& painter, qreal ratio)
+{
+    GraphState state = currentState(ratio);
+
+    painter.setPen(QPen(QColor(198,198,198,255)));
+    painter.setBrush(bandBrushes[state.nBrush]);
+
+    QRect rect = geometry();
+    painter.drawRect(rect);
+
+    int nWidth = state.nWidth;
+    int nHeight = state.nHeight;
+
+    // Ticks only need drawing again if they would come out different
+    if(stripState.fDesign != state.fDesign || stripState.nWidth != nWidth || stripState.nHeight != nHeight ||
+            stripState.nTargetTick != state.nTargetTick || stripRatio != ratio)
+        buildStrip(state, ratio);
+
+    painter.drawPixmap(QPointF(state.nOffset / ratio, 0.0), stripPixmap);
 
-    painter.setPen(QPen(QColor(255,255,255,255)));
-    painter.drawLine(nWidth / 2, 0, nWidth/2, nHeight-25);
-    painter.drawLine((nWidth / 2)-1, 0, (nWidth/2)-1, nHeight-25);
-    painter.drawLine((nWidth / 2)-2, 0, (nWidth/2)-2, nHeight-25);
+    painter.fillRect(QRect((nWidth / 2) - 2, 0, 3, nHeight - 24), QColor(255,255,255,255));
 
+    paintedState = state;
 }
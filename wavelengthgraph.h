@@ -22,6 +22,16 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE
 
 This class draws the wavelength graph.
+
+The tick marks and their labels only change when the design wavelength, the target,
+the size or the pixel density do, so they are drawn once into a pixmap and that is
+slid left and right as the filter moves. Nothing is repainted at all unless something
+that shows has changed, see refresh().
+
+Samples come in a second or more apart, so with animation on the strip also moves
+between them, a frame at a time, at the drift rate the device works out (see
+quantumdrift.h). It eases onto each new sample rather than jumping, and the frame
+timer only runs while the graph is on screen and something is actually moving.
 */
 
 #ifndef WAVELENGTHGRAPH_H
@@ -29,7 +39,19 @@ This class draws the wavelength graph.
 
 #include <QWidget>
 #include <QPaintEvent>
+#include <QPixmap>
+#include <QBrush>
+#include <QFont>
+#include <QPainter>
+#include <QTimer>
+#include <QShowEvent>
+#include <QHideEvent>
 #include <math.h>
+#include <stdint.h>
+
+#define GRAPH_DRIFT_HORIZON     5.0         // Don't run on past the last sample longer than this
+#define GRAPH_DRIFT_REACH       0.2f        // or further than this, Angstroms
+#define GRAPH_EASE_TIME         0.2         // Seconds to ease onto a new sample
 
 class WavelengthGraph : public QWidget
 {
@@ -43,18 +65,76 @@ public:
     inline void SetOnBand(bool bStatus)                { bOnBand = bStatus; }
     inline void SetTargetWavelength(float fTarget)     { fTargetWavelength = fTarget; }
 
+    // Call after setting things. Repaints only if it would look any different.
+    void refresh(void);
+
+    // Smooth motion between samples. Give it every sample, with when it was taken
+    // (steady clock, nanoseconds, as in QuantumStatusSnapshot) and the drift rate
+    // in Angstroms per second. Repeats are ignored.
+    void setAnimated(bool bAnimate);
+    bool isAnimated(void) const { return bAnimated; }
+    void AddSample(int64_t nCaptureTime, float fWavelength, float fRate);
+
 protected:
-    float   fDesignWavelength;      // Center wavelength as designed
-    float   fCurrentWavelength;     // Current wavelength
-    float   fWingshift;             // Current wingshift
-    float   fTargetWavelength;      // Current target
-    bool    bOnBand;                // Are you on band?
+    float   fDesignWavelength = 0.0f;       // Center wavelength as designed
+    float   fCurrentWavelength = 0.0f;      // Current wavelength
+    float   fWingshift = 0.0f;              // Current wingshift
+    float   fTargetWavelength = 0.0f;       // Current target
+    bool    bOnBand = false;                // Are you on band?
 
     // Angstrom Symbol
     const unsigned char angstromEncode[4] = { 0xe2, 0x84, 0xab, 0x0 };
     const QString angstromSymbol = QString().fromUtf8((const char *)angstromEncode);
 
+    // Everything that decides what the graph looks like
+    struct GraphState {
+        int     nBrush;                     // 0 on band, 1 warming, 2 cooling
+        int     nOffset;                    // Where the strip goes, in device pixels
+        int     nTargetTick;                // Which label is bold, -1 for none
+        float   fDesign;
+        int     nWidth;
+        int     nHeight;
+
+        bool operator==(const GraphState& other) const {
+            return nBrush == other.nBrush && nOffset == other.nOffset && nTargetTick == other.nTargetTick &&
+                   fDesign == other.fDesign && nWidth == other.nWidth && nHeight == other.nHeight;
+        }
+        bool operator!=(const GraphState& other) const { return !(*this == other); }
+    };
+
+    GraphState  paintedState = { -1, 0, -1, 0.0f, 0, 0 };
+
+    // The tick strip, and what it was drawn for
+    QPixmap     stripPixmap;
+    GraphState  stripState = { -1, 0, -1, 0.0f, 0, 0 };
+    qreal       stripRatio = 0.0;
+
+    // Made once, not every paint
+    QBrush      bandBrushes[3];
+    QFont       fontGraph;
+    QFont       fontGraphBold;
+
+    // Animation
+    bool        bAnimated = false;
+    QTimer      animationTimer;
+    float       fDriftRate = 0.0f;              // Angstroms per second
+    int64_t     nSampleTime = 0;                // Newest sample, and when it was taken, 0 for none yet
+    float       fSampleWavelength = 0.0f;
+    float       fCorrection = 0.0f;             // Shown less sampled when it came in, eased out
+    int64_t     nCorrectionTime = 0;
+
+    float shownWavelength(int64_t nNow, bool *pMoving = nullptr) const;
+
+    GraphState currentState(qreal ratio) const;
+    void buildStrip(const GraphState& state, qreal ratio);
+    void draw(QPainter& painter, qreal ratio);
+
     virtual void	paintEvent(QPaintEvent *event);
+    virtual void    showEvent(QShowEvent *event);
+    virtual void    hideEvent(QHideEvent *event);
+
+protected Q_SLOTS:
+    void animationStep(void);
 
 signals:
 